@@ -0,0 +1,523 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include "CompactScene.hpp"
+
+#if !defined(SCENE_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SCENE_COMPACT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+  const unsigned int kMaxBlockSize    = 64;
+  const float        kQuantizeMax     = 65535.0f;
+  const float        kRotationMax     = 1023.0f;
+  const float        kSqrtHalf        = 0.70710678f;
+  const float        kDegToRad        = 3.14159265358979f / 180.0f;
+  const float        kRadToDeg        = 180.0f / 3.14159265358979f;
+  const unsigned int kNoName          = 0xFFFFFFFF;
+  // 2^112, which moves a half's exponent bias to a float's when multiplied in.
+  const unsigned int kHalfToFloatBits = (254 - 15) << 23;
+
+  unsigned int floatBits( float value ) {
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  float bitsFloat( unsigned int bits ) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // Rounds to the nearest half, ties to even.  Too large becomes infinity, and NaN stays NaN.
+  unsigned short floatToHalf( float value ) {
+    const unsigned int denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+    unsigned int       bits        = floatBits(value);
+    const unsigned int sign        = bits & 0x80000000u;
+    bits ^= sign;
+
+    unsigned int half = 0;
+    if( bits >= ((127 + 16) << 23) ) {
+      half = (bits > (255u << 23)) ? 0x7E00 : 0x7C00;
+    } else if( bits < (113u << 23) ) {
+      // Too small for a normal half, so let float addition round the denormal.
+      half = floatBits(bitsFloat(bits) + bitsFloat(denormMagic)) - denormMagic;
+    } else {
+      const unsigned int odd = (bits >> 13) & 1;
+      bits += ((15u - 127u) << 23) + 0xFFF;
+      bits += odd;
+      half  = bits >> 13;
+    }
+    return static_cast<unsigned short>(half | (sign >> 16));
+  }
+
+  float halfToFloat( unsigned short half ) {
+    const unsigned int rest   = half & 0x7FFF;
+    float              value  = bitsFloat(rest << 13) * bitsFloat(kHalfToFloatBits);
+    unsigned int       bits   = floatBits(value) | ((half & 0x8000u) << 16);
+    if( rest > 0x7BFF ) {
+      bits |= 255u << 23;
+    }
+    return bitsFloat(bits);
+  }
+
+  // Ward's shared exponent encoding, but rounding to nearest so that zero stays zero.  Negative components become zero.
+  unsigned int encodeRgbe( const Scene::Vector& color ) {
+    const float r   = std::max(color.x, 0.0f);
+    const float g   = std::max(color.y, 0.0f);
+    const float b   = std::max(color.z, 0.0f);
+    const float max = std::max(r, std::max(g, b));
+    if( max < 1e-32f ) {
+      return 0;
+    }
+    int         exponent = 0;
+    const float scale    = frexpf(max, &exponent) * 256.0f / max;
+    const unsigned int red   = std::min(static_cast<unsigned int>(r * scale + 0.5f), 255u);
+    const unsigned int green = std::min(static_cast<unsigned int>(g * scale + 0.5f), 255u);
+    const unsigned int blue  = std::min(static_cast<unsigned int>(b * scale + 0.5f), 255u);
+    return red | (green << 8) | (blue << 16) | (static_cast<unsigned int>(exponent + 128) << 24);
+  }
+
+  Scene::Vector decodeRgbe( unsigned int rgbe ) {
+    const unsigned int exponent = rgbe >> 24;
+    if( exponent == 0 ) {
+      return Scene::Vector(0.0f);
+    }
+    const float scale = ldexpf(1.0f, static_cast<int>(exponent) - (128 + 8));
+    return Scene::Vector(static_cast<float>(rgbe & 0xFF) * scale, static_cast<float>((rgbe >> 8) & 0xFF) * scale, static_cast<float>((rgbe >> 16) & 0xFF) * scale);
+  }
+
+  unsigned int unorm8( float value ) {
+    return static_cast<unsigned int>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+  }
+
+  // The quaternion of Rz * Ry * Rx, matching SceneHierarchy::fromObject(), as x, y, z, w.
+  void eulerToQuaternion( const Scene::Vector& degrees, float* out ) {
+    const float cx = cosf(degrees.x * kDegToRad * 0.5f);
+    const float sx = sinf(degrees.x * kDegToRad * 0.5f);
+    const float cy = cosf(degrees.y * kDegToRad * 0.5f);
+    const float sy = sinf(degrees.y * kDegToRad * 0.5f);
+    const float cz = cosf(degrees.z * kDegToRad * 0.5f);
+    const float sz = sinf(degrees.z * kDegToRad * 0.5f);
+    out[0] = sx * cy * cz - cx * sy * sz;
+    out[1] = cx * sy * cz + sx * cy * sz;
+    out[2] = cx * cy * sz - sx * sy * cz;
+    out[3] = cx * cy * cz + sx * sy * sz;
+  }
+
+  // Goes through the rotation matrix, taking z first and then x from the columns that z leaves well conditioned, so
+  // that the angles still rebuild the same rotation when looking nearly straight up or down.
+  Scene::Vector quaternionToEuler( const float* q ) {
+    const float m0 = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+    const float m1 = 2.0f * (q[0] * q[1] + q[3] * q[2]);
+    const float m2 = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+    const float m3 = 2.0f * (q[0] * q[1] - q[3] * q[2]);
+    const float m4 = 1.0f - 2.0f * (q[0] * q[0] + q[2] * q[2]);
+    const float m6 = 2.0f * (q[0] * q[2] + q[3] * q[1]);
+    const float m7 = 2.0f * (q[1] * q[2] - q[3] * q[0]);
+    const float z  = atan2f(m1, m0);
+    const float cz = cosf(z);
+    const float sz = sinf(z);
+    return Scene::Vector(atan2f(sz * m6 - cz * m7, cz * m4 - sz * m3) * kRadToDeg, atan2f(-m2, cz * m0 + sz * m1) * kRadToDeg, z * kRadToDeg);
+  }
+
+  // The index of the largest component in the top two bits, then the other three in 10 bits each, in order.  The
+  // largest is made positive, as q and -q are the same rotation, and is rebuilt from the others when decoding.
+  unsigned int encodeRotation( const Scene::Vector& degrees ) {
+    float q[4];
+    eulerToQuaternion(degrees, q);
+    unsigned int largest = 0;
+    for( unsigned int i = 1; i < 4; ++i ) {
+      largest = (fabsf(q[i]) > fabsf(q[largest])) ? i : largest;
+    }
+    const float  sign   = (q[largest] < 0.0f) ? -1.0f : 1.0f;
+    unsigned int packed = largest << 30;
+    unsigned int shift  = 20;
+    for( unsigned int i = 0; i < 4; ++i ) {
+      if( i == largest ) {
+        continue;
+      }
+      const float unit = std::min(std::max(q[i] * sign / kSqrtHalf * 0.5f + 0.5f, 0.0f), 1.0f);
+      packed |= static_cast<unsigned int>(unit * kRotationMax + 0.5f) << shift;
+      shift  -= 10;
+    }
+    return packed;
+  }
+
+  // Written the same way as the SSE2 path in CompactScene::decode(), so that both give the same bits.
+  float unpackRotation( unsigned int bits ) {
+    return static_cast<float>(bits & 0x3FF) * (2.0f / kRotationMax * kSqrtHalf) + -kSqrtHalf;
+  }
+
+  // Writes the quaternion into four arrays stride floats apart.
+  void decodeRotation( unsigned int packed, float* out, unsigned int stride ) {
+    const unsigned int largest = packed >> 30;
+    const float        a       = unpackRotation(packed >> 20);
+    const float        b       = unpackRotation(packed >> 10);
+    const float        c       = unpackRotation(packed);
+    const float        w       = sqrtf(std::max(1.0f - (a * a + (b * b + c * c)), 0.0f));
+    const float        rest[3] = { a, b, c };
+    for( unsigned int i = 0; i < 4; ++i ) {
+      out[i * stride] = (i == largest) ? w : rest[(i > largest) ? i - 1 : i];
+    }
+  }
+
+  unsigned int internName( const std::string& name, std::unordered_map<std::string, unsigned int>* ids, std::vector<char>* data, std::vector<unsigned int>* starts ) {
+    const std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> result = ids->insert(std::make_pair(name, static_cast<unsigned int>(starts->size() - 1)));
+    if( result.second ) {
+      data->insert(data->end(), name.begin(), name.end());
+      starts->push_back(data->size());
+    }
+    return result.first->second;
+  }
+
+#ifdef SCENE_COMPACT_SSE2
+  // Four halves, one in the low 16 bits of each lane, to floats.  The same steps as halfToFloat().
+  __m128 halvesToFloats( __m128i halves ) {
+    const __m128i rest    = _mm_and_si128(halves, _mm_set1_epi32(0x7FFF));
+    const __m128i sign    = _mm_slli_epi32(_mm_xor_si128(halves, rest), 16);
+    const __m128  scaled  = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(rest, 13)), _mm_castsi128_ps(_mm_set1_epi32(kHalfToFloatBits)));
+    const __m128i special = _mm_and_si128(_mm_cmpgt_epi32(rest, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(255 << 23));
+    return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, special)));
+  }
+
+  __m128i loadShorts( const unsigned short* in ) {
+    return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)), _mm_setzero_si128());
+  }
+#endif
+}
+
+CompactScene::CompactScene()
+  : _hasNames(false) {
+}
+
+CompactScene::~CompactScene() {
+}
+
+void CompactScene::encode( const Scene& scene, const Options& options ) {
+  const std::vector<Scene::Object>&   objects   = scene.objects();
+  const std::vector<Scene::Material>& materials = scene.materials();
+  const std::vector<Scene::Light>&    lights    = scene.lights();
+
+  _hasNames = options.names == kNameModeTable;
+  _nameData.clear();
+  _nameStarts.assign(1, 0);
+  std::unordered_map<std::string, unsigned int> nameIds;
+
+  encodePositions(objects, options.positionError);
+  _rotations.resize(objects.size());
+  for( unsigned int axis = 0; axis < 3; ++axis ) {
+    _scales[axis].resize(objects.size());
+  }
+  _meshes.resize(objects.size());
+  _materials.resize(objects.size());
+  _parents.resize(objects.size());
+  _objectNames.assign(_hasNames ? objects.size() : 0, kNoName);
+  for( unsigned int i = 0; i < objects.size(); ++i ) {
+    const Scene::Object& object = objects[i];
+    _rotations[i] = encodeRotation(object.orientation);
+    _scales[0][i] = floatToHalf(object.scale.x);
+    _scales[1][i] = floatToHalf(object.scale.y);
+    _scales[2][i] = floatToHalf(object.scale.z);
+    _meshes[i]    = object.mesh;
+    _materials[i] = object.material;
+    _parents[i]   = object.parent;
+    if( _hasNames ) {
+      _objectNames[i] = internName(object.name, &nameIds, &_nameData, &_nameStarts);
+    }
+  }
+
+  _materialRecords.resize(materials.size());
+  _materialNames.assign(_hasNames ? materials.size() : 0, kNoName);
+  for( unsigned int i = 0; i < materials.size(); ++i ) {
+    const Scene::Material& in  = materials[i];
+    CompactMaterial&       out = _materialRecords[i];
+    out.color      = unorm8(in.color.x) | (unorm8(in.color.y) << 8) | (unorm8(in.color.z) << 16) | (255u << 24);
+    out.specSize   = floatToHalf(in.specSize);
+    out.diffuseTex = in.diffuseTex;
+    out.normalTex  = in.normalTex;
+    if( _hasNames ) {
+      _materialNames[i] = internName(in.name, &nameIds, &_nameData, &_nameStarts);
+    }
+  }
+
+  _lights.resize(lights.size());
+  for( unsigned int i = 0; i < lights.size(); ++i ) {
+    const Scene::Light& in  = lights[i];
+    CompactLight&       out = _lights[i];
+    out.position[0]       = in.position.x;
+    out.position[1]       = in.position.y;
+    out.position[2]       = in.position.z;
+    out.direction[0]      = in.direction.x;
+    out.direction[1]      = in.direction.y;
+    out.direction[2]      = in.direction.z;
+    out.diffuseColor      = encodeRgbe(in.diffuseColor);
+    out.specularColor     = encodeRgbe(in.specularColor);
+    out.diffuseIntensity  = floatToHalf(in.diffuseIntensity);
+    out.specularIntensity = floatToHalf(in.specularIntensity);
+    out.range             = floatToHalf(in.range);
+    out.shadowBias        = floatToHalf(in.shadowBias);
+    out.coneInnerAngle    = floatToHalf(in.coneInnerAngle);
+    out.coneOuterAngle    = floatToHalf(in.coneOuterAngle);
+    out.type              = static_cast<unsigned char>(in.type);
+    out.shadows           = in.shadows ? 1 : 0;
+  }
+}
+
+void CompactScene::decode( unsigned int first, unsigned int count, float* outPositions, float* outRotations, float* outScales ) const {
+  const unsigned int end = std::min<unsigned int>(first + count, _rotations.size());
+  if( first >= end ) {
+    return;
+  }
+
+  // Positions a block at a time, as each block has its own bounds.
+  for( unsigned int block = blockOf(first); outPositions != nullptr && block < _blocks.size() && _blocks[block].first < end; ++block ) {
+    const Block&       bounds = _blocks[block];
+    const unsigned int begin  = std::max(bounds.first, first);
+    const unsigned int stop   = (block + 1 < _blocks.size()) ? std::min(_blocks[block + 1].first, end) : end;
+    for( unsigned int axis = 0; axis < 3; ++axis ) {
+      const unsigned short* const in  = &_positions[axis][0];
+      float* const                out = outPositions + axis * count - first;
+      unsigned int                i   = begin;
+#ifdef SCENE_COMPACT_SSE2
+      const __m128 min  = _mm_set1_ps(bounds.min[axis]);
+      const __m128 step = _mm_set1_ps(bounds.step[axis]);
+      for( ; i + 4 <= stop; i += 4 ) {
+        _mm_storeu_ps(out + i, _mm_add_ps(min, _mm_mul_ps(_mm_cvtepi32_ps(loadShorts(in + i)), step)));
+      }
+#endif
+      for( ; i < stop; ++i ) {
+        out[i] = bounds.min[axis] + static_cast<float>(in[i]) * bounds.step[axis];
+      }
+    }
+  }
+
+  if( outScales != nullptr ) {
+    for( unsigned int axis = 0; axis < 3; ++axis ) {
+      const unsigned short* const in  = &_scales[axis][0];
+      float* const                out = outScales + axis * count - first;
+      unsigned int                i   = first;
+#ifdef SCENE_COMPACT_SSE2
+      for( ; i + 4 <= end; i += 4 ) {
+        _mm_storeu_ps(out + i, halvesToFloats(loadShorts(in + i)));
+      }
+#endif
+      for( ; i < end; ++i ) {
+        out[i] = halfToFloat(in[i]);
+      }
+    }
+  }
+
+  if( outRotations != nullptr ) {
+    unsigned int i = first;
+#ifdef SCENE_COMPACT_SSE2
+    // Unpack the three stored components and rebuild the largest, then pick each output component by the index of the
+    // largest.  Component i is the largest itself, or else the stored one at i, less one if the largest came before.
+    const __m128i mask  = _mm_set1_epi32(0x3FF);
+    const __m128  scale = _mm_set1_ps(2.0f / kRotationMax * kSqrtHalf);
+    const __m128  bias  = _mm_set1_ps(-kSqrtHalf);
+    for( ; i + 4 <= end; i += 4 ) {
+      const __m128i packed  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_rotations[i]));
+      const __m128i largest = _mm_srli_epi32(packed, 30);
+      const __m128  a       = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 20), mask)), scale), bias);
+      const __m128  b       = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 10), mask)), scale), bias);
+      const __m128  c       = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, mask)), scale), bias);
+      const __m128  rest    = _mm_add_ps(_mm_mul_ps(a, a), _mm_add_ps(_mm_mul_ps(b, b), _mm_mul_ps(c, c)));
+      const __m128  w       = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), rest), _mm_setzero_ps()));
+      const __m128  stored[4] = { a, b, c, c };
+      float* const  out       = outRotations + (i - first);
+      for( int component = 0; component < 4; ++component ) {
+        const __m128 isLargest = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(component)));
+        const __m128 after     = _mm_castsi128_ps(_mm_cmpgt_epi32(largest, _mm_set1_epi32(component)));
+        const __m128 before    = (component > 0) ? stored[component - 1] : a;
+        const __m128 other     = _mm_or_ps(_mm_and_ps(after, stored[component]), _mm_andnot_ps(after, before));
+        _mm_storeu_ps(out + component * count, _mm_or_ps(_mm_and_ps(isLargest, w), _mm_andnot_ps(isLargest, other)));
+      }
+    }
+#endif
+    for( ; i < end; ++i ) {
+      decodeRotation(_rotations[i], outRotations + (i - first), count);
+    }
+  }
+}
+
+Scene::Object CompactScene::object( unsigned int index ) const {
+  Scene::Object object;
+  float         position[3];
+  float         rotation[4];
+  float         scale[3];
+  decode(index, 1, position, rotation, scale);
+  object.name        = _hasNames ? name(_objectNames[index]) : std::string();
+  object.position    = Scene::Vector(position[0], position[1], position[2]);
+  object.orientation = quaternionToEuler(rotation);
+  object.scale       = Scene::Vector(scale[0], scale[1], scale[2]);
+  object.mesh        = _meshes[index];
+  object.material    = _materials[index];
+  object.parent      = _parents[index];
+  return object;
+}
+
+Scene::Material CompactScene::material( unsigned int index ) const {
+  const CompactMaterial& in = _materialRecords[index];
+  Scene::Material        material;
+  material.name       = _hasNames ? name(_materialNames[index]) : std::string();
+  material.color      = Scene::Vector((in.color & 0xFF) / 255.0f, ((in.color >> 8) & 0xFF) / 255.0f, ((in.color >> 16) & 0xFF) / 255.0f);
+  material.specSize   = halfToFloat(in.specSize);
+  material.diffuseTex = in.diffuseTex;
+  material.normalTex  = in.normalTex;
+  return material;
+}
+
+Scene::Light CompactScene::light( unsigned int index ) const {
+  const CompactLight& in = _lights[index];
+  Scene::Light        light;
+  light.type              = static_cast<Scene::LightType>(in.type);
+  light.diffuseColor      = decodeRgbe(in.diffuseColor);
+  light.diffuseIntensity  = halfToFloat(in.diffuseIntensity);
+  light.specularColor     = decodeRgbe(in.specularColor);
+  light.specularIntensity = halfToFloat(in.specularIntensity);
+  light.position          = Scene::Vector(in.position[0], in.position[1], in.position[2]);
+  light.range             = halfToFloat(in.range);
+  light.direction         = Scene::Vector(in.direction[0], in.direction[1], in.direction[2]);
+  light.shadows           = in.shadows != 0;
+  light.shadowBias        = halfToFloat(in.shadowBias);
+  light.coneInnerAngle    = halfToFloat(in.coneInnerAngle);
+  light.coneOuterAngle    = halfToFloat(in.coneOuterAngle);
+  return light;
+}
+
+const std::vector<int>& CompactScene::objectMeshes() const {
+  return _meshes;
+}
+
+const std::vector<int>& CompactScene::objectMaterials() const {
+  return _materials;
+}
+
+const std::vector<int>& CompactScene::objectParents() const {
+  return _parents;
+}
+
+unsigned int CompactScene::objectCount() const {
+  return _rotations.size();
+}
+
+unsigned int CompactScene::materialCount() const {
+  return _materialRecords.size();
+}
+
+unsigned int CompactScene::lightCount() const {
+  return _lights.size();
+}
+
+unsigned int CompactScene::blockCount() const {
+  return _blocks.size();
+}
+
+std::size_t CompactScene::byteSize() const {
+  std::size_t bytes = 0;
+  for( unsigned int axis = 0; axis < 3; ++axis ) {
+    bytes += _positions[axis].size() * sizeof(unsigned short) + _scales[axis].size() * sizeof(unsigned short);
+  }
+  bytes += _rotations.size() * sizeof(unsigned int);
+  bytes += (_meshes.size() + _materials.size() + _parents.size()) * sizeof(int);
+  bytes += (_objectNames.size() + _materialNames.size() + _nameStarts.size()) * sizeof(unsigned int);
+  bytes += _blocks.size() * sizeof(Block);
+  bytes += _materialRecords.size() * sizeof(CompactMaterial);
+  bytes += _lights.size() * sizeof(CompactLight);
+  bytes += _nameData.size();
+  return bytes;
+}
+
+void CompactScene::encodePositions( const std::vector<Scene::Object>& objects, float error ) {
+  // Rounding to the nearest of 65536 steps is off by half a step at most, so a block can span this much per axis.
+  // A little is kept back for float rounding in the decode.
+  const float maxExtent = std::max(error, 0.0f) * 2.0f * kQuantizeMax * 0.99f;
+
+  _blocks.clear();
+  for( unsigned int axis = 0; axis < 3; ++axis ) {
+    _positions[axis].resize(objects.size());
+  }
+
+  unsigned int first = 0;
+  while( first < objects.size() ) {
+    // Grow the block until it is full or the next object would stretch it too far.
+    float        min[3] = { objects[first].position.x, objects[first].position.y, objects[first].position.z };
+    float        max[3] = { min[0], min[1], min[2] };
+    unsigned int end    = first + 1;
+    for( ; end < objects.size() && end - first < kMaxBlockSize; ++end ) {
+      const float p[3] = { objects[end].position.x, objects[end].position.y, objects[end].position.z };
+      bool        fits = true;
+      for( unsigned int axis = 0; axis < 3; ++axis ) {
+        fits = fits && std::max(max[axis], p[axis]) - std::min(min[axis], p[axis]) <= maxExtent;
+      }
+      if( !fits ) {
+        break;
+      }
+      for( unsigned int axis = 0; axis < 3; ++axis ) {
+        min[axis] = std::min(min[axis], p[axis]);
+        max[axis] = std::max(max[axis], p[axis]);
+      }
+    }
+
+    Block block;
+    block.first = first;
+    for( unsigned int axis = 0; axis < 3; ++axis ) {
+      block.min[axis]  = min[axis];
+      block.step[axis] = (max[axis] - min[axis]) / kQuantizeMax;
+    }
+    _blocks.push_back(block);
+
+    for( unsigned int i = first; i < end; ++i ) {
+      const float p[3] = { objects[i].position.x, objects[i].position.y, objects[i].position.z };
+      for( unsigned int axis = 0; axis < 3; ++axis ) {
+        const float steps = (block.step[axis] > 0.0f) ? (p[axis] - min[axis]) / block.step[axis] : 0.0f;
+        _positions[axis][i] = static_cast<unsigned short>(std::min(steps + 0.5f, kQuantizeMax));
+      }
+    }
+    first = end;
+  }
+}
+
+std::string CompactScene::name( unsigned int id ) const {
+  if( id + 1 >= _nameStarts.size() ) {
+    return std::string();
+  }
+  return std::string(_nameData.begin() + _nameStarts[id], _nameData.begin() + _nameStarts[id + 1]);
+}
+
+unsigned int CompactScene::blockOf( unsigned int object ) const {
+  unsigned int low  = 0;
+  unsigned int high = _blocks.size();
+  while( high - low > 1 ) {
+    const unsigned int middle = (low + high) / 2;
+    if( _blocks[middle].first <= object ) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
@@ -0,0 +1,132 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __CompactScene__
+#define __CompactScene__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+
+// A quantized copy of a Scene's objects, materials, and lights for when memory is tight.  Object positions are 16
+// bits per axis relative to the bounds of a block of up to 64 consecutive objects.  Blocks end early where needed to
+// stay within the position error bound, so they are largest (and the encoding smallest) for scenes that have been
+// through Scene::sortSpatially().  Orientations become smallest-three quaternions in 32 bits (about 0.2 degrees
+// of error), and scales half floats.  Material colors are 8-bit unorm, clamped to [0, 1], and light colors RGBE.
+// The remaining light and material floats are half floats.  Names are either dropped or kept once each in a string
+// table.  Textures and meshes are not included, as references are still Scene indices.
+//
+// decode() turns a run of objects back into floats, four at a time with SSE2 (unless SCENE_DISABLE_SIMD is
+// defined).  object(), material(), and light() decode single records in full, with orientations back as degrees.
+// Euler angles come back in [-180, 180], so they may differ from the originals while describing the same rotation.
+class CompactScene {
+public:
+  enum NameMode : unsigned int {
+    kNameModeDrop,
+    kNameModeTable
+  };
+
+  struct Options {
+    // The largest error allowed in any axis of an object position.
+    float    positionError;
+    NameMode names;
+
+    Options()
+      : positionError(0.001f), names(kNameModeTable) {
+    }
+  };
+
+public:
+  CompactScene();
+  ~CompactScene();
+
+  void                     encode         ( const Scene& scene, const Options& options=Options() );
+  // Decodes objects [first, first + count) as structure-of-arrays floats.  Positions and scales take 3 * count
+  // floats (all of x, then y, then z), and rotations 4 * count floats of unit quaternions (x, y, z, then w).  Any
+  // output may be null to skip it.
+  void                     decode         ( unsigned int first, unsigned int count, float* outPositions, float* outRotations, float* outScales ) const;
+  Scene::Object            object         ( unsigned int index ) const;
+  Scene::Material          material       ( unsigned int index ) const;
+  Scene::Light             light          ( unsigned int index ) const;
+  const std::vector<int>&  objectMeshes   () const;
+  const std::vector<int>&  objectMaterials() const;
+  const std::vector<int>&  objectParents  () const;
+  unsigned int             objectCount    () const;
+  unsigned int             materialCount  () const;
+  unsigned int             lightCount     () const;
+  unsigned int             blockCount     () const;
+  // Bytes held by the encoded data.
+  std::size_t              byteSize       () const;
+
+private:
+  // A run of objects whose positions share one set of quantization bounds.
+  struct Block {
+    unsigned int first;
+    float        min[3];
+    float        step[3];
+  };
+
+  struct CompactMaterial {
+    unsigned int   color;
+    unsigned short specSize;
+    int            diffuseTex;
+    int            normalTex;
+  };
+
+  struct CompactLight {
+    float          position[3];
+    float          direction[3];
+    unsigned int   diffuseColor;
+    unsigned int   specularColor;
+    unsigned short diffuseIntensity;
+    unsigned short specularIntensity;
+    unsigned short range;
+    unsigned short shadowBias;
+    unsigned short coneInnerAngle;
+    unsigned short coneOuterAngle;
+    unsigned char  type;
+    unsigned char  shadows;
+  };
+
+private:
+  void         encodePositions( const std::vector<Scene::Object>& objects, float error );
+  std::string  name           ( unsigned int id ) const;
+  unsigned int blockOf        ( unsigned int object ) const;
+
+private:
+  // Per object, with each axis of positions and scales in its own array.
+  std::vector<unsigned short>  _positions[3];
+  std::vector<unsigned int>    _rotations;
+  std::vector<unsigned short>  _scales[3];
+  std::vector<int>             _meshes;
+  std::vector<int>             _materials;
+  std::vector<int>             _parents;
+  std::vector<unsigned int>    _objectNames;
+  std::vector<Block>           _blocks;
+  std::vector<CompactMaterial> _materialRecords;
+  std::vector<unsigned int>    _materialNames;
+  std::vector<CompactLight>    _lights;
+  // Each distinct name once, back to back, with where each starts plus where the last ends.
+  bool                         _hasNames;
+  std::vector<char>            _nameData;
+  std::vector<unsigned int>    _nameStarts;
+};
+
+#endif /* __CompactScene__ */
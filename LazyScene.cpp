@@ -0,0 +1,412 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include "LazyScene.hpp"
+
+namespace {
+  enum ScanState : unsigned int {
+    kScanStateWhitespace,
+    kScanStateScene,
+    kScanStateResources,
+    kScanStateTexture,
+    kScanStateMesh,
+    kScanStateMaterial,
+    kScanStateObjects,
+    kScanStateObj,
+    kScanStateLights,
+    kScanStateLight
+  };
+
+  // Compares a trimmed line against a tag without copying it.
+  bool lineIs( const char* line, long len, const char* tag ) {
+    const long tagLen = static_cast<long>(strlen(tag));
+    return len == tagLen && memcmp(line, tag, len) == 0;
+  }
+
+  // If the trimmed line is "key = value", stores the value and returns true.  Like the regular parser, the value
+  // ends at the next '=' and surrounding spaces are removed.
+  bool readValue( const char* line, long len, const char* key, std::string* outValue ) {
+    const long keyLen = static_cast<long>(strlen(key));
+    if( len < keyLen || memcmp(line, key, keyLen) != 0 ) {
+      return false;
+    }
+    long i = keyLen;
+    while( i < len && line[i] == ' ' ) {
+      i += 1;
+    }
+    if( i >= len || line[i] != '=' ) {
+      return false;
+    }
+    i += 1;
+    while( i < len && line[i] == ' ' ) {
+      i += 1;
+    }
+    long end = i;
+    while( end < len && line[end] != '=' ) {
+      end += 1;
+    }
+    while( end > i && line[end-1] == ' ' ) {
+      end -= 1;
+    }
+    outValue->assign(&line[i], end - i);
+    return true;
+  }
+
+  template<typename T>
+  void addBlock( T* blocks, long offset ) {
+    blocks->offsets.push_back(offset);
+    blocks->sizes.push_back(0);
+    blocks->names.push_back("");
+  }
+
+  template<typename T>
+  void prepareBlocks( T* blocks ) {
+    blocks->once.reset(new std::once_flag[blocks->offsets.size()]);
+    blocks->records.resize(blocks->offsets.size());
+  }
+}
+
+LazyScene::LazyScene() {
+}
+
+LazyScene::~LazyScene() {
+}
+
+bool LazyScene::open( const std::string& file ) {
+  clean();
+
+  // Read the entire file.  It's kept around so that blocks can be parsed later.
+  FILE* const f = fopen(file.c_str(), "rb");
+  if( f == nullptr ) {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if( size <= 0 ) {
+    fclose(f);
+    return false;
+  }
+  _buffer.resize(size);
+  fread(&_buffer[0], sizeof(char), size, f);
+  fclose(f);
+
+  // Find the blocks, then parse the resources that everything else refers to.
+  std::string              resourceText;
+  std::vector<std::string> parentNames;
+  scan(&resourceText, &parentNames);
+  _resources.loadFromMemory(resourceText.c_str(), resourceText.size());
+
+  prepareBlocks(&_objects);
+  prepareBlocks(&_materials);
+  prepareBlocks(&_lights);
+  _objectLookupOnce.reset(new std::once_flag());
+  resolveParents(parentNames);
+  return true;
+}
+
+const std::vector<Scene::Texture>& LazyScene::textures() const {
+  return _resources.textures();
+}
+
+const std::vector<Scene::Mesh>& LazyScene::meshes() const {
+  return _resources.meshes();
+}
+
+unsigned int LazyScene::objectCount() const {
+  return _objects.offsets.size();
+}
+
+unsigned int LazyScene::materialCount() const {
+  return _materials.offsets.size();
+}
+
+unsigned int LazyScene::lightCount() const {
+  return _lights.offsets.size();
+}
+
+const std::string& LazyScene::objectName( unsigned int index ) const {
+  return _objects.names[index];
+}
+
+const std::string& LazyScene::materialName( unsigned int index ) const {
+  return _materials.names[index];
+}
+
+int LazyScene::findObject( const std::string& name ) const {
+  if( _objectLookupOnce == nullptr ) {
+    return -1;
+  }
+  std::call_once(*_objectLookupOnce, &LazyScene::buildObjectLookup, this);
+  const std::unordered_map<std::string, unsigned int>::const_iterator it = _objectLookup.find(name);
+  return (it != _objectLookup.end()) ? static_cast<int>(it->second) : -1;
+}
+
+int LazyScene::findMaterial( const std::string& name ) const {
+  for( unsigned int i = 0; i < _materials.names.size(); ++i ) {
+    if( strcmp(name.c_str(), _materials.names[i].c_str()) == 0 ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const Scene::Object& LazyScene::object( unsigned int index ) const {
+  std::call_once(_objects.once[index], &LazyScene::materializeObject, this, index);
+  return *_objects.records[index];
+}
+
+const Scene::Material& LazyScene::material( unsigned int index ) const {
+  std::call_once(_materials.once[index], &LazyScene::materializeMaterial, this, index);
+  return *_materials.records[index];
+}
+
+const Scene::Light& LazyScene::light( unsigned int index ) const {
+  std::call_once(_lights.once[index], &LazyScene::materializeLight, this, index);
+  return *_lights.records[index];
+}
+
+void LazyScene::scan( std::string* outResourceText, std::vector<std::string>* outParentNames ) {
+  // Textures and meshes are copied out verbatim.  Materials only need their names for objects to resolve against,
+  // so a stub is written in their place.
+  outResourceText->assign("[scene]\n[resources]\n");
+
+  const char* const text       = &_buffer[0];
+  const long        size       = _buffer.size();
+  ScanState         state      = kScanStateWhitespace;
+  long              blockStart = 0;
+  long              index      = 0;
+  while( index < size ) {
+    // Find the end of the line, then trim the spaces either side of it.
+    long end = index;
+    while( end < size && text[end] != '\r' && text[end] != '\n' ) {
+      end += 1;
+    }
+    const long lineStart = index;
+    long       begin     = index;
+    long       last      = end;
+    index = end + 1;
+    while( begin < last && text[begin] == ' ' ) {
+      begin += 1;
+    }
+    while( last > begin && text[last-1] == ' ' ) {
+      last -= 1;
+    }
+    const char* const line = &text[begin];
+    const long        len  = last - begin;
+    if( len == 0 ) {
+      continue;
+    }
+
+    switch( state ) {
+      case kScanStateWhitespace: {
+        if( lineIs(line, len, "[scene]") ) {
+          state = kScanStateScene;
+        }
+        break;
+      }
+
+      case kScanStateScene: {
+        if( lineIs(line, len, "[resources]") ) {
+          state = kScanStateResources;
+        } else if( lineIs(line, len, "[objects]") ) {
+          state = kScanStateObjects;
+        } else if( lineIs(line, len, "[lights]") ) {
+          state = kScanStateLights;
+        } else if( lineIs(line, len, "[/scene]") ) {
+          state = kScanStateWhitespace;
+        }
+        break;
+      }
+
+      case kScanStateResources: {
+        blockStart = lineStart;
+        if( lineIs(line, len, "[texture]") ) {
+          state = kScanStateTexture;
+        } else if( lineIs(line, len, "[mesh]") ) {
+          state = kScanStateMesh;
+        } else if( lineIs(line, len, "[material]") ) {
+          addBlock(&_materials, lineStart);
+          state = kScanStateMaterial;
+        } else if( lineIs(line, len, "[/resources]") ) {
+          state = kScanStateScene;
+        }
+        break;
+      }
+
+      case kScanStateTexture:
+      case kScanStateMesh: {
+        if( lineIs(line, len, (state == kScanStateTexture) ? "[/texture]" : "[/mesh]") ) {
+          outResourceText->append(&text[blockStart], end - blockStart);
+          outResourceText->append("\n");
+          state = kScanStateResources;
+        }
+        break;
+      }
+
+      case kScanStateMaterial: {
+        if( lineIs(line, len, "[/material]") ) {
+          _materials.sizes.back() = end - _materials.offsets.back();
+          outResourceText->append("[material]\nname = " + _materials.names.back() + "\n[/material]\n");
+          state = kScanStateResources;
+        } else {
+          readValue(line, len, "name", &_materials.names.back());
+        }
+        break;
+      }
+
+      case kScanStateObjects: {
+        if( lineIs(line, len, "[obj]") ) {
+          addBlock(&_objects, lineStart);
+          outParentNames->push_back("");
+          state = kScanStateObj;
+        } else if( lineIs(line, len, "[/objects]") ) {
+          state = kScanStateScene;
+        }
+        break;
+      }
+
+      case kScanStateObj: {
+        if( lineIs(line, len, "[/obj]") ) {
+          _objects.sizes.back() = end - _objects.offsets.back();
+          state = kScanStateObjects;
+        } else if( !readValue(line, len, "name", &_objects.names.back()) ) {
+          readValue(line, len, "parent", &outParentNames->back());
+        }
+        break;
+      }
+
+      case kScanStateLights: {
+        if( lineIs(line, len, "[light]") ) {
+          addBlock(&_lights, lineStart);
+          state = kScanStateLight;
+        } else if( lineIs(line, len, "[/lights]") ) {
+          state = kScanStateScene;
+        }
+        break;
+      }
+
+      case kScanStateLight: {
+        if( lineIs(line, len, "[/light]") ) {
+          _lights.sizes.back() = end - _lights.offsets.back();
+          state = kScanStateLights;
+        }
+        break;
+      }
+
+      default: {
+        break;
+      }
+    }
+  }
+
+  // Drop a trailing block that was never closed, as the regular parser would never have added it.
+  if( state == kScanStateMaterial ) {
+    _materials.offsets.pop_back();
+    _materials.sizes.pop_back();
+    _materials.names.pop_back();
+  } else if( state == kScanStateObj ) {
+    _objects.offsets.pop_back();
+    _objects.sizes.pop_back();
+    _objects.names.pop_back();
+    outParentNames->pop_back();
+  } else if( state == kScanStateLight ) {
+    _lights.offsets.pop_back();
+    _lights.sizes.pop_back();
+    _lights.names.pop_back();
+  }
+
+  outResourceText->append("[/resources]\n[/scene]\n");
+}
+
+void LazyScene::materializeObject( unsigned int index ) const {
+  std::vector<Scene::Object> objects;
+  std::vector<Scene::Light>  lights;
+  _resources.parseBlocks(&_buffer[_objects.offsets[index]], _objects.sizes[index], &objects, &lights);
+  _objects.records[index].reset(objects.empty() ? new Scene::Object() : new Scene::Object(objects[0]));
+  // Parents were resolved against the whole file by open(), as the resources have no objects to resolve against.
+  _objects.records[index]->parent = _objectParents[index];
+}
+
+void LazyScene::materializeMaterial( unsigned int index ) const {
+  std::vector<Scene::Object>   objects;
+  std::vector<Scene::Light>    lights;
+  std::vector<Scene::Material> materials;
+  _resources.parseBlocks(&_buffer[_materials.offsets[index]], _materials.sizes[index], &objects, &lights, &materials);
+  _materials.records[index].reset(materials.empty() ? new Scene::Material() : new Scene::Material(materials[0]));
+}
+
+void LazyScene::materializeLight( unsigned int index ) const {
+  std::vector<Scene::Object> objects;
+  std::vector<Scene::Light>  lights;
+  _resources.parseBlocks(&_buffer[_lights.offsets[index]], _lights.sizes[index], &objects, &lights);
+  if( lights.empty() ) {
+    lights.resize(1);
+    lights[0].reset();
+  }
+  _lights.records[index].reset(new Scene::Light(lights[0]));
+}
+
+void LazyScene::buildObjectLookup() const {
+  // The first object with a given name wins, the same as a linear search would.
+  _objectLookup.reserve(_objects.names.size());
+  for( unsigned int i = 0; i < _objects.names.size(); ++i ) {
+    _objectLookup.insert(std::make_pair(_objects.names[i], i));
+  }
+}
+
+void LazyScene::resolveParents( const std::vector<std::string>& parentNames ) {
+  // The first object with the name is the parent, as with Scene::load().  That also goes for which parent is dropped
+  // to break a cycle: parents earlier in the file are kept, then later ones are added in file order unless they
+  // would close a cycle.  Names are only looked up if some object has a parent.
+  _objectParents.assign(parentNames.size(), -1);
+  std::vector<int> later(parentNames.size(), -1);
+  for( unsigned int i = 0; i < parentNames.size(); ++i ) {
+    if( !parentNames[i].empty() ) {
+      const int parent = findObject(parentNames[i]);
+      if( parent < static_cast<int>(i) ) {
+        _objectParents[i] = parent;
+      } else {
+        later[i] = parent;
+      }
+    }
+  }
+  for( unsigned int i = 0; i < later.size(); ++i ) {
+    int ancestor = later[i];
+    while( ancestor != -1 && ancestor != static_cast<int>(i) ) {
+      ancestor = _objectParents[ancestor];
+    }
+    if( later[i] != -1 && ancestor == -1 ) {
+      _objectParents[i] = later[i];
+    }
+  }
+}
+
+void LazyScene::clean() {
+  _buffer.clear();
+  _resources = Scene();
+  _objects   = Blocks<Scene::Object>();
+  _materials = Blocks<Scene::Material>();
+  _lights    = Blocks<Scene::Light>();
+  _objectLookupOnce.reset();
+  _objectLookup.clear();
+  _objectParents.clear();
+}
@@ -0,0 +1,89 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __LazyScene__
+#define __LazyScene__
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Scene.hpp"
+
+// A read-only view of a Scene file that only parses what is asked for.  open() makes one quick pass over the file,
+// recording where each [material], [obj], and [light] block is and the names of materials and objects; textures and
+// meshes are small and parsed straight away.  A block is fully parsed the first time it is accessed, which is safe
+// to do from several threads at once.  Unlike Scene::load(), names resolve against the whole file, so a reference
+// to a resource defined further down still resolves.  Object parents are resolved by name when the file is opened.
+class LazyScene {
+public:
+  LazyScene();
+  ~LazyScene();
+
+  bool                               open          ( const std::string& file );
+  const std::vector<Scene::Texture>& textures      () const;
+  const std::vector<Scene::Mesh>&    meshes        () const;
+  unsigned int                       objectCount   () const;
+  unsigned int                       materialCount () const;
+  unsigned int                       lightCount    () const;
+  // Names are available without parsing the block.
+  const std::string&                 objectName    ( unsigned int index ) const;
+  const std::string&                 materialName  ( unsigned int index ) const;
+  // Returns -1 if there is no such object or material.
+  int                                findObject    ( const std::string& name ) const;
+  int                                findMaterial  ( const std::string& name ) const;
+  // Parses the block on first access.
+  const Scene::Object&               object        ( unsigned int index ) const;
+  const Scene::Material&             material      ( unsigned int index ) const;
+  const Scene::Light&                light         ( unsigned int index ) const;
+
+private:
+  // A lazily parsed block of a given record type.
+  template<typename T>
+  struct Blocks {
+    std::vector<long>                        offsets;
+    std::vector<long>                        sizes;
+    std::vector<std::string>                 names;
+    std::unique_ptr<std::once_flag[]>        once;
+    mutable std::vector<std::unique_ptr<T>>  records;
+  };
+
+private:
+  void scan               ( std::string* outResourceText, std::vector<std::string>* outParentNames );
+  void materializeObject  ( unsigned int index ) const;
+  void materializeMaterial( unsigned int index ) const;
+  void materializeLight   ( unsigned int index ) const;
+  void buildObjectLookup  () const;
+  void resolveParents     ( const std::vector<std::string>& parentNames );
+  void clean              ();
+
+private:
+  std::vector<char>                                     _buffer;
+  Scene                                                 _resources;
+  Blocks<Scene::Object>                                 _objects;
+  Blocks<Scene::Material>                               _materials;
+  Blocks<Scene::Light>                                  _lights;
+  mutable std::unique_ptr<std::once_flag>               _objectLookupOnce;
+  mutable std::unordered_map<std::string, unsigned int> _objectLookup;
+  // Per object, the index of its parent, or -1.
+  std::vector<int>                                      _objectParents;
+};
+
+#endif /* __LazyScene__ */
@@ -17,78 +17,2337 @@
   along with Scene.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <iostream>
+#include <fstream>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
+#include <thread>
+#include <utility>
 #include "Scene.hpp"
+#include "SceneSchema.hpp"
 #include "StringUtils.hpp"
 
+#ifdef SCENE_ENABLE_LOAD_STATS
+#include <chrono>
+
+namespace {
+  // Adds the time between construction and destruction to the given counter, if there is one.
+  class ScopedStatsTimer {
+  public:
+    ScopedStatsTimer( double* out )
+      : _out(out), _start(std::chrono::high_resolution_clock::now()) {
+    }
+    ~ScopedStatsTimer() {
+      if( _out == nullptr ) {
+        return;
+      }
+      *_out += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - _start).count();
+    }
+
+  private:
+    double* const                                        _out;
+    const std::chrono::high_resolution_clock::time_point _start;
+  };
+}
+
+#define SCENE_STATS_CONCAT_IMPL(a, b) a##b
+#define SCENE_STATS_CONCAT(a, b)      SCENE_STATS_CONCAT_IMPL(a, b)
+// Times the rest of the enclosing scope into the given double.
+#define SCENE_STATS_TIME(counter)     ScopedStatsTimer SCENE_STATS_CONCAT(statsTimer, __LINE__)(&(counter))
+// Starts a named timer, and adds the time since it was started to the given double.
+#define SCENE_STATS_START(timer)      const std::chrono::high_resolution_clock::time_point timer = std::chrono::high_resolution_clock::now()
+#define SCENE_STATS_STOP(timer, counter) (counter) += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - (timer)).count()
+// Evaluates the statement only when stats are enabled.
+#define SCENE_STATS(statement)        statement
+// Times the rest of the enclosing scope into the given LoadStats phase, if a load is in progress.
+#define SCENE_STATS_TIME_PHASE(field) ScopedStatsTimer SCENE_STATS_CONCAT(statsTimer, __LINE__)((_activeStats != nullptr) ? &_activeStats->field : nullptr)
+// Counts a reference that failed to resolve, if a load is in progress.
+#define SCENE_STATS_RESOLVED(index)   if( (index) == -1 && _activeStats != nullptr ) { _activeStats->unresolvedReferences += 1; }
+#else
+#define SCENE_STATS_TIME(counter)
+#define SCENE_STATS_TIME_PHASE(field)
+#define SCENE_STATS_START(timer)
+#define SCENE_STATS_STOP(timer, counter)
+#define SCENE_STATS(statement)
+#define SCENE_STATS_RESOLVED(index)
+#endif
+
+namespace {
+  // Track channel and interpolation names as written in .scn files, indexed by their enums.
+  const char* const  kTrackChannelNames[]  = { "position", "orientation", "scale", "diffuseIntensity" };
+  const unsigned int kTrackChannelCount    = 4;
+  const char* const  kInterpolationNames[] = { "linear", "step", "cubic" };
+  const unsigned int kInterpolationCount   = 3;
+
+  // Load progress is reported, and cancellation checked, after this many lines.
+  const unsigned int kProgressLines = 1024;
+
+  // Once the save buffer holds this much it is written out and reused.
+  const size_t kSaveFlushSize = 1 << 20;
+
+  // Appends the shortest decimal that reads back as exactly the same float.  %g drops trailing zeros, so the
+  // first precision that round-trips gives the shortest form; almost all values are done at the first attempt.
+  // The check reads the text back the same way the parser does, through atof().
+  void appendFloat( std::string* out, float value ) {
+    char text[32];
+    for( int precision = 6; precision <= 9; ++precision ) {
+      snprintf(text, sizeof(text), "%.*g", precision, value);
+      if( static_cast<float>(atof(text)) == value ) {
+        break;
+      }
+    }
+    out->append(text);
+  }
+
+  // Whether a string written as the value of a "key = value" line reads back the same.  The parser ends the line at
+  // a line break or NUL, the value at the next '=', and trims spaces from both ends.
+  bool readsBack( const std::string& value ) {
+    if( !value.empty() && (value[0] == ' ' || value[value.size() - 1] == ' ') ) {
+      return false;
+    }
+    for( unsigned int i = 0; i < value.size(); ++i ) {
+      const char c = value[i];
+      if( c == '\n' || c == '\r' || c == '\0' || c == '=' ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Checks that every string field of a record reads back the same.
+  template<typename Record>
+  class TextChecker {
+  public:
+    TextChecker( const Record& record )
+      : _record(record), _ok(true) {
+    }
+
+    template<typename T, typename D>
+    void operator()( const char*, T Record::* member, sceneschema::FieldKind, const D& ) {
+      check(_record.*member);
+    }
+
+    bool ok() const {
+      return _ok;
+    }
+
+  private:
+    void check( const std::string& value ) {
+      _ok = _ok && readsBack(value);
+    }
+
+    template<typename T>
+    void check( const T& ) {
+    }
+
+  private:
+    const Record& _record;
+    bool          _ok;
+  };
+
+  template<typename Record>
+  bool recordsReadBack( const std::vector<Record>& records ) {
+    for( unsigned int i = 0; i < records.size(); ++i ) {
+      TextChecker<Record> checker(records[i]);
+      sceneschema::Schema<Record>::fields(checker);
+      if( !checker.ok() ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Name of the record an index refers to, or null if the reference is unresolved.
+  template<typename T>
+  const std::string* referenceName( const std::vector<T>& targets, int index ) {
+    if( index < 0 || index >= static_cast<int>(targets.size()) ) {
+      return nullptr;
+    }
+    return &targets[index].name;
+  }
+
+  // Writes a record's fields as .scn text.
+  template<typename Record>
+  class TextWriter {
+  public:
+    TextWriter( std::string* out, const Scene& scene, const Record& record )
+      : _out(out), _scene(scene), _record(record) {
+    }
+
+    template<typename T, typename D>
+    void operator()( const char* key, T Record::* member, sceneschema::FieldKind kind, const D& ) {
+      write(key, _record.*member, kind);
+    }
+
+  private:
+    void beginField( const char* key ) {
+      _out->append("      ");
+      _out->append(key);
+      _out->append(" = ");
+    }
+
+    void write( const char* key, const std::string& value, sceneschema::FieldKind ) {
+      beginField(key);
+      _out->append(value);
+      _out->push_back('\n');
+    }
+
+    void write( const char* key, float value, sceneschema::FieldKind ) {
+      beginField(key);
+      appendFloat(_out, value);
+      _out->push_back('\n');
+    }
+
+    void write( const char* key, const Scene::Vector& value, sceneschema::FieldKind ) {
+      beginField(key);
+      appendFloat(_out, value.x);
+      _out->push_back(',');
+      appendFloat(_out, value.y);
+      _out->push_back(',');
+      appendFloat(_out, value.z);
+      _out->push_back('\n');
+    }
+
+    void write( const char* key, bool value, sceneschema::FieldKind ) {
+      beginField(key);
+      _out->append(value ? "true\n" : "false\n");
+    }
+
+    void write( const char* key, Scene::LightType value, sceneschema::FieldKind ) {
+      beginField(key);
+      switch( value ) {
+        case Scene::kLightTypeSpot: {
+          _out->append("spot\n");
+          break;
+        }
+        case Scene::kLightTypeDirectional: {
+          _out->append("directional\n");
+          break;
+        }
+        default: {
+          _out->append("point\n");
+          break;
+        }
+      }
+    }
+
+    // References are written by name.  Unresolved references (-1) are left out, so they stay unresolved when read back.
+    void write( const char* key, int index, sceneschema::FieldKind kind ) {
+      const std::string* name = nullptr;
+      switch( kind ) {
+        case sceneschema::kFieldKindTextureRef: {
+          name = referenceName(_scene.textures(), index);
+          break;
+        }
+        case sceneschema::kFieldKindMeshRef: {
+          name = referenceName(_scene.meshes(), index);
+          break;
+        }
+        case sceneschema::kFieldKindMaterialRef: {
+          name = referenceName(_scene.materials(), index);
+          break;
+        }
+        case sceneschema::kFieldKindObjectRef: {
+          name = referenceName(_scene.objects(), index);
+          break;
+        }
+        default: {
+          break;
+        }
+      }
+      if( name != nullptr ) {
+        write(key, *name, kind);
+      }
+    }
+
+  private:
+    std::string* const _out;
+    const Scene&       _scene;
+    const Record&      _record;
+  };
+
+  template<typename Record>
+  void appendRecord( std::string* out, const Scene& scene, const Record& record ) {
+    const char* const tag = sceneschema::Schema<Record>::tag();
+    out->append("    [");
+    out->append(tag);
+    out->append("]\n");
+    TextWriter<Record> writer(out, scene, record);
+    sceneschema::Schema<Record>::fields(writer);
+    out->append("    [/");
+    out->append(tag);
+    out->append("]\n");
+  }
+
+  // Formats a range of records into its own buffer, for the parallel save.
+  template<typename Record>
+  std::string formatRecords( const Scene* scene, const std::vector<Record>* records, unsigned int begin, unsigned int end ) {
+    std::string out;
+    out.reserve((end - begin) * 256);
+    for( unsigned int i = begin; i < end; ++i ) {
+      appendRecord(&out, *scene, (*records)[i]);
+    }
+    return out;
+  }
+
+  // Formats the chunks of objects, then of lights, for the parallel save.  Each worker takes the next chunk that
+  // hasn't been started until there are none left.
+  struct SaveWorker {
+    const Scene*               scene;
+    unsigned int               objectChunk;
+    unsigned int               objectChunks;
+    unsigned int               lightChunk;
+    std::atomic<unsigned int>* next;
+    std::vector<std::string>*  chunks;
+
+    void operator()() const {
+      for( unsigned int chunk = (*next)++; chunk < chunks->size(); chunk = (*next)++ ) {
+        if( chunk < objectChunks ) {
+          const unsigned int begin = chunk * objectChunk;
+          (*chunks)[chunk] = formatRecords(scene, &scene->objects(), begin, std::min<unsigned int>(begin + objectChunk, scene->objects().size()));
+        } else {
+          const unsigned int begin = (chunk - objectChunks) * lightChunk;
+          (*chunks)[chunk] = formatRecords(scene, &scene->lights(), begin, std::min<unsigned int>(begin + lightChunk, scene->lights().size()));
+        }
+      }
+    }
+  };
+
+  // Writes the buffer out and empties it, keeping its capacity, once it's full enough.
+  void flushIfFull( std::ostream& stream, std::string* buffer ) {
+    if( buffer->size() < kSaveFlushSize ) {
+      return;
+    }
+    stream.write(buffer->data(), buffer->size());
+    buffer->clear();
+  }
+
+  template<typename Record>
+  void appendRecords( std::ostream& stream, std::string* buffer, const Scene& scene, const std::vector<Record>& records ) {
+    for( unsigned int i = 0; i < records.size(); ++i ) {
+      appendRecord(buffer, scene, records[i]);
+      flushIfFull(stream, buffer);
+    }
+  }
+
+  // Tracks are written after the objects and lights they refer to.  Objects are referred to by name, lights by index.
+  void appendTracks( std::string* out, const Scene& scene ) {
+    if( scene.tracks().empty() ) {
+      return;
+    }
+    out->append("  [animations]\n");
+    for( unsigned int i = 0; i < scene.tracks().size(); ++i ) {
+      const Scene::Track& track = scene.tracks()[i];
+      out->append("    [track]\n");
+      if( track.targetType == Scene::kTrackTargetObject ) {
+        out->append("      object = ");
+        out->append(scene.objects()[track.target].name);
+      } else {
+        char text[16];
+        snprintf(text, sizeof(text), "%d", track.target);
+        out->append("      light = ");
+        out->append(text);
+      }
+      out->append("\n      channel = ");
+      out->append(kTrackChannelNames[track.channel]);
+      out->append("\n      interpolation = ");
+      out->append(kInterpolationNames[track.interpolation]);
+      out->push_back('\n');
+      const bool vector = track.channel != Scene::kTrackChannelDiffuseIntensity;
+      for( unsigned int j = 0; j < track.times.size(); ++j ) {
+        out->append("      key = ");
+        appendFloat(out, track.times[j]);
+        out->push_back(',');
+        appendFloat(out, track.values[j].x);
+        if( vector ) {
+          out->push_back(',');
+          appendFloat(out, track.values[j].y);
+          out->push_back(',');
+          appendFloat(out, track.values[j].z);
+        }
+        out->push_back('\n');
+      }
+      out->append("    [/track]\n");
+    }
+    out->append("  [/animations]\n");
+  }
+
+  // Writes a record's fields to the log for debugOutput().
+  template<typename Record>
+  class DebugWriter {
+  public:
+    DebugWriter( unsigned int index, const Record& record )
+      : _index(index), _record(record) {
+    }
+
+    template<typename T, typename D>
+    void operator()( const char* key, T Record::* member, sceneschema::FieldKind, const D& ) {
+      std::clog << "[" << _index << "]." << key << " = ";
+      write(_record.*member);
+      std::clog << std::endl;
+    }
+
+  private:
+    void write( const std::string& value ) {
+      std::clog << value.c_str();
+    }
+
+    void write( const Scene::Vector& value ) {
+      std::clog << value.x << ", " << value.y << ", " << value.z;
+    }
+
+    void write( bool value ) {
+      std::clog << (value ? "true" : "false");
+    }
+
+    // Floats, indices, and light types are printed as numbers.
+    template<typename T>
+    void write( const T& value ) {
+      std::clog << value;
+    }
+
+  private:
+    const unsigned int _index;
+    const Record&      _record;
+  };
+
+  // Records with many fields get a blank line after each one, the rest a blank line after the whole list.
+  template<typename Record>
+  void debugRecords( const char* title, const std::vector<Record>& records, bool spaceEach ) {
+    std::clog << title << ": " << records.size() << std::endl;
+    for( unsigned int i = 0; i < records.size(); ++i ) {
+      DebugWriter<Record> writer(i, records[i]);
+      sceneschema::Schema<Record>::fields(writer);
+      if( spaceEach ) {
+        std::clog << std::endl;
+      }
+    }
+    if( !spaceEach ) {
+      std::clog << std::endl;
+    }
+  }
+
+  // Maps each name to the first record with it, the same as a linear search would find, and chains the others after it.
+  template<typename Names, typename Record>
+  void indexNames( const std::vector<Record>& records, Names* outNames ) {
+    outNames->clear();
+    outNames->reserve(records.size());
+    for( unsigned int i = 0; i < records.size(); ++i ) {
+      outNames->insert(records, i);
+    }
+  }
+
+  // The name index helpers take no index for records without names.
+  template<typename Names, typename Record>
+  void addName( Names* names, const std::vector<Record>& records, unsigned int index ) {
+    if( names != nullptr ) {
+      names->insert(records, index);
+    }
+  }
+
+  template<typename Names>
+  void eraseName( Names* names, const std::string* name, unsigned int index ) {
+    if( names != nullptr && name != nullptr ) {
+      names->erase(*name, index);
+    }
+  }
+
+  template<typename Names>
+  void moveName( Names* names, const std::string* name, unsigned int from, unsigned int to ) {
+    if( names != nullptr && name != nullptr ) {
+      names->move(*name, from, to);
+    }
+  }
+
+  // Finds which of a record's fields a key names, by its place in the Schema's list.  Keys are placed by their length
+  // and end characters, which tells almost every key apart, so a lookup is one hash and usually one strcmp rather than
+  // a strcmp per field.  Built once per record type.
+  template<typename Record>
+  class FieldTable {
+  public:
+    static const FieldTable& instance() {
+      static const FieldTable table;
+      return table;
+    }
+
+    // Returns the field's place in the Schema's list, or -1 if no field has the key.
+    int find( const std::string& key ) const {
+      if( key.empty() ) {
+        return -1;
+      }
+      for( unsigned int i = slotOf(key.c_str(), key.size()); _slots[i] != -1; i = (i + 1) & kMask ) {
+        if( strcmp(_keys[_slots[i]], key.c_str()) == 0 ) {
+          return _slots[i];
+        }
+      }
+      return -1;
+    }
+
+    template<typename T, typename D>
+    void operator()( const char* key, T Record::*, sceneschema::FieldKind, const D& ) {
+      unsigned int i = slotOf(key, strlen(key));
+      while( _slots[i] != -1 ) {
+        i = (i + 1) & kMask;
+      }
+      _slots[i] = static_cast<int>(_keys.size());
+      _keys.push_back(key);
+    }
+
+  private:
+    // Well over twice the most fields any record has.
+    static const unsigned int kSlots = 64;
+    static const unsigned int kMask  = kSlots - 1;
+
+    FieldTable() {
+      std::fill(_slots, _slots + kSlots, -1);
+      sceneschema::Schema<Record>::fields(*this);
+    }
+
+    static unsigned int slotOf( const char* key, size_t length ) {
+      const unsigned int first = static_cast<unsigned char>(key[0]);
+      const unsigned int last  = static_cast<unsigned char>(key[length - 1]);
+      return (static_cast<unsigned int>(length) * 37 + first * 11 + last) & kMask;
+    }
+
+  private:
+    std::vector<const char*> _keys;
+    int                      _slots[kSlots];
+  };
+
+  unsigned int hashName( const std::string& name ) {
+    return static_cast<unsigned int>(std::hash<std::string>()(name));
+  }
+
+  // Splits a "key = value" line the way splitString() would, into strings whose memory is reused.  Fails if there
+  // are fewer than two pieces.
+  bool splitField( const std::string& line, std::string* outKey, std::string* outValue ) {
+    strutils::Range ranges[2];
+    if( strutils::splitRanges(line.c_str(), line.size(), '=', false, ranges, 2) < 2 ) {
+      return false;
+    }
+    outKey->assign(line, ranges[0].begin, ranges[0].size);
+    outValue->assign(line, ranges[1].begin, ranges[1].size);
+    return true;
+  }
+
+  // Whether a line, after trimming spaces the way parseLine() does, is exactly the given tag.
+  bool isTag( const char* line, long size, const char* tag ) {
+    int begin = 0;
+    int trimmed = 0;
+    strutils::trimRange(line, size, &begin, &trimmed);
+    return static_cast<size_t>(trimmed) == strlen(tag) && memcmp(line + begin, tag, trimmed) == 0;
+  }
+
+  // Marks an unused slot or index in a SlotMap, and an unused record in a Change.
+  const unsigned int kNone = 0xFFFFFFFF;
+
+  bool inRange( int reference, unsigned int count ) {
+    return reference >= -1 && reference < static_cast<int>(count);
+  }
+
+  // Whether following parents up from object, starting with the object itself, reaches ancestor.  Gives up after as
+  // many steps as there are objects, so that a cycle already there can't keep it going.
+  bool reachesAncestor( const std::vector<Scene::Object>& objects, int object, int ancestor ) {
+    for( unsigned int steps = 0; object >= 0 && object < static_cast<int>(objects.size()) && steps <= objects.size(); ++steps ) {
+      if( object == ancestor ) {
+        return true;
+      }
+      object = objects[object].parent;
+    }
+    return false;
+  }
+
+  // Whether any object is its own ancestor.  Each object is walked up from once, marking the ones on the way as it
+  // goes, so a walk that comes back to a mark from the same walk has found a cycle.
+  bool hasParentCycle( const std::vector<Scene::Object>& objects ) {
+    std::vector<unsigned int> walkOf(objects.size(), kNone);
+    for( unsigned int i = 0; i < objects.size(); ++i ) {
+      int object = i;
+      while( object >= 0 && object < static_cast<int>(objects.size()) && walkOf[object] == kNone ) {
+        walkOf[object] = i;
+        object         = objects[object].parent;
+      }
+      if( object >= 0 && object < static_cast<int>(objects.size()) && walkOf[object] == i ) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Bits per axis of a Morton code.  Three axes of ten bits fill 30 bits, sorted in three radix passes.
+  const unsigned int kMortonBits      = 10;
+  const unsigned int kMortonMax       = (1 << kMortonBits) - 1;
+  const unsigned int kMortonRadixBits = 10;
+  const unsigned int kMortonRadixMask = (1 << kMortonRadixBits) - 1;
+  const unsigned int kMortonPasses    = 3;
+
+  // Spreads the low ten bits of a value out so that there are two zero bits between each.
+  unsigned int spreadBits( unsigned int value ) {
+    value &= kMortonMax;
+    value = (value | (value << 16)) & 0x030000ff;
+    value = (value | (value << 8))  & 0x0300f00f;
+    value = (value | (value << 4))  & 0x030c30c3;
+    value = (value | (value << 2))  & 0x09249249;
+    return value;
+  }
+
+  // Maps a coordinate into [0, kMortonMax].  NaNs and values outside the bounds are clamped.
+  unsigned int quantize( float value, float min, float scale ) {
+    const float q = (value - min) * scale;
+    if( !(q > 0.0f) ) {
+      return 0;
+    }
+    return (q >= static_cast<float>(kMortonMax)) ? kMortonMax : static_cast<unsigned int>(q);
+  }
+
+  // Sorts records by the Morton code of their position within the bounds of all of them.  The sort is an LSD radix
+  // sort and therefore stable, so records at the same position keep their relative order.
+  template<typename Record>
+  void mortonSort( std::vector<Record>* records, std::vector<unsigned int>* outRemap ) {
+    const unsigned int count = records->size();
+    if( outRemap != nullptr ) {
+      outRemap->resize(count);
+      for( unsigned int i = 0; i < count; ++i ) {
+        (*outRemap)[i] = i;
+      }
+    }
+    if( count < 2 ) {
+      return;
+    }
+
+    Scene::Vector min((*records)[0].position);
+    Scene::Vector max((*records)[0].position);
+    for( unsigned int i = 1; i < count; ++i ) {
+      const Scene::Vector& p = (*records)[i].position;
+      min = Scene::Vector(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+      max = Scene::Vector(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+    // One scale for all axes keeps cells cubic, so no axis dominates the order.
+    const float extent = std::max(std::max(max.x - min.x, max.y - min.y), max.z - min.z);
+    const float scale  = (extent > 0.0f) ? static_cast<float>(kMortonMax) / extent : 0.0f;
+
+    std::vector<unsigned int> codes(count);
+    std::vector<unsigned int> order(count);
+    for( unsigned int i = 0; i < count; ++i ) {
+      const Scene::Vector& p = (*records)[i].position;
+      codes[i] = spreadBits(quantize(p.x, min.x, scale)) |
+                 (spreadBits(quantize(p.y, min.y, scale)) << 1) |
+                 (spreadBits(quantize(p.z, min.z, scale)) << 2);
+      order[i] = i;
+    }
+
+    std::vector<unsigned int> nextCodes(count);
+    std::vector<unsigned int> nextOrder(count);
+    std::vector<unsigned int> offsets(1 << kMortonRadixBits);
+    for( unsigned int pass = 0; pass < kMortonPasses; ++pass ) {
+      const unsigned int shift = pass * kMortonRadixBits;
+      std::fill(offsets.begin(), offsets.end(), 0);
+      for( unsigned int i = 0; i < count; ++i ) {
+        offsets[(codes[i] >> shift) & kMortonRadixMask] += 1;
+      }
+      unsigned int total = 0;
+      for( unsigned int i = 0; i < offsets.size(); ++i ) {
+        const unsigned int bucket = offsets[i];
+        offsets[i] = total;
+        total     += bucket;
+      }
+      for( unsigned int i = 0; i < count; ++i ) {
+        const unsigned int slot = offsets[(codes[i] >> shift) & kMortonRadixMask]++;
+        nextCodes[slot] = codes[i];
+        nextOrder[slot] = order[i];
+      }
+      codes.swap(nextCodes);
+      order.swap(nextOrder);
+    }
+
+    std::vector<Record> sorted;
+    sorted.reserve(count);
+    for( unsigned int i = 0; i < count; ++i ) {
+      sorted.push_back(std::move((*records)[order[i]]));
+      if( outRemap != nullptr ) {
+        (*outRemap)[order[i]] = i;
+      }
+    }
+    records->swap(sorted);
+  }
+
+  const char         kBinaryMagic[8]  = { 'S', 'C', 'N', 'B', 'I', 'N', 'A', 'R' };
+  const unsigned int kBinaryVersion   = 3;
+  const char         kJournalMagic[8] = { 'S', 'C', 'N', 'J', 'O', 'U', 'R', 'N' };
+  const unsigned int kJournalVersion  = 1;
+
+  template<typename T>
+  bool writeValue( FILE* f, const T& value ) {
+    return fwrite(&value, sizeof(T), 1, f) == 1;
+  }
+
+  template<typename T>
+  bool readValue( FILE* f, T* value ) {
+    return fread(value, sizeof(T), 1, f) == 1;
+  }
+
+  // Writes a record's fields in schema order.  Strings are a length followed by the characters, vectors three
+  // floats, bools one byte, and light types and references 32-bit integers.
+  template<typename Record>
+  class BinaryWriter {
+  public:
+    BinaryWriter( FILE* f, const Record& record )
+      : _f(f), _record(record), _ok(true) {
+    }
+
+    template<typename T, typename D>
+    void operator()( const char*, T Record::* member, sceneschema::FieldKind, const D& ) {
+      _ok = _ok && write(_record.*member);
+    }
+
+    bool ok() const {
+      return _ok;
+    }
+
+  private:
+    bool write( const std::string& value ) {
+      const unsigned int length = value.size();
+      return writeValue(_f, length) && (length == 0 || fwrite(value.data(), sizeof(char), length, _f) == length);
+    }
+
+    bool write( const Scene::Vector& value ) {
+      return writeValue(_f, value.x) && writeValue(_f, value.y) && writeValue(_f, value.z);
+    }
+
+    bool write( bool value ) {
+      return writeValue(_f, static_cast<unsigned char>(value ? 1 : 0));
+    }
+
+    bool write( Scene::LightType value ) {
+      return writeValue(_f, static_cast<unsigned int>(value));
+    }
+
+    bool write( float value ) {
+      return writeValue(_f, value);
+    }
+
+    bool write( int value ) {
+      return writeValue(_f, value);
+    }
+
+  private:
+    FILE* const   _f;
+    const Record& _record;
+    bool          _ok;
+  };
+
+  // Reads what BinaryWriter wrote.  When reading into a Scene, references are checked against the records already
+  // read, which is why textures, meshes, and materials come first in the file.
+  template<typename Record>
+  class BinaryReader {
+  public:
+    BinaryReader( FILE* f, const Scene* scene, Record& record )
+      : _f(f), _scene(scene), _record(record), _ok(true) {
+    }
+
+    template<typename T, typename D>
+    void operator()( const char*, T Record::* member, sceneschema::FieldKind kind, const D& ) {
+      _ok = _ok && read(&(_record.*member), kind);
+    }
+
+    bool ok() const {
+      return _ok;
+    }
+
+  private:
+    bool read( std::string* out, sceneschema::FieldKind ) {
+      unsigned int length = 0;
+      if( !readValue(_f, &length) ) {
+        return false;
+      }
+      out->resize(length);
+      return length == 0 || fread(&(*out)[0], sizeof(char), length, _f) == length;
+    }
+
+    bool read( Scene::Vector* out, sceneschema::FieldKind ) {
+      return readValue(_f, &out->x) && readValue(_f, &out->y) && readValue(_f, &out->z);
+    }
+
+    bool read( bool* out, sceneschema::FieldKind ) {
+      unsigned char value = 0;
+      if( !readValue(_f, &value) ) {
+        return false;
+      }
+      *out = value != 0;
+      return true;
+    }
+
+    bool read( Scene::LightType* out, sceneschema::FieldKind ) {
+      unsigned int value = 0;
+      if( !readValue(_f, &value) || value > Scene::kLightTypeDirectional ) {
+        return false;
+      }
+      *out = static_cast<Scene::LightType>(value);
+      return true;
+    }
+
+    bool read( float* out, sceneschema::FieldKind ) {
+      return readValue(_f, out);
+    }
+
+    bool read( int* out, sceneschema::FieldKind kind ) {
+      if( !readValue(_f, out) ) {
+        return false;
+      }
+      if( _scene == nullptr ) {
+        return *out >= -1;
+      }
+      unsigned int count = 0;
+      switch( kind ) {
+        case sceneschema::kFieldKindTextureRef: {
+          count = _scene->textureCount();
+          break;
+        }
+        case sceneschema::kFieldKindMeshRef: {
+          count = _scene->meshCount();
+          break;
+        }
+        case sceneschema::kFieldKindMaterialRef: {
+          count = _scene->materialCount();
+          break;
+        }
+        case sceneschema::kFieldKindObjectRef: {
+          count = _scene->objectCount();
+          break;
+        }
+        default: {
+          break;
+        }
+      }
+      return *out >= -1 && *out < static_cast<int>(count);
+    }
+
+  private:
+    FILE* const  _f;
+    const Scene* _scene;
+    Record&      _record;
+    bool         _ok;
+  };
+
+  template<typename Record>
+  bool writeRecords( FILE* f, const std::vector<Record>& records ) {
+    bool ok = writeValue(f, static_cast<unsigned int>(records.size()));
+    for( unsigned int i = 0; ok && i < records.size(); ++i ) {
+      BinaryWriter<Record> writer(f, records[i]);
+      sceneschema::Schema<Record>::fields(writer);
+      ok = writer.ok();
+    }
+    return ok;
+  }
+
+  // Tracks are a header followed by their times and then their values.
+  bool writeTracks( FILE* f, const std::vector<Scene::Track>& tracks ) {
+    bool ok = writeValue(f, static_cast<unsigned int>(tracks.size()));
+    for( unsigned int i = 0; ok && i < tracks.size(); ++i ) {
+      const Scene::Track& track = tracks[i];
+      const unsigned int  keys  = track.times.size();
+      ok = writeValue(f, static_cast<unsigned int>(track.targetType)) && writeValue(f, track.target);
+      ok = ok && writeValue(f, static_cast<unsigned int>(track.channel)) && writeValue(f, static_cast<unsigned int>(track.interpolation));
+      ok = ok && writeValue(f, keys) && fwrite(&track.times[0], sizeof(float), keys, f) == keys;
+      for( unsigned int j = 0; ok && j < keys; ++j ) {
+        ok = writeValue(f, track.values[j].x) && writeValue(f, track.values[j].y) && writeValue(f, track.values[j].z);
+      }
+    }
+    return ok;
+  }
+
+  bool readTracks( FILE* f, const Scene& scene, std::vector<Scene::Track>* tracks ) {
+    unsigned int count = 0;
+    if( !readValue(f, &count) ) {
+      return false;
+    }
+    tracks->resize(count);
+    bool ok = true;
+    for( unsigned int i = 0; ok && i < count; ++i ) {
+      Scene::Track& track         = (*tracks)[i];
+      unsigned int  targetType    = 0;
+      unsigned int  channel       = 0;
+      unsigned int  interpolation = 0;
+      unsigned int  keys          = 0;
+      ok = readValue(f, &targetType) && readValue(f, &track.target) && readValue(f, &channel) && readValue(f, &interpolation);
+      ok = ok && targetType <= Scene::kTrackTargetLight && channel < kTrackChannelCount && interpolation < kInterpolationCount;
+      ok = ok && track.target >= 0 && track.target < static_cast<int>((targetType == Scene::kTrackTargetObject) ? scene.objectCount() : scene.lightCount());
+      ok = ok && readValue(f, &keys) && keys > 0;
+      if( !ok ) {
+        break;
+      }
+      track.targetType    = static_cast<Scene::TrackTarget>(targetType);
+      track.channel       = static_cast<Scene::TrackChannel>(channel);
+      track.interpolation = static_cast<Scene::Interpolation>(interpolation);
+      track.times.resize(keys);
+      track.values.resize(keys);
+      ok = fread(&track.times[0], sizeof(float), keys, f) == keys;
+      for( unsigned int j = 0; ok && j < keys; ++j ) {
+        ok = readValue(f, &track.values[j].x) && readValue(f, &track.values[j].y) && readValue(f, &track.values[j].z);
+      }
+    }
+    return ok;
+  }
+
+  template<typename Record>
+  bool readRecords( FILE* f, const Scene* scene, std::vector<Record>* records ) {
+    unsigned int count = 0;
+    if( !readValue(f, &count) ) {
+      return false;
+    }
+    records->resize(count);
+    bool ok = true;
+    for( unsigned int i = 0; ok && i < count; ++i ) {
+      BinaryReader<Record> reader(f, scene, (*records)[i]);
+      sceneschema::Schema<Record>::fields(reader);
+      ok = reader.ok();
+    }
+    return ok;
+  }
+}
+
+void Scene::Texture::reset() {
+  sceneschema::reset(*this);
+}
+
+void Scene::Mesh::reset() {
+  sceneschema::reset(*this);
+}
+
+void Scene::Material::reset() {
+  sceneschema::reset(*this);
+}
+
+void Scene::Object::reset() {
+  sceneschema::reset(*this);
+}
+
+void Scene::Light::reset() {
+  sceneschema::reset(*this);
+}
+
 Scene::Scene()
-  : _parserState(kParserStateWhitespace) {
+  : _parserState(kParserStateWhitespace), _editing(false) {
+#ifdef SCENE_ENABLE_LOAD_STATS
+  _activeStats = nullptr;
+#endif
+}
+
+Scene::~Scene() {
+}
+
+bool Scene::load( const std::string& file ) {
+  return load(file, _fileBuffer);
+}
+
+bool Scene::load( const std::string& file, std::vector<char>& buffer ) {
+  return load(file, buffer, nullptr);
+}
+
+bool Scene::load( const std::string& file, std::vector<char>& buffer, LoadProgress* progress ) {
+  // Clean the Scene so it's nice and fresh.
+  clean();
+
+#ifdef SCENE_ENABLE_LOAD_STATS
+  _loadStats.reset();
+#ifdef SCENE_LOAD_STATS_COUNT_ALLOCATIONS
+  const unsigned long long allocationsBefore = sceneLoadStatsAllocationCount();
+#endif
+#endif
+  SCENE_STATS_START(fileReadStart);
+
+  // Open the file.
+  FILE* const f = fopen(file.c_str(), "rb");
+  // NOTE: Comment out the above line and uncomment the two lines below if using Visual Studio.  Microsoft seem to have
+  //       a penchant for not using the right syntax.
+  //FILE* f = nullptr;
+  //f = std::fopen(file.c_str(), "rb");
+
+  // If it failed to open, return.
+  if( f == nullptr ) {
+    return false;
+  }
+
+  // Get the size of the file.
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  // If there's no size, return.
+  if( size == 0 ) {
+    fclose(f);
+    return false;
+  }
+  if( progress != nullptr ) {
+    progress->bytesTotal = size;
+  }
+
+  // Read the entire file into a big buffer. Buffer should be one extra character to
+  // enforce a null terminator, as fread apparently ignores them?  The buffer is provided
+  // by the caller so that its capacity can be reused across loads.
+  buffer.resize(size+1);
+  memset(&buffer[0], 0, sizeof(char) * size);
+  fread(&buffer[0], sizeof(char), size, f);
+  // Append null terminator.
+  buffer[size] = '\0';
+
+  // Close the file.
+  fclose(f);
+
+  SCENE_STATS_STOP(fileReadStart, _loadStats.fileReadSeconds);
+
+  // Parse the entire buffer.
+  const bool parsed = parseBuffer(&buffer[0], size, progress);
+
+#if defined(SCENE_ENABLE_LOAD_STATS) && defined(SCENE_LOAD_STATS_COUNT_ALLOCATIONS)
+  _loadStats.allocations = sceneLoadStatsAllocationCount() - allocationsBefore;
+#endif
+
+  return parsed;
+}
+
+bool Scene::loadFromMemory( const char* text, long size ) {
+  // Clean the Scene so it's nice and fresh.
+  clean();
+
+#ifdef SCENE_ENABLE_LOAD_STATS
+  _loadStats.reset();
+#ifdef SCENE_LOAD_STATS_COUNT_ALLOCATIONS
+  const unsigned long long allocationsBefore = sceneLoadStatsAllocationCount();
+#endif
+#endif
+
+  // If there's no text, return.
+  if( text == nullptr || size <= 0 ) {
+    return false;
+  }
+
+  parseBuffer(text, size);
+
+#if defined(SCENE_ENABLE_LOAD_STATS) && defined(SCENE_LOAD_STATS_COUNT_ALLOCATIONS)
+  _loadStats.allocations = sceneLoadStatsAllocationCount() - allocationsBefore;
+#endif
+
+  return true;
+}
+
+bool Scene::parseBlocks( const char* text, long size, std::vector<Object>* outObjects, std::vector<Light>* outLights, std::vector<Material>* outMaterials ) const {
+  if( text == nullptr || outObjects == nullptr || outLights == nullptr ) {
+    return false;
+  }
+
+  // Only [obj], [light], and [material] blocks are recognized, so there's no need for the full parser state.  Lines
+  // outside of a block are ignored.
+  Object    tmpObject;
+  Light     tmpLight;
+  Material  tmpMaterial;
+  bool      inObject   = false;
+  bool      inLight    = false;
+  bool      inMaterial = false;
+  long      index      = 0;
+  std::vector<std::string> split;
+  while( index < size && text[index] != '\0' ) {
+    // Find the end of the current line.
+    long end = index;
+    while( end < size && text[end] != '\r' && text[end] != '\n' && text[end] != '\0' ) {
+      end += 1;
+    }
+    if( end == index ) {
+      index += 1;
+      continue;
+    }
+    const std::string line = strutils::removeSpaces(std::string(&text[index], end - index));
+    index = end + 1;
+
+    if( strcmp(line.c_str(), "[obj]") == 0 ) {
+      tmpObject.reset();
+      inObject = true;
+      continue;
+    }
+    if( strcmp(line.c_str(), "[/obj]") == 0 ) {
+      if( inObject ) {
+        outObjects->push_back(tmpObject);
+      }
+      inObject = false;
+      continue;
+    }
+    if( strcmp(line.c_str(), "[light]") == 0 ) {
+      tmpLight.reset();
+      inLight = true;
+      continue;
+    }
+    if( strcmp(line.c_str(), "[/light]") == 0 ) {
+      if( inLight ) {
+        outLights->push_back(tmpLight);
+      }
+      inLight = false;
+      continue;
+    }
+    if( outMaterials != nullptr && strcmp(line.c_str(), "[material]") == 0 ) {
+      tmpMaterial.reset();
+      inMaterial = true;
+      continue;
+    }
+    if( outMaterials != nullptr && strcmp(line.c_str(), "[/material]") == 0 ) {
+      if( inMaterial ) {
+        outMaterials->push_back(tmpMaterial);
+      }
+      inMaterial = false;
+      continue;
+    }
+    if( !inObject && !inLight && !inMaterial ) {
+      continue;
+    }
+
+    // Split the string via '='.
+    split.clear();
+    strutils::splitString(line.c_str(), line.size(), '=', false, &split);
+    if( split.size() < 2 ) {
+      continue;
+    }
+    if( inObject ) {
+      parseField(split[0], split[1], tmpObject);
+    } else if( inLight ) {
+      parseField(split[0], split[1], tmpLight);
+    } else {
+      parseField(split[0], split[1], tmpMaterial);
+    }
+  }
+
+  return true;
+}
+
+bool Scene::save( const std::string& file, unsigned int threadCount ) const {
+  // Checked before opening so that a failure leaves the file as it was.
+  if( !savesAsText() ) {
+    return false;
+  }
+  std::ofstream stream(file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if( !stream.is_open() ) {
+    return false;
+  }
+  return writeText(stream, threadCount);
+}
+
+bool Scene::save( std::ostream& stream, unsigned int threadCount ) const {
+  return savesAsText() && writeText(stream, threadCount);
+}
+
+bool Scene::writeText( std::ostream& stream, unsigned int threadCount ) const {
+  // Everything is formatted into one large buffer which is written out whenever it fills up.
+  std::string buffer;
+  buffer.reserve(kSaveFlushSize + 4096);
+
+  buffer.append("[scene]\n  [resources]\n");
+  appendRecords(stream, &buffer, *this, _textures);
+  appendRecords(stream, &buffer, *this, _meshes);
+  appendRecords(stream, &buffer, *this, _materials);
+  buffer.append("  [/resources]\n");
+
+  if( threadCount <= 1 ) {
+    buffer.append("  [objects]\n");
+    appendRecords(stream, &buffer, *this, _objects);
+    buffer.append("  [/objects]\n  [lights]\n");
+    appendRecords(stream, &buffer, *this, _lights);
+    buffer.append("  [/lights]\n");
+  } else {
+    // Format objects and lights in chunks on threadCount threads, counting this one, then write the chunks out in
+    // order.  There are a few chunks per thread so that threads that finish early can help with the rest.
+    stream.write(buffer.data(), buffer.size());
+    buffer.clear();
+
+    const unsigned int        chunkCount   = threadCount * 4;
+    const unsigned int        objectChunk  = std::max<unsigned int>((_objects.size() + chunkCount - 1) / chunkCount, 1);
+    const unsigned int        lightChunk   = std::max<unsigned int>((_lights.size() + chunkCount - 1) / chunkCount, 1);
+    const unsigned int        objectChunks = (_objects.size() + objectChunk - 1) / objectChunk;
+    std::vector<std::string>  chunks(objectChunks + (_lights.size() + lightChunk - 1) / lightChunk);
+    std::atomic<unsigned int> next(0);
+    SaveWorker                worker;
+    worker.scene        = this;
+    worker.objectChunk  = objectChunk;
+    worker.objectChunks = objectChunks;
+    worker.lightChunk   = lightChunk;
+    worker.next         = &next;
+    worker.chunks       = &chunks;
+
+    std::vector<std::thread> threads;
+    for( unsigned int i = 1; i < std::min<unsigned int>(threadCount, chunks.size()); ++i ) {
+      threads.push_back(std::thread(worker));
+    }
+    worker();
+    for( unsigned int i = 0; i < threads.size(); ++i ) {
+      threads[i].join();
+    }
+
+    stream << "  [objects]\n";
+    for( unsigned int i = 0; i < objectChunks; ++i ) {
+      stream.write(chunks[i].data(), chunks[i].size());
+    }
+    stream << "  [/objects]\n  [lights]\n";
+    for( unsigned int i = objectChunks; i < chunks.size(); ++i ) {
+      stream.write(chunks[i].data(), chunks[i].size());
+    }
+    buffer.append("  [/lights]\n");
+  }
+  appendTracks(&buffer, *this);
+  buffer.append("[/scene]\n");
+
+  stream.write(buffer.data(), buffer.size());
+  stream.flush();
+  return !stream.fail();
+}
+
+bool Scene::sortSpatially( std::vector<unsigned int>* outObjectRemap, std::vector<unsigned int>* outLightRemap ) {
+  // The Journal has no way to record a reordering.  Remaps left over from an earlier sort would be wrong now.
+  if( _editing ) {
+    if( outObjectRemap != nullptr ) {
+      outObjectRemap->clear();
+    }
+    if( outLightRemap != nullptr ) {
+      outLightRemap->clear();
+    }
+    return false;
+  }
+
+  std::vector<unsigned int>  localObjectRemap;
+  std::vector<unsigned int>  localLightRemap;
+  std::vector<unsigned int>* objectRemap = (outObjectRemap != nullptr) ? outObjectRemap : &localObjectRemap;
+  std::vector<unsigned int>* lightRemap  = (outLightRemap != nullptr) ? outLightRemap : &localLightRemap;
+  mortonSort(&_objects, objectRemap);
+  mortonSort(&_lights, lightRemap);
+
+  for( unsigned int i = 0; i < _objects.size(); ++i ) {
+    if( _objects[i].parent >= 0 ) {
+      _objects[i].parent = (*objectRemap)[_objects[i].parent];
+    }
+  }
+  for( unsigned int i = 0; i < _tracks.size(); ++i ) {
+    const std::vector<unsigned int>& remap = (_tracks[i].targetType == kTrackTargetObject) ? *objectRemap : *lightRemap;
+    _tracks[i].target = remap[_tracks[i].target];
+  }
+  _slots[kRecordTypeObject].permute(*objectRemap);
+  _slots[kRecordTypeLight].permute(*lightRemap);
+  rebuildIndexes();
+  return true;
+}
+
+bool Scene::saveBinary( const std::string& file ) const {
+  FILE* const f = fopen(file.c_str(), "wb");
+  if( f == nullptr ) {
+    return false;
+  }
+
+  bool ok = fwrite(kBinaryMagic, sizeof(kBinaryMagic), 1, f) == 1;
+  ok = ok && writeValue(f, kBinaryVersion);
+  ok = ok && writeRecords(f, _textures);
+  ok = ok && writeRecords(f, _meshes);
+  ok = ok && writeRecords(f, _materials);
+  ok = ok && writeRecords(f, _objects);
+  ok = ok && writeRecords(f, _lights);
+  ok = ok && writeTracks(f, _tracks);
+
+  fclose(f);
+  return ok;
+}
+
+bool Scene::loadBinary( const std::string& file ) {
+  clean();
+
+  FILE* const f = fopen(file.c_str(), "rb");
+  if( f == nullptr ) {
+    return false;
+  }
+
+  char         magic[sizeof(kBinaryMagic)];
+  unsigned int version = 0;
+  bool ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, kBinaryMagic, sizeof(magic)) == 0;
+  ok = ok && readValue(f, &version) && version == kBinaryVersion;
+  ok = ok && readRecords(f, this, &_textures);
+  ok = ok && readRecords(f, this, &_meshes);
+  ok = ok && readRecords(f, this, &_materials);
+  ok = ok && readRecords(f, this, &_objects) && !hasParentCycle(_objects);
+  ok = ok && readRecords(f, this, &_lights);
+  ok = ok && readTracks(f, *this, &_tracks);
+
+  fclose(f);
+  clearSpares();
+  if( !ok ) {
+    clean();
+    clearSpares();
+    return false;
+  }
+  rebuildIndexes();
+  resetHandles();
+  return true;
+}
+
+void Scene::debugOutput() const {
+  debugRecords("Textures", _textures, false);
+  debugRecords("Meshes", _meshes, false);
+  debugRecords("Materials", _materials, false);
+  debugRecords("Objects", _objects, true);
+  debugRecords("Lights", _lights, true);
+
+  // Output all Tracks.
+  std::clog << "Tracks: " << _tracks.size() << std::endl;
+  for( unsigned int i = 0; i < _tracks.size(); ++i ) {
+    const Track& track = _tracks[i];
+
+    std::clog << "[" << i << "]." << ((track.targetType == kTrackTargetObject) ? "object" : "light") << " = " << track.target << std::endl;
+    std::clog << "[" << i << "].channel = " << kTrackChannelNames[track.channel] << std::endl;
+    std::clog << "[" << i << "].interpolation = " << kInterpolationNames[track.interpolation] << std::endl;
+    std::clog << "[" << i << "].keys = " << track.times.size() << std::endl;
+
+    std::clog << std::endl;
+  }
+}
+
+const std::vector<Scene::Object>& Scene::objects() const {
+  return _objects;
+}
+
+const std::vector<Scene::Texture>& Scene::textures() const {
+  return _textures;
+}
+
+const std::vector<Scene::Mesh>& Scene::meshes() const {
+  return _meshes;
+}
+
+const std::vector<Scene::Material>& Scene::materials() const {
+  return _materials;
+}
+
+const std::vector<Scene::Light>& Scene::lights() const {
+  return _lights;
+}
+
+const std::vector<Scene::Track>& Scene::tracks() const {
+  return _tracks;
+}
+
+unsigned int Scene::objectCount() const {
+  return _objects.size();
+}
+
+unsigned int Scene::textureCount() const {
+  return _textures.size();
+}
+
+unsigned int Scene::meshCount() const {
+  return _meshes.size();
+}
+
+unsigned int Scene::materialCount() const {
+  return _materials.size();
+}
+
+unsigned int Scene::lightCount() const {
+  return _lights.size();
+}
+
+unsigned int Scene::trackCount() const {
+  return _tracks.size();
+}
+
+int Scene::findObject( const std::string& name ) const {
+  return _objectNames.find(_objects, name);
+}
+
+Scene::IndexList Scene::meshUsers( unsigned int mesh ) const {
+  return _meshUsers.list(mesh);
+}
+
+Scene::IndexList Scene::materialUsers( unsigned int material ) const {
+  return _materialUsers.list(material);
+}
+
+Scene::IndexList Scene::textureUsers( unsigned int texture ) const {
+  return _textureUsers.list(texture);
+}
+
+void Scene::SlotMap::reset( unsigned int count ) {
+  // Slots from before are kept, with new generations, so that no old handle finds one of the new records.
+  const unsigned int previous = indexOfSlot.size();
+  const unsigned int slots    = std::max(previous, count);
+  indexOfSlot.resize(slots);
+  generationOfSlot.resize(slots, 0);
+  slotOfIndex.resize(count);
+  freeSlots.clear();
+  freeSlots.reserve(slots);
+  for( unsigned int i = 0; i < previous; ++i ) {
+    generationOfSlot[i] += 1;
+  }
+  for( unsigned int i = 0; i < count; ++i ) {
+    indexOfSlot[i] = i;
+    slotOfIndex[i] = i;
+  }
+  for( unsigned int i = slots; i > count; --i ) {
+    indexOfSlot[i - 1] = kNone;
+    freeSlots.push_back(i - 1);
+  }
+}
+
+void Scene::SlotMap::permute( const std::vector<unsigned int>& remap ) {
+  std::vector<unsigned int> slots(slotOfIndex.size());
+  for( unsigned int i = 0; i < slotOfIndex.size(); ++i ) {
+    slots[remap[i]]             = slotOfIndex[i];
+    indexOfSlot[slotOfIndex[i]] = remap[i];
+  }
+  slotOfIndex.swap(slots);
+}
+
+int Scene::SlotMap::find( Handle handle ) const {
+  if( handle.slot >= indexOfSlot.size() || generationOfSlot[handle.slot] != handle.generation || indexOfSlot[handle.slot] == kNone ) {
+    return -1;
+  }
+  return indexOfSlot[handle.slot];
+}
+
+int Scene::SlotMap::at( unsigned int slot ) const {
+  if( slot >= indexOfSlot.size() || indexOfSlot[slot] == kNone ) {
+    return -1;
+  }
+  return indexOfSlot[slot];
+}
+
+Scene::Handle Scene::SlotMap::acquire() {
+  if( freeSlots.empty() ) {
+    indexOfSlot.push_back(kNone);
+    generationOfSlot.push_back(0);
+    return Handle(indexOfSlot.size() - 1, 0);
+  }
+  const unsigned int slot = freeSlots.back();
+  freeSlots.pop_back();
+  return Handle(slot, generationOfSlot[slot]);
+}
+
+bool Scene::SlotMap::reclaim( Handle* handle ) {
+  if( freeSlots.empty() ) {
+    if( handle->slot != indexOfSlot.size() ) {
+      return false;
+    }
+    indexOfSlot.push_back(kNone);
+    generationOfSlot.push_back(handle->generation);
+    return true;
+  }
+  if( freeSlots.back() != handle->slot ) {
+    return false;
+  }
+  freeSlots.pop_back();
+  handle->generation = std::max(handle->generation, generationOfSlot[handle->slot]);
+  generationOfSlot[handle->slot] = handle->generation;
+  return true;
+}
+
+void Scene::SlotMap::release( unsigned int slot ) {
+  indexOfSlot[slot]       = kNone;
+  generationOfSlot[slot] += 1;
+  freeSlots.push_back(slot);
+}
+
+void Scene::NameIndex::clear() {
+  for( unsigned int i = 0; i < entries.size(); ++i ) {
+    entries[i].index = -1;
+  }
+  count = 0;
+  previous.clear();
+  next.clear();
+}
+
+void Scene::NameIndex::reserve( unsigned int names ) {
+  if( names * 2 > entries.size() ) {
+    unsigned int size = 16;
+    while( size < names * 2 ) {
+      size *= 2;
+    }
+    rehash(size);
+  }
+}
+
+template<typename Record>
+int Scene::NameIndex::find( const std::vector<Record>& records, const std::string& name ) const {
+  if( entries.empty() ) {
+    return -1;
+  }
+  const unsigned int mask = entries.size() - 1;
+  const unsigned int hash = hashName(name);
+  for( unsigned int i = hash & mask; entries[i].index != -1; i = (i + 1) & mask ) {
+    if( entries[i].hash == hash && *EditTraits<Record>::name(records[entries[i].index]) == name ) {
+      return entries[i].index;
+    }
+  }
+  return -1;
+}
+
+template<typename Record>
+void Scene::NameIndex::insert( const std::vector<Record>& records, unsigned int index ) {
+  reserve(count + 1);
+  cover(index);
+  previous[index] = -1;
+  next[index]     = -1;
+
+  const std::string& name = *EditTraits<Record>::name(records[index]);
+  const unsigned int mask = entries.size() - 1;
+  const unsigned int hash = hashName(name);
+  unsigned int       i    = hash & mask;
+  for( ; entries[i].index != -1; i = (i + 1) & mask ) {
+    if( entries[i].hash == hash && *EditTraits<Record>::name(records[entries[i].index]) == name ) {
+      // Go in just after the first record, which keeps the name.
+      const int first = entries[i].index;
+      previous[index] = first;
+      next[index]     = next[first];
+      if( next[first] != -1 ) {
+        previous[next[first]] = index;
+      }
+      next[first] = index;
+      return;
+    }
+  }
+  entries[i].hash  = hash;
+  entries[i].index = index;
+  count += 1;
+}
+
+void Scene::NameIndex::erase( const std::string& name, unsigned int index ) {
+  if( entries.empty() || index >= previous.size() ) {
+    return;
+  }
+  const int before = previous[index];
+  const int after  = next[index];
+  previous[index] = -1;
+  next[index]     = -1;
+  if( after != -1 ) {
+    previous[after] = before;
+  }
+  if( before != -1 ) {
+    next[before] = after;
+    return;
+  }
+
+  // The record is first in its chain, so the name's entry maps to it.
+  const unsigned int mask = entries.size() - 1;
+  const unsigned int hash = hashName(name);
+  unsigned int       i    = hash & mask;
+  for( ; entries[i].index != static_cast<int>(index) || entries[i].hash != hash; i = (i + 1) & mask ) {
+    if( entries[i].index == -1 ) {
+      return;
+    }
+  }
+  if( after != -1 ) {
+    entries[i].index = after;
+    return;
+  }
+
+  // Shift back any later entries in the run that can then be found sooner, so that no search stops short at the
+  // gap.  An entry can move into the gap if the gap lies cyclically between its home and where it is now.
+  for( unsigned int j = (i + 1) & mask; entries[j].index != -1; j = (j + 1) & mask ) {
+    const unsigned int home = entries[j].hash & mask;
+    if( ((j - home) & mask) >= ((j - i) & mask) ) {
+      entries[i] = entries[j];
+      i          = j;
+    }
+  }
+  entries[i].index = -1;
+  count -= 1;
+}
+
+void Scene::NameIndex::move( const std::string& name, unsigned int from, unsigned int to ) {
+  if( entries.empty() || from >= previous.size() ) {
+    return;
+  }
+  cover(to);
+  const int before = previous[from];
+  const int after  = next[from];
+  previous[to]   = before;
+  next[to]       = after;
+  previous[from] = -1;
+  next[from]     = -1;
+  if( after != -1 ) {
+    previous[after] = to;
+  }
+  if( before != -1 ) {
+    next[before] = to;
+    return;
+  }
+
+  const unsigned int mask = entries.size() - 1;
+  const unsigned int hash = hashName(name);
+  for( unsigned int i = hash & mask; entries[i].index != -1; i = (i + 1) & mask ) {
+    if( entries[i].index == static_cast<int>(from) && entries[i].hash == hash ) {
+      entries[i].index = to;
+      return;
+    }
+  }
+}
+
+void Scene::NameIndex::rehash( unsigned int size ) {
+  std::vector<Entry> old(size);
+  old.swap(entries);
+  for( unsigned int i = 0; i < entries.size(); ++i ) {
+    entries[i].index = -1;
+  }
+  const unsigned int mask = size - 1;
+  for( unsigned int i = 0; i < old.size(); ++i ) {
+    if( old[i].index == -1 ) {
+      continue;
+    }
+    unsigned int slot = old[i].hash & mask;
+    while( entries[slot].index != -1 ) {
+      slot = (slot + 1) & mask;
+    }
+    entries[slot] = old[i];
+  }
+}
+
+bool Scene::NameIndex::shared( unsigned int index ) const {
+  return index < previous.size() && (previous[index] != -1 || next[index] != -1);
+}
+
+void Scene::NameIndex::cover( unsigned int index ) {
+  if( index >= previous.size() ) {
+    previous.resize(index + 1, -1);
+    next.resize(index + 1, -1);
+  }
+}
+
+void Scene::ReferenceIndex::reset( unsigned int fields, unsigned int targetCount, unsigned int referrerCount ) {
+  // Lists are emptied rather than freed, so that relinking the same records doesn't allocate.
+  fieldCount = fields;
+  for( unsigned int i = 0; i < std::min<unsigned int>(this->targetCount, referrers.size()); ++i ) {
+    referrers[i].clear();
+  }
+  resizeTargets(targetCount);
+  links.assign(referrerCount * fieldCount, -1);
+  places.assign(referrerCount * fieldCount, 0);
+}
+
+void Scene::ReferenceIndex::resizeTargets( unsigned int count ) {
+  for( unsigned int i = count; i < targetCount; ++i ) {
+    referrers[i].clear();
+  }
+  if( referrers.size() < count ) {
+    referrers.resize(count);
+  }
+  targetCount = count;
+}
+
+void Scene::ReferenceIndex::resizeReferrers( unsigned int count ) {
+  links.resize(count * fieldCount, -1);
+  places.resize(count * fieldCount, 0);
+}
+
+void Scene::ReferenceIndex::link( unsigned int referrer, const int* targets ) {
+  unlink(referrer);
+  for( unsigned int field = 0; field < fieldCount; ++field ) {
+    const int target   = targets[field];
+    bool      repeated = false;
+    for( unsigned int other = 0; other < field; ++other ) {
+      repeated = repeated || targets[other] == target;
+    }
+    if( target < 0 || target >= static_cast<int>(targetCount) || repeated ) {
+      continue;
+    }
+    const unsigned int entry = referrer * fieldCount + field;
+    links[entry]  = target;
+    places[entry] = referrers[target].size();
+    referrers[target].push_back(referrer);
+  }
+}
+
+void Scene::ReferenceIndex::unlink( unsigned int referrer ) {
+  for( unsigned int field = 0; field < fieldCount; ++field ) {
+    const unsigned int entry  = referrer * fieldCount + field;
+    const int          target = links[entry];
+    if( target < 0 ) {
+      continue;
+    }
+
+    // Fill the gap with the last referrer in the list.  A referrer links to any one target through one field at most.
+    std::vector<unsigned int>& list  = referrers[target];
+    const unsigned int         moved = list.back();
+    list[places[entry]] = moved;
+    for( unsigned int other = 0; other < fieldCount; ++other ) {
+      if( links[moved * fieldCount + other] == target ) {
+        places[moved * fieldCount + other] = places[entry];
+      }
+    }
+    list.pop_back();
+    links[entry] = -1;
+  }
+}
+
+void Scene::ReferenceIndex::moveReferrer( unsigned int from, unsigned int to ) {
+  for( unsigned int field = 0; field < fieldCount; ++field ) {
+    const unsigned int source      = from * fieldCount + field;
+    const unsigned int destination = to * fieldCount + field;
+    links[destination]  = links[source];
+    places[destination] = places[source];
+    if( links[source] >= 0 ) {
+      referrers[links[source]][places[source]] = to;
+    }
+    links[source] = -1;
+  }
+}
+
+void Scene::ReferenceIndex::moveTarget( unsigned int from, unsigned int to ) {
+  referrers[to].swap(referrers[from]);
+  const std::vector<unsigned int>& list = referrers[to];
+  for( unsigned int i = 0; i < list.size(); ++i ) {
+    for( unsigned int field = 0; field < fieldCount; ++field ) {
+      if( links[list[i] * fieldCount + field] == static_cast<int>(from) ) {
+        links[list[i] * fieldCount + field] = to;
+      }
+    }
+  }
+}
+
+Scene::IndexList Scene::ReferenceIndex::list( unsigned int target ) const {
+  IndexList result;
+  if( target < targetCount && !referrers[target].empty() ) {
+    result.data  = &referrers[target][0];
+    result.count = referrers[target].size();
+  }
+  return result;
+}
+
+// Each kind of record's storage and name lookup, the checks on its references, and how it is linked into the
+// reference indexes, both as a referrer and as a target.  move() carries a record's links, and the references to
+// it, over to an index that has none.
+template<>
+struct Scene::EditTraits<Scene::Texture> {
+  static const RecordType kType = kRecordTypeTexture;
+
+  static std::vector<Texture>& records( Scene& scene ) {
+    return scene._textures;
+  }
+
+  static std::vector<Texture>& journal( Journal& journal ) {
+    return journal.textures;
+  }
+
+  static const std::vector<Texture>& journal( const Journal& journal ) {
+    return journal.textures;
+  }
+
+  static NameIndex* names( Scene& scene ) {
+    return &scene._textureNames;
+  }
+
+  static const std::string* name( const Texture& texture ) {
+    return &texture.name;
+  }
+
+  static bool valid( const Scene&, const Texture&, unsigned int, bool ) {
+    return true;
+  }
+
+  static bool animated( const Scene&, unsigned int ) {
+    return false;
+  }
+
+  static bool referenced( const Scene& scene, unsigned int index ) {
+    return !scene._textureUsers.referrers[index].empty();
+  }
+
+  static void clearReferences( Scene& scene, unsigned int index ) {
+    const std::vector<unsigned int> users = scene._textureUsers.referrers[index];
+    for( unsigned int i = 0; i < users.size(); ++i ) {
+      Material material = scene._materials[users[i]];
+      material.diffuseTex = (material.diffuseTex == static_cast<int>(index)) ? -1 : material.diffuseTex;
+      material.normalTex  = (material.normalTex == static_cast<int>(index)) ? -1 : material.normalTex;
+      scene.modifyRecord(scene.handle(kRecordTypeMaterial, users[i]), material);
+    }
+  }
+
+  static void resize( Scene& scene, unsigned int count ) {
+    scene._textureUsers.resizeTargets(count);
+  }
+
+  static void link( Scene&, unsigned int ) {
+  }
+
+  static void unlink( Scene&, unsigned int ) {
+  }
+
+  static void move( Scene& scene, unsigned int from, unsigned int to ) {
+    scene._textureUsers.moveTarget(from, to);
+    const std::vector<unsigned int>& users = scene._textureUsers.referrers[to];
+    for( unsigned int i = 0; i < users.size(); ++i ) {
+      Material& material = scene._materials[users[i]];
+      material.diffuseTex = (material.diffuseTex == static_cast<int>(from)) ? to : material.diffuseTex;
+      material.normalTex  = (material.normalTex == static_cast<int>(from)) ? to : material.normalTex;
+    }
+  }
+};
+
+template<>
+struct Scene::EditTraits<Scene::Mesh> {
+  static const RecordType kType = kRecordTypeMesh;
+
+  static std::vector<Mesh>& records( Scene& scene ) {
+    return scene._meshes;
+  }
+
+  static std::vector<Mesh>& journal( Journal& journal ) {
+    return journal.meshes;
+  }
+
+  static const std::vector<Mesh>& journal( const Journal& journal ) {
+    return journal.meshes;
+  }
+
+  static NameIndex* names( Scene& scene ) {
+    return &scene._meshNames;
+  }
+
+  static const std::string* name( const Mesh& mesh ) {
+    return &mesh.name;
+  }
+
+  static bool valid( const Scene&, const Mesh&, unsigned int, bool ) {
+    return true;
+  }
+
+  static bool animated( const Scene&, unsigned int ) {
+    return false;
+  }
+
+  static bool referenced( const Scene& scene, unsigned int index ) {
+    return !scene._meshUsers.referrers[index].empty();
+  }
+
+  static void clearReferences( Scene& scene, unsigned int index ) {
+    const std::vector<unsigned int> users = scene._meshUsers.referrers[index];
+    for( unsigned int i = 0; i < users.size(); ++i ) {
+      Object object = scene._objects[users[i]];
+      object.mesh = -1;
+      scene.modifyRecord(scene.handle(kRecordTypeObject, users[i]), object);
+    }
+  }
+
+  static void resize( Scene& scene, unsigned int count ) {
+    scene._meshUsers.resizeTargets(count);
+  }
+
+  static void link( Scene&, unsigned int ) {
+  }
+
+  static void unlink( Scene&, unsigned int ) {
+  }
+
+  static void move( Scene& scene, unsigned int from, unsigned int to ) {
+    scene._meshUsers.moveTarget(from, to);
+    const std::vector<unsigned int>& users = scene._meshUsers.referrers[to];
+    for( unsigned int i = 0; i < users.size(); ++i ) {
+      scene._objects[users[i]].mesh = to;
+    }
+  }
+};
+
+template<>
+struct Scene::EditTraits<Scene::Material> {
+  static const RecordType kType = kRecordTypeMaterial;
+
+  static std::vector<Material>& records( Scene& scene ) {
+    return scene._materials;
+  }
+
+  static std::vector<Material>& journal( Journal& journal ) {
+    return journal.materials;
+  }
+
+  static const std::vector<Material>& journal( const Journal& journal ) {
+    return journal.materials;
+  }
+
+  static NameIndex* names( Scene& scene ) {
+    return &scene._materialNames;
+  }
+
+  static const std::string* name( const Material& material ) {
+    return &material.name;
+  }
+
+  static bool valid( const Scene& scene, const Material& material, unsigned int, bool ) {
+    return inRange(material.diffuseTex, scene._textures.size()) && inRange(material.normalTex, scene._textures.size());
+  }
+
+  static bool animated( const Scene&, unsigned int ) {
+    return false;
+  }
+
+  static bool referenced( const Scene& scene, unsigned int index ) {
+    return !scene._materialUsers.referrers[index].empty();
+  }
+
+  static void clearReferences( Scene& scene, unsigned int index ) {
+    const std::vector<unsigned int> users = scene._materialUsers.referrers[index];
+    for( unsigned int i = 0; i < users.size(); ++i ) {
+      Object object = scene._objects[users[i]];
+      object.material = -1;
+      scene.modifyRecord(scene.handle(kRecordTypeObject, users[i]), object);
+    }
+  }
+
+  static void resize( Scene& scene, unsigned int count ) {
+    scene._materialUsers.resizeTargets(count);
+    scene._textureUsers.resizeReferrers(count);
+  }
+
+  static void link( Scene& scene, unsigned int index ) {
+    const int textures[2] = { scene._materials[index].diffuseTex, scene._materials[index].normalTex };
+    scene._textureUsers.link(index, textures);
+  }
+
+  static void unlink( Scene& scene, unsigned int index ) {
+    scene._textureUsers.unlink(index);
+  }
+
+  static void move( Scene& scene, unsigned int from, unsigned int to ) {
+    scene._textureUsers.moveReferrer(from, to);
+    scene._materialUsers.moveTarget(from, to);
+    const std::vector<unsigned int>& users = scene._materialUsers.referrers[to];
+    for( unsigned int i = 0; i < users.size(); ++i ) {
+      scene._objects[users[i]].material = to;
+    }
+  }
+};
+
+template<>
+struct Scene::EditTraits<Scene::Object> {
+  static const RecordType kType = kRecordTypeObject;
+
+  static std::vector<Object>& records( Scene& scene ) {
+    return scene._objects;
+  }
+
+  static std::vector<Object>& journal( Journal& journal ) {
+    return journal.objects;
+  }
+
+  static const std::vector<Object>& journal( const Journal& journal ) {
+    return journal.objects;
+  }
+
+  static NameIndex* names( Scene& scene ) {
+    return &scene._objectNames;
+  }
+
+  static const std::string* name( const Object& object ) {
+    return &object.name;
+  }
+
+  // When inserting, the object's own index is about to be added, so the parent may be one past the current end.  An
+  // object can't be its own parent or the parent of any of its ancestors.  One being inserted has no children yet,
+  // so only the first can happen to it.
+  static bool valid( const Scene& scene, const Object& object, unsigned int index, bool inserting ) {
+    const unsigned int objects = scene._objects.size() + (inserting ? 1 : 0);
+    const bool         cycle   = inserting ? object.parent == static_cast<int>(index) : reachesAncestor(scene._objects, object.parent, index);
+    return inRange(object.mesh, scene._meshes.size()) && inRange(object.material, scene._materials.size()) && inRange(object.parent, objects) && !cycle;
+  }
+
+  static bool animated( const Scene& scene, unsigned int index ) {
+    return !scene._objectTracks.referrers[index].empty();
+  }
+
+  static bool referenced( const Scene& scene, unsigned int index ) {
+    return !scene._objectChildren.referrers[index].empty() || animated(scene, index);
+  }
+
+  static void clearReferences( Scene& scene, unsigned int index ) {
+    const std::vector<unsigned int> children = scene._objectChildren.referrers[index];
+    for( unsigned int i = 0; i < children.size(); ++i ) {
+      Object object = scene._objects[children[i]];
+      object.parent = -1;
+      scene.modifyRecord(scene.handle(kRecordTypeObject, children[i]), object);
+    }
+  }
+
+  static void resize( Scene& scene, unsigned int count ) {
+    scene._meshUsers.resizeReferrers(count);
+    scene._materialUsers.resizeReferrers(count);
+    scene._objectChildren.resizeReferrers(count);
+    scene._objectChildren.resizeTargets(count);
+    scene._objectTracks.resizeTargets(count);
+  }
+
+  static void link( Scene& scene, unsigned int index ) {
+    const Object& object = scene._objects[index];
+    scene._meshUsers.link(index, &object.mesh);
+    scene._materialUsers.link(index, &object.material);
+    scene._objectChildren.link(index, &object.parent);
+  }
+
+  static void unlink( Scene& scene, unsigned int index ) {
+    scene._meshUsers.unlink(index);
+    scene._materialUsers.unlink(index);
+    scene._objectChildren.unlink(index);
+  }
+
+  static void move( Scene& scene, unsigned int from, unsigned int to ) {
+    scene._meshUsers.moveReferrer(from, to);
+    scene._materialUsers.moveReferrer(from, to);
+    scene._objectChildren.moveReferrer(from, to);
+    scene._objectChildren.moveTarget(from, to);
+    const std::vector<unsigned int>& children = scene._objectChildren.referrers[to];
+    for( unsigned int i = 0; i < children.size(); ++i ) {
+      scene._objects[children[i]].parent = to;
+    }
+    scene._objectTracks.moveTarget(from, to);
+    const std::vector<unsigned int>& tracks = scene._objectTracks.referrers[to];
+    for( unsigned int i = 0; i < tracks.size(); ++i ) {
+      scene._tracks[tracks[i]].target = to;
+    }
+  }
+};
+
+template<>
+struct Scene::EditTraits<Scene::Light> {
+  static const RecordType kType = kRecordTypeLight;
+
+  static std::vector<Light>& records( Scene& scene ) {
+    return scene._lights;
+  }
+
+  static std::vector<Light>& journal( Journal& journal ) {
+    return journal.lights;
+  }
+
+  static const std::vector<Light>& journal( const Journal& journal ) {
+    return journal.lights;
+  }
+
+  // Lights have no names.
+  static NameIndex* names( Scene& ) {
+    return nullptr;
+  }
+
+  static const std::string* name( const Light& ) {
+    return nullptr;
+  }
+
+  static bool valid( const Scene&, const Light&, unsigned int, bool ) {
+    return true;
+  }
+
+  static bool animated( const Scene& scene, unsigned int index ) {
+    return !scene._lightTracks.referrers[index].empty();
+  }
+
+  static bool referenced( const Scene& scene, unsigned int index ) {
+    return animated(scene, index);
+  }
+
+  static void clearReferences( Scene&, unsigned int ) {
+  }
+
+  static void resize( Scene& scene, unsigned int count ) {
+    scene._lightTracks.resizeTargets(count);
+  }
+
+  static void link( Scene&, unsigned int ) {
+  }
+
+  static void unlink( Scene&, unsigned int ) {
+  }
+
+  static void move( Scene& scene, unsigned int from, unsigned int to ) {
+    scene._lightTracks.moveTarget(from, to);
+    const std::vector<unsigned int>& tracks = scene._lightTracks.referrers[to];
+    for( unsigned int i = 0; i < tracks.size(); ++i ) {
+      scene._tracks[tracks[i]].target = to;
+    }
+  }
+};
+
+bool Scene::savesAsText() const {
+  return recordsReadBack(_textures) && recordsReadBack(_meshes) && recordsReadBack(_materials) && recordsReadBack(_objects) && recordsReadBack(_lights) &&
+         namesFindReferrals(_textures, _textureNames) && namesFindReferrals(_meshes, _meshNames) && namesFindReferrals(_materials, _materialNames) && namesFindReferrals(_objects, _objectNames);
 }
 
-Scene::~Scene() {
+// Read back, a name finds the first record with it, so only that record may be referred to.  Records that share
+// their name are walked a chain at a time, from the start of each, for the lowest index in it and the records in it
+// that something refers to.
+template<typename Record>
+bool Scene::namesFindReferrals( const std::vector<Record>& records, const NameIndex& names ) const {
+  for( unsigned int i = 0; i < records.size(); ++i ) {
+    if( records[i].name.empty() && EditTraits<Record>::referenced(*this, i) ) {
+      return false;
+    }
+    if( !names.shared(i) || names.previous[i] != -1 ) {
+      continue;
+    }
+    int lowest   = i;
+    int referred = -1;
+    for( int j = i; j != -1; j = names.next[j] ) {
+      lowest = std::min(lowest, j);
+      if( EditTraits<Record>::referenced(*this, j) ) {
+        if( referred != -1 ) {
+          return false;
+        }
+        referred = j;
+      }
+    }
+    if( referred != -1 && referred != lowest ) {
+      return false;
+    }
+  }
+  return true;
 }
 
-bool Scene::load( const std::string& file ) {
-  // Clean the Scene so it's nice and fresh.
-  clean();
+bool Scene::beginEdit() {
+  if( _editing ) {
+    return false;
+  }
+  _editing = true;
+  _journal.clear();
+  return true;
+}
 
-  // Open the file.
-  FILE* const f = fopen(file.c_str(), "rb");
-  // NOTE: Comment out the above line and uncomment the two lines below if using Visual Studio.  Microsoft seem to have
-  //       a penchant for not using the right syntax.
-  //FILE* f = nullptr;
-  //f = std::fopen(file.c_str(), "rb");
+bool Scene::commitEdit( Journal* outJournal ) {
+  if( !_editing ) {
+    return false;
+  }
+  if( outJournal != nullptr ) {
+    std::swap(*outJournal, _journal);
+  }
+  _journal.clear();
+  _editing = false;
+  return true;
+}
 
-  // If it failed to open, return.
+bool Scene::rollbackEdit() {
+  if( !_editing ) {
+    return false;
+  }
+  // Nothing is journaled once the transaction has ended.
+  _editing = false;
+  for( unsigned int i = _journal.changes.size(); i > 0; --i ) {
+    revertChange(_journal, i - 1);
+  }
+  _journal.clear();
+  return true;
+}
+
+Scene::Handle Scene::add( const Texture& texture ) {
+  return addRecord(texture);
+}
+
+Scene::Handle Scene::add( const Mesh& mesh ) {
+  return addRecord(mesh);
+}
+
+Scene::Handle Scene::add( const Material& material ) {
+  return addRecord(material);
+}
+
+Scene::Handle Scene::add( const Object& object ) {
+  return addRecord(object);
+}
+
+Scene::Handle Scene::add( const Light& light ) {
+  return addRecord(light);
+}
+
+bool Scene::modify( Handle handle, const Texture& texture ) {
+  return modifyRecord(handle, texture);
+}
+
+bool Scene::modify( Handle handle, const Mesh& mesh ) {
+  return modifyRecord(handle, mesh);
+}
+
+bool Scene::modify( Handle handle, const Material& material ) {
+  return modifyRecord(handle, material);
+}
+
+bool Scene::modify( Handle handle, const Object& object ) {
+  return modifyRecord(handle, object);
+}
+
+bool Scene::modify( Handle handle, const Light& light ) {
+  return modifyRecord(handle, light);
+}
+
+bool Scene::remove( RecordType type, Handle handle ) {
+  switch( type ) {
+    case kRecordTypeTexture: {
+      return removeRecord<Texture>(handle);
+    }
+    case kRecordTypeMesh: {
+      return removeRecord<Mesh>(handle);
+    }
+    case kRecordTypeMaterial: {
+      return removeRecord<Material>(handle);
+    }
+    case kRecordTypeObject: {
+      return removeRecord<Object>(handle);
+    }
+    case kRecordTypeLight: {
+      return removeRecord<Light>(handle);
+    }
+    default: {
+      break;
+    }
+  }
+  return false;
+}
+
+Scene::Handle Scene::handle( RecordType type, unsigned int index ) const {
+  if( type > kRecordTypeLight || index >= _slots[type].slotOfIndex.size() ) {
+    return Handle();
+  }
+  const unsigned int slot = _slots[type].slotOfIndex[index];
+  return Handle(slot, _slots[type].generationOfSlot[slot]);
+}
+
+int Scene::indexOf( RecordType type, Handle handle ) const {
+  if( type > kRecordTypeLight ) {
+    return -1;
+  }
+  return _slots[type].find(handle);
+}
+
+// Both run as a transaction of their own, so that a Journal that only partly fits can be rolled back to exactly how
+// things were.
+bool Scene::apply( const Journal& journal ) {
+  if( !beginEdit() ) {
+    return false;
+  }
+  for( unsigned int i = 0; i < journal.changes.size(); ++i ) {
+    if( !applyChange(journal, i) ) {
+      rollbackEdit();
+      return false;
+    }
+  }
+  return commitEdit();
+}
+
+bool Scene::revert( const Journal& journal ) {
+  if( !beginEdit() ) {
+    return false;
+  }
+  for( unsigned int i = journal.changes.size(); i > 0; --i ) {
+    if( !revertChange(journal, i - 1) ) {
+      rollbackEdit();
+      return false;
+    }
+  }
+  return commitEdit();
+}
+
+// A header, then each change as seven 32-bit integers, then the records in the same format as saveBinary().
+bool Scene::saveJournal( const std::string& file, const Journal& journal ) {
+  FILE* const f = fopen(file.c_str(), "wb");
   if( f == nullptr ) {
     return false;
   }
 
-  // Get the size of the file.
-  fseek(f, 0, SEEK_END);
-  const long size = ftell(f);
-  fseek(f, 0, SEEK_SET);
+  bool ok = fwrite(kJournalMagic, sizeof(kJournalMagic), 1, f) == 1;
+  ok = ok && writeValue(f, kJournalVersion);
+  ok = ok && writeValue(f, static_cast<unsigned int>(journal.changes.size()));
+  for( unsigned int i = 0; ok && i < journal.changes.size(); ++i ) {
+    const Change& change = journal.changes[i];
+    ok = writeValue(f, static_cast<unsigned int>(change.type)) && writeValue(f, static_cast<unsigned int>(change.recordType));
+    ok = ok && writeValue(f, change.handle.slot) && writeValue(f, change.handle.generation);
+    ok = ok && writeValue(f, change.index) && writeValue(f, change.before) && writeValue(f, change.after);
+  }
+  ok = ok && writeRecords(f, journal.textures);
+  ok = ok && writeRecords(f, journal.meshes);
+  ok = ok && writeRecords(f, journal.materials);
+  ok = ok && writeRecords(f, journal.objects);
+  ok = ok && writeRecords(f, journal.lights);
 
-  // If there's no size, return.
-  if( size == 0 ) {
-    fclose(f);
+  fclose(f);
+  return ok;
+}
+
+// References are only checked when the Journal is applied or reverted.
+bool Scene::loadJournal( const std::string& file, Journal* outJournal ) {
+  if( outJournal == nullptr ) {
     return false;
   }
+  outJournal->clear();
 
-  // Read the entire file into a big buffer. Buffer should be one extra character to
-  // enforce a null terminator, as fread apparently ignores them?
-  char* buffer = new char[size+1];
-  memset(buffer, 0, sizeof(char) * size);
-  fread(buffer, sizeof(char), size, f);
-  // Append null terminator.
-  buffer[size] = '\0';
+  FILE* const f = fopen(file.c_str(), "rb");
+  if( f == nullptr ) {
+    return false;
+  }
+
+  char         magic[sizeof(kJournalMagic)];
+  unsigned int version = 0;
+  unsigned int count   = 0;
+  bool ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, kJournalMagic, sizeof(magic)) == 0;
+  ok = ok && readValue(f, &version) && version == kJournalVersion;
+  ok = ok && readValue(f, &count);
+  for( unsigned int i = 0; ok && i < count; ++i ) {
+    unsigned int type       = 0;
+    unsigned int recordType = 0;
+    Change       change;
+    ok = readValue(f, &type) && readValue(f, &recordType) && type <= kChangeTypeRemove && recordType <= kRecordTypeLight;
+    ok = ok && readValue(f, &change.handle.slot) && readValue(f, &change.handle.generation);
+    ok = ok && readValue(f, &change.index) && readValue(f, &change.before) && readValue(f, &change.after);
+    change.type       = static_cast<ChangeType>(type);
+    change.recordType = static_cast<RecordType>(recordType);
+    outJournal->changes.push_back(change);
+  }
+  ok = ok && readRecords(f, static_cast<const Scene*>(nullptr), &outJournal->textures);
+  ok = ok && readRecords(f, static_cast<const Scene*>(nullptr), &outJournal->meshes);
+  ok = ok && readRecords(f, static_cast<const Scene*>(nullptr), &outJournal->materials);
+  ok = ok && readRecords(f, static_cast<const Scene*>(nullptr), &outJournal->objects);
+  ok = ok && readRecords(f, static_cast<const Scene*>(nullptr), &outJournal->lights);
+
+  fclose(f);
+  if( !ok ) {
+    outJournal->clear();
+  }
+  return ok;
+}
+
+bool Scene::parseBuffer( const char* buffer, long size, LoadProgress* progress ) {
+#ifdef SCENE_ENABLE_LOAD_STATS
+  // Time spent splitting the buffer into lines, and the total time spent in parseLine(), used to derive the
+  // tokenize and dispatch times.
+  double scanSeconds  = 0.0;
+  double parseSeconds = 0.0;
+  // Stats are only gathered while loading, as the field parsers are also used by parseBlocks().
+  _activeStats = &_loadStats;
+#endif
+
+  // Make room for every block up front, so that nothing grows while parsing.
+  reserveBlocks(buffer, size);
 
-  // Object that will be filled until complete, and then copied into the vector and reset.
+  // Object that will be filled until complete, and then moved into the vector and replaced with a spare.
   Object tmpObject;
-  tmpObject.reset();
-  // Texture that will be filled until complete, and then copied into the vector and reset.
+  _spareObjects.take(&tmpObject);
+  // Texture that will be filled until complete, and then moved into the vector and replaced with a spare.
   Texture tmpTexture;
-  tmpTexture.reset();
-  // Mesh that will be filled until complete, and then copied into the vector and reset.
+  _spareTextures.take(&tmpTexture);
+  // Mesh that will be filled until complete, and then moved into the vector and replaced with a spare.
   Mesh tmpMesh;
-  tmpMesh.reset();
-  // Material that will be filled until complete, and then copied into the vector and reset.
+  _spareMeshes.take(&tmpMesh);
+  // Material that will be filled until complete, and then moved into the vector and replaced with a spare.
   Material tmpMaterial;
-  tmpMaterial.reset();
+  _spareMaterials.take(&tmpMaterial);
   // Light that will be filled until complete, and then copied into the vector and reset.
   Light tmpLight;
   tmpLight.reset();
+  // Track that will be filled until complete, and then moved into the vector and replaced with a spare.
+  Track tmpTrack;
+  _spareTracks.take(&tmpTrack);
 
   // Parse the entire buffer, line-by-line.
-  long index = 0;
-  long end   = 0;
-  char c     = ' ';
-  while( true ) {
+  long         index     = 0;
+  long         end       = 0;
+  char         c         = ' ';
+  unsigned int lines     = 0;
+  bool         cancelled = false;
+  while( !cancelled ) {
     // Safety check for size.
-    if( index > size ) {
+    if( index >= size ) {
       break;
     }
 
@@ -104,7 +2363,12 @@ bool Scene::load( const std::string& file ) {
     end = index;
 
     // Read until we get a new line character.
+    SCENE_STATS_START(scanStart);
     while( true ) {
+      // Check the end of the buffer, as it need not be null terminated.
+      if( end >= size ) {
+        break;
+      }
       // Read the newest char.
       c = buffer[end];
       // If this char is a newline character, break out.
@@ -119,149 +2383,152 @@ bool Scene::load( const std::string& file ) {
     // Check the size of the string we're about to read is > 0.  If not, continue on.
     const long len = end - index;
     if( len <= 0 ) {
+      SCENE_STATS_STOP(scanStart, scanSeconds);
       index += 1;
       continue;
     }
 
     // Read the current range into a string.
-    const std::string currLine(&buffer[index], len);
+    _line.assign(&buffer[index], len);
+    SCENE_STATS_STOP(scanStart, scanSeconds);
+
     // Parse the line!
-    parseLine(currLine, tmpObject, tmpTexture, tmpMesh, tmpMaterial, tmpLight);
+    {
+      SCENE_STATS_TIME(parseSeconds);
+      parseLine(_line, tmpObject, tmpTexture, tmpMesh, tmpMaterial, tmpLight, tmpTrack);
+    }
 
-    // Set the new index to the end character (new line) + 1 to read the next character.=
+    // Set the new index to the end character (new line) + 1 to read the next character.
     index = end + 1;
-  }
-
-  // Clean up the buffer.
-  delete[] buffer;
-  buffer = nullptr;
-  
-  // Close the file.
-  fclose(f);
-
-  return true;
-}
 
-void Scene::debugOutput() const {
-  // Output Textures.
-  std::clog << "Textures: " << _textures.size() << std::endl;
-  for( unsigned int i = 0; i < _textures.size(); ++i ) {
-    std::clog << "[" << i << "].file = " << _textures[i].file.c_str() << std::endl;
-    std::clog << "[" << i << "].name = " << _textures[i].name.c_str() << std::endl;
+    lines += 1;
+    if( progress != nullptr && lines % kProgressLines == 0 ) {
+      reportProgress(progress, index);
+      cancelled = progress->cancelled;
+    }
   }
-  std::clog << std::endl;
 
-  // Output Meshes.
-  std::clog << "Meshes: " << _meshes.size() << std::endl;
-  for( unsigned int i = 0; i < _meshes.size(); ++i ) {
-    std::clog << "[" << i << "].file = " << _meshes[i].file.c_str() << std::endl;
-    std::clog << "[" << i << "].name = " << _meshes[i].name.c_str() << std::endl;
+  // A cancelled load leaves nothing behind.
+  if( cancelled ) {
+    SCENE_STATS(_activeStats = nullptr);
+    clean();
+    return false;
   }
-  std::clog << std::endl;
 
-  // Output Materials.
-  std::clog << "Materials: " << _materials.size() << std::endl;
-  for( unsigned int i = 0; i < _materials.size(); ++i ) {
-    const Material& mat = _materials[i];
-    std::clog << "[" << i << "].name = " << mat.name.c_str() << std::endl;
-    std::clog << "[" << i << "].color = " << mat.color.x << ", " << mat.color.y << ", " << mat.color.z << std::endl;
-    std::clog << "[" << i << "].specSize = " << mat.specSize << std::endl;
-    std::clog << "[" << i << "].diffuseTex = " << mat.diffuseTex << std::endl;
-    std::clog << "[" << i << "].normalTex = " << mat.normalTex << std::endl;
+  // Now that every object has been read, resolve the parents that came after their children.  Parents that come
+  // before can't form a cycle between them, so only these are checked, and one that would close a cycle is dropped.
+  for( unsigned int i = 0; i < _pendingParents.size(); ++i ) {
+    const PendingParent& pending = _pendingParents[i];
+    if( pending.object >= _objects.size() || _objects[pending.object].parent != -1 ) {
+      continue;
+    }
+    _fieldValue.assign(&_pendingNames[pending.nameStart], pending.nameSize);
+    const int parent = findObjectIndex(_fieldValue);
+    if( parent != -1 && !reachesAncestor(_objects, parent, pending.object) ) {
+      _objects[pending.object].parent = parent;
+      SCENE_STATS(_loadStats.unresolvedReferences -= 1);
+    }
   }
-  std::clog << std::endl;
-
-  // Output all Objects.
-  std::clog << "Objects: " << _objects.size() << std::endl;
-  for( unsigned int i = 0; i < _objects.size(); ++i ) {
-    const Object& obj = _objects[i];
+  _pendingParents.clear();
+  _pendingNames.clear();
+  buildReferences();
+  resetHandles();
 
-    std::clog << "[" << i << "].name = " << obj.name.c_str() << std::endl;
-    std::clog << "[" << i << "].position = " << obj.position.x << ", " << obj.position.y << ", " << obj.position.z << std::endl;
-    std::clog << "[" << i << "].orientation = " << obj.orientation.x << ", " << obj.orientation.y << ", " << obj.orientation.z << std::endl;
-    std::clog << "[" << i << "].scale = " << obj.scale.x << ", " << obj.scale.y << ", " << obj.scale.z << std::endl;
-    std::clog << "[" << i << "].mesh = " << obj.mesh << std::endl;
-    std::clog << "[" << i << "].material = " << obj.material << std::endl;
+  // Any spares left over are for records this file didn't have.
+  clearSpares();
 
-    std::clog << std::endl;
-  }
+#ifdef SCENE_ENABLE_LOAD_STATS
+  _activeStats = nullptr;
 
-  // Output all Lights.
-  std::clog << "Lights: " << _lights.size() << std::endl;
-  for( unsigned int i = 0; i < _lights.size(); ++i ) {
-    const Light& light = _lights[i];
-
-    std::clog << "[" << i << "].type = " << light.type << std::endl;
-    std::clog << "[" << i << "].diffuseColor = " << light.diffuseColor.x << ", " << light.diffuseColor.y << ", " << light.diffuseColor.z << std::endl;
-    std::clog << "[" << i << "].diffuseIntensity = " << light.diffuseIntensity << std::endl;
-    std::clog << "[" << i << "].specularColor = " << light.specularColor.x << ", " << light.specularColor.y << ", " << light.specularColor.z << std::endl;
-    std::clog << "[" << i << "].specularIntensity = " << light.specularIntensity << std::endl;
-    std::clog << "[" << i << "].position = " << light.position.x << ", " << light.position.y << ", " << light.position.z << std::endl;
-    std::clog << "[" << i << "].range = " << light.range << std::endl;
-    std::clog << "[" << i << "].direction = " << light.direction.x << ", " << light.direction.y << ", " << light.direction.z << std::endl;
-    std::clog << "[" << i << "].shadows = " << ((light.shadows) ? "true" : "false") << std::endl;
-    std::clog << "[" << i << "].shadowBias = " << light.shadowBias << std::endl;
-    std::clog << "[" << i << "].coneInnerAngle = " << light.coneInnerAngle << std::endl;
-    std::clog << "[" << i << "].coneOuterAngle = " << light.coneOuterAngle << std::endl;
+  // Everything in parseLine() that wasn't attributed to another phase was spent dispatching.  The line scan
+  // happened outside of parseLine(), so it is only added to the tokenize time afterwards.
+  _loadStats.dispatchSeconds  = parseSeconds - _loadStats.tokenizeSeconds - _loadStats.numericParseSeconds - _loadStats.referenceResolveSeconds;
+  _loadStats.tokenizeSeconds += scanSeconds;
+#endif
 
-    std::clog << std::endl;
+  if( progress != nullptr ) {
+    reportProgress(progress, size);
   }
+  return true;
 }
 
-const std::vector<Scene::Object>& Scene::objects() const {
-  return _objects;
-}
-
-const std::vector<Scene::Texture>& Scene::textures() const {
-  return _textures;
-}
-
-const std::vector<Scene::Mesh>& Scene::meshes() const {
-  return _meshes;
-}
-
-const std::vector<Scene::Material>& Scene::materials() const {
-  return _materials;
-}
-
-const std::vector<Scene::Light>& Scene::lights() const {
-  return _lights;
-}
-
-unsigned int Scene::objectCount() const {
-  return _objects.size();
-}
-
-unsigned int Scene::textureCount() const {
-  return _textures.size();
-}
-
-unsigned int Scene::meshCount() const {
-  return _meshes.size();
-}
+void Scene::reserveBlocks( const char* buffer, long size ) {
+  // Count the opening tags of each kind of block.  Tags in the wrong place are counted too, which only reserves
+  // a little more than needed.
+  unsigned int textures  = 0;
+  unsigned int meshes    = 0;
+  unsigned int materials = 0;
+  unsigned int objects   = 0;
+  unsigned int lights    = 0;
+  unsigned int tracks    = 0;
+  long         index     = 0;
+  while( index < size && buffer[index] != '\0' ) {
+    long end = index;
+    while( end < size && buffer[end] != '\r' && buffer[end] != '\n' && buffer[end] != '\0' ) {
+      end += 1;
+    }
+    const char* const line = &buffer[index];
+    const long        len  = end - index;
+    if( memchr(line, '[', len) != nullptr ) {
+      textures  += isTag(line, len, "[texture]") ? 1 : 0;
+      meshes    += isTag(line, len, "[mesh]") ? 1 : 0;
+      materials += isTag(line, len, "[material]") ? 1 : 0;
+      objects   += isTag(line, len, "[obj]") ? 1 : 0;
+      lights    += isTag(line, len, "[light]") ? 1 : 0;
+      tracks    += isTag(line, len, "[track]") ? 1 : 0;
+    }
+    index = end + 1;
+  }
 
-unsigned int Scene::materialCount() const {
-  return _materials.size();
+  _textures.reserve(textures);
+  _meshes.reserve(meshes);
+  _materials.reserve(materials);
+  _objects.reserve(objects);
+  _lights.reserve(lights);
+  _tracks.reserve(tracks);
+  _textureNames.reserve(textures);
+  _meshNames.reserve(meshes);
+  _materialNames.reserve(materials);
+  _objectNames.reserve(objects);
+
+  // The next clean() swaps the records into the spares and the spares' vectors in for the records, so give those
+  // room too.  Otherwise the first reload would allocate them.
+  _spareTextures.records.reserve(textures);
+  _spareMeshes.records.reserve(meshes);
+  _spareMaterials.records.reserve(materials);
+  _spareObjects.records.reserve(objects);
+  _spareTracks.records.reserve(tracks);
 }
 
-unsigned int Scene::lightCount() const {
-  return _lights.size();
+void Scene::reportProgress( LoadProgress* progress, long bytesParsed ) const {
+  progress->bytesParsed     = bytesParsed;
+  progress->blocksCommitted = _textures.size() + _meshes.size() + _materials.size() + _objects.size() + _lights.size() + _tracks.size();
 }
 
-void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh& mesh, Material& mat, Light& light ) {
+void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh& mesh, Material& mat, Light& light, Track& track ) {
+
+  SCENE_STATS(_loadStats.lines += 1);
+  SCENE_STATS(currentSectionStats().lines += 1);
 
   // Split excess whitespace from the line.
-  const std::string& newLine = strutils::removeSpaces(line);
+  SCENE_STATS_START(trimStart);
+  strutils::removeSpaces(line, &_trimmedLine);
+  const std::string& newLine = _trimmedLine;
+  SCENE_STATS_STOP(trimStart, _loadStats.tokenizeSeconds);
 
   // Check for comment.
   if( newLine[0] == '/' ) {
     // If there's only one character, it's still technically a comment (but broken), so ignore it.
     if( newLine.size() < 2 ) {
+      SCENE_STATS(_loadStats.comments += 1);
+      SCENE_STATS(currentSectionStats().comments += 1);
       return;
     }
 
     // Check for a single line comment (//).
     if( newLine[1] == '/' ) {
+      SCENE_STATS(_loadStats.comments += 1);
+      SCENE_STATS(currentSectionStats().comments += 1);
       // Ignore this line.
       return;
     }
@@ -300,6 +2567,12 @@ void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh&
         break;
       }
 
+      // Check for [animations].
+      if( strcmp(newLine.c_str(), "[animations]") == 0 ) {
+        _parserState = kParserStateAnimations;
+        break;
+      }
+
       // Check for end.
       if( strcmp(newLine.c_str(), "[/scene]") == 0 ) {
         // Go back to whitespace mode.
@@ -308,11 +2581,12 @@ void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh&
       }
 
       // Split the string via '='.
-      std::vector<std::string> split;
-      strutils::splitString(newLine.c_str(), newLine.size(), '=', false, &split);
+      SCENE_STATS_START(splitStart);
+      const bool split = splitField(newLine, &_fieldKey, &_fieldValue);
+      SCENE_STATS_STOP(splitStart, _loadStats.tokenizeSeconds);
 
       // If there's less than two splits, don't continue.
-      if( split.size() < 2 ) {
+      if( !split ) {
         break;
       }
 
@@ -351,79 +2625,65 @@ void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh&
     case kParserStateResourceTexture: {
       // Check for end.
       if( strcmp(newLine.c_str(), "[/texture]") == 0 ) {
-        // Add the Texture to the vector and reset it.
-        _textures.push_back(tex);
-        tex.reset();
+        SCENE_STATS(_loadStats.resources.blocks += 1);
+        // Add the Texture to the vector and start the next in a spare.
+        _textures.push_back(std::move(tex));
+        _textureNames.insert(_textures, _textures.size() - 1);
+        _spareTextures.take(&tex);
 
         _parserState = kParserStateResources;
         break;
       }
 
       // Split the string via '='.
-      std::vector<std::string> split;
-      strutils::splitString(newLine.c_str(), newLine.size(), '=', false, &split);
+      SCENE_STATS_START(splitStart);
+      const bool split = splitField(newLine, &_fieldKey, &_fieldValue);
+      SCENE_STATS_STOP(splitStart, _loadStats.tokenizeSeconds);
 
       // If there's less than two splits, don't continue.
-      if( split.size() < 2 ) {
-        break;
-      }
-
-      // Check for file.
-      if( strcmp(split[0].c_str(), "file") == 0 ) {
-        tex.file = split[1].c_str();
-        break;
-      }
-
-      // Check for name.
-      if( strcmp(split[0].c_str(), "name") == 0 ) {
-        tex.name = split[1].c_str();
+      if( !split ) {
         break;
       }
 
+      parseField(_fieldKey, _fieldValue, tex);
       break;
     }
 
     case kParserStateResourceMesh: {
       // Check for end.
       if( strcmp(newLine.c_str(), "[/mesh]") == 0 ) {
-        // Add the Mesh to the vector and reset it.
-        _meshes.push_back(mesh);
-        mesh.reset();
+        SCENE_STATS(_loadStats.resources.blocks += 1);
+        // Add the Mesh to the vector and start the next in a spare.
+        _meshes.push_back(std::move(mesh));
+        _meshNames.insert(_meshes, _meshes.size() - 1);
+        _spareMeshes.take(&mesh);
 
         _parserState = kParserStateResources;
         break;
       }
 
       // Split the string via '='.
-      std::vector<std::string> split;
-      strutils::splitString(newLine.c_str(), newLine.size(), '=', false, &split);
+      SCENE_STATS_START(splitStart);
+      const bool split = splitField(newLine, &_fieldKey, &_fieldValue);
+      SCENE_STATS_STOP(splitStart, _loadStats.tokenizeSeconds);
 
       // If there's less than two splits, don't continue.
-      if( split.size() < 2 ) {
-        break;
-      }
-
-      // Check for file.
-      if( strcmp(split[0].c_str(), "file") == 0 ) {
-        mesh.file = split[1];
-        break;
-      }
-
-      // Check for name.
-      if( strcmp(split[0].c_str(), "name") == 0 ) {
-        mesh.name = split[1];
+      if( !split ) {
         break;
       }
 
+      parseField(_fieldKey, _fieldValue, mesh);
       break;
     }
 
     case kParserStateResourceMaterial: {
       // Check for end.
       if( strcmp(newLine.c_str(), "[/material]") == 0 ) {
-        // Add the Material to the materials vector and reset it.
-        _materials.push_back(mat);
-        mat.reset();
+        SCENE_STATS(_loadStats.resources.blocks += 1);
+        // Add the Material to the materials vector and start the next in a spare.
+        _materials.push_back(std::move(mat));
+        _materialNames.insert(_materials, _materials.size() - 1);
+        _spareMaterials.take(&mat);
 
         // Back to resources.
         _parserState = kParserStateResources;
@@ -431,40 +2691,16 @@ void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh&
       }
 
       // Split the string via '='.
-      std::vector<std::string> split;
-      strutils::splitString(newLine.c_str(), newLine.size(), '=', false, &split);
+      SCENE_STATS_START(splitStart);
+      const bool split = splitField(newLine, &_fieldKey, &_fieldValue);
+      SCENE_STATS_STOP(splitStart, _loadStats.tokenizeSeconds);
 
       // If there's less than two splits, don't continue.
-      if( split.size() < 2 ) {
-        break;
-      }
-
-      // Check for name.
-      if( strcmp(split[0].c_str(), "name") == 0 ) {
-        mat.name = split[1];
-        break;
-      }
-
-      if( strcmp(split[0].c_str(), "color") == 0 ) {
-        readVector(split[1], &mat.color);
-        break;
-      }
-
-      if( strcmp(split[0].c_str(), "specSize") == 0 ) {
-        mat.specSize = atof(split[1].c_str());
-        break;
-      }
-
-      if( strcmp(split[0].c_str(), "diffuseTex") == 0 ) {
-        mat.diffuseTex = findTextureIndex(split[1]);
-        break;
-      }
-
-      if( strcmp(split[0].c_str(), "normalTex") == 0 ) {
-        mat.normalTex = findTextureIndex(split[1]);
+      if( !split ) {
         break;
       }
 
+      parseField(_fieldKey, _fieldValue, mat);
       break;
     }
 
@@ -487,59 +2723,32 @@ void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh&
     case kParserStateObjectsObj: {
       // Check for end.
       if( strcmp(newLine.c_str(), "[/obj]") == 0 ) {
+        SCENE_STATS(_loadStats.objects.blocks += 1);
         // Go back to scene.
         _parserState = kParserStateObjects;
         // Add the Object to the list.
-        _objects.push_back(obj);
-        // Reset the Object for the next parsing.
-        obj.reset();
+        _objects.push_back(std::move(obj));
+        _objectNames.insert(_objects, _objects.size() - 1);
+        // Start the next Object in a spare.
+        _spareObjects.take(&obj);
         break;
       }
 
       // Split the string via '='.
-      std::vector<std::string> split;
-      strutils::splitString(newLine.c_str(), newLine.size(), '=', false, &split);
+      SCENE_STATS_START(splitStart);
+      const bool split = splitField(newLine, &_fieldKey, &_fieldValue);
+      SCENE_STATS_STOP(splitStart, _loadStats.tokenizeSeconds);
 
       // If there's less than two splits, don't continue.
-      if( split.size() < 2 ) {
-        break;
-      }
-
-      // Check for name.
-      if( strcmp(split[0].c_str(), "name") == 0 ) {
-        obj.name = split[1];
-        break;
-      }
-
-      // Check for position.
-      if( strcmp(split[0].c_str(), "position") == 0 ) {
-        readVector(split[1], &obj.position);
-        break;
-      }
-
-      // Check for orientation.
-      if( strcmp(split[0].c_str(), "orientation") == 0 ) {
-        readVector(split[1].c_str(), &obj.orientation);
-        break;
-      }
-
-      // Check for scale.
-      if( strcmp(split[0].c_str(), "scale") == 0 ) {
-        readVector(split[1].c_str(), &obj.scale);
+      if( !split ) {
         break;
       }
 
-      // Check for mesh.
-      if( strcmp(split[0].c_str(), "mesh") == 0 ) {
-        obj.mesh = findMeshIndex(split[1]);
-        break;
-      }
-
-      // Check for material.
-      if( strcmp(split[0].c_str(), "material") == 0 ) {
-        obj.material = findMaterialIndex(split[1].c_str());
+      parseField(_fieldKey, _fieldValue, obj);
+      if( obj.parent == -1 && strcmp(_fieldKey.c_str(), "parent") == 0 ) {
+        _pendingParents.push_back(PendingParent(_objects.size(), _pendingNames.size(), _fieldValue.size()));
+        _pendingNames.insert(_pendingNames.end(), _fieldValue.begin(), _fieldValue.end());
       }
-
       break;
     }
 
@@ -562,6 +2771,7 @@ void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh&
     case kParserStateLightsLight: {
       // Check for end.
       if( strcmp(newLine.c_str(), "[/light]") == 0 ) {
+        SCENE_STATS(_loadStats.lights.blocks += 1);
         // Go back to Lights.
         _parserState = kParserStateLights;
         // Add the light.
@@ -572,119 +2782,260 @@ void Scene::parseLine( const std::string& line, Object& obj, Texture& tex, Mesh&
       }
 
       // Split the string via '='.
-      std::vector<std::string> split;
-      strutils::splitString(newLine.c_str(), newLine.size(), '=', false, &split);
+      SCENE_STATS_START(splitStart);
+      const bool split = splitField(newLine, &_fieldKey, &_fieldValue);
+      SCENE_STATS_STOP(splitStart, _loadStats.tokenizeSeconds);
 
       // If there's less than two splits, don't continue.
-      if( split.size() < 2 ) {
+      if( !split ) {
         break;
       }
 
-      // Check for type.
-      if( strcmp(split[0].c_str(), "type") == 0 ) {
-        // Check for type of light.
-        if( strcmp(split[1].c_str(), "point") == 0 ) {
-          light.type = kLightTypePoint;
-        } else if( strcmp(split[1].c_str(), "spot") == 0 ) {
-          light.type = kLightTypeSpot;
-        } else if( strcmp(split[1].c_str(), "directional") == 0 ) {
-          light.type = kLightTypeDirectional;
-        }
-        break;
-      }
+      parseField(_fieldKey, _fieldValue, light);
+      break;
+    }
 
-      // Check for diffuse color.
-      if( strcmp(split[0].c_str(), "diffuseColor") == 0 ) {
-        readVector(split[1], &light.diffuseColor);
+    case kParserStateAnimations: {
+      if( strcmp(newLine.c_str(), "[track]") == 0 ) {
+        _parserState = kParserStateAnimationsTrack;
         break;
       }
 
-      // Check for diffuse intensity.
-      if( strcmp(split[0].c_str(), "diffuseIntensity") == 0 ) {
-        light.diffuseIntensity = atof(split[1].c_str());
+      // Check for end.
+      if( strcmp(newLine.c_str(), "[/animations]") == 0 ) {
+        // Go back to scene.
+        _parserState = kParserStateScene;
         break;
       }
 
-      // Check for specular color.
-      if( strcmp(split[0].c_str(), "specularColor") == 0 ) {
-        readVector(split[1].c_str(), &light.specularColor);
+      break;
+    }
+
+    case kParserStateAnimationsTrack: {
+      // Check for end.
+      if( strcmp(newLine.c_str(), "[/track]") == 0 ) {
+        // Go back to Animations.
+        _parserState = kParserStateAnimations;
+        finishTrack(track);
+        track.reset();
         break;
       }
 
-      // Check for specular intensity.
-      if( strcmp(split[0].c_str(), "specularIntensity") == 0 ){
-        light.specularIntensity = atof(split[1].c_str());
+      // Split the string via '='.
+      SCENE_STATS_START(splitStart);
+      const bool split = splitField(newLine, &_fieldKey, &_fieldValue);
+      SCENE_STATS_STOP(splitStart, _loadStats.tokenizeSeconds);
+
+      // If there's less than two splits, don't continue.
+      if( !split ) {
         break;
       }
 
-      // Check for position.
-      if( strcmp(split[0].c_str(), "position") == 0 ) {
-        readVector(split[1], &light.position);
+      parseTrackField(_fieldKey, _fieldValue, track);
+      break;
+    }
+
+    default: {
+      break;
+    }
+  }
+}
+
+template<typename Record>
+class Scene::FieldParser {
+public:
+  FieldParser( const Scene& scene, const std::string& key, const std::string& value, Record& record )
+    : _scene(scene), _field(FieldTable<Record>::instance().find(key)), _place(0), _value(value), _record(record)
+#ifdef SCENE_ENABLE_LOAD_STATS
+    , _activeStats(scene._activeStats)
+#endif
+  {
+  }
+
+  // Only the field the key names is read; the rest cost one integer test each.
+  template<typename T, typename D>
+  void operator()( const char*, T Record::* member, sceneschema::FieldKind kind, const D& ) {
+    if( _place++ != _field ) {
+      return;
+    }
+    read(&(_record.*member), kind);
+  }
+
+private:
+  void read( std::string* out, sceneschema::FieldKind ) {
+    *out = _value;
+  }
+
+  void read( float* out, sceneschema::FieldKind ) {
+    SCENE_STATS_TIME_PHASE(numericParseSeconds);
+    *out = atof(_value.c_str());
+  }
+
+  void read( Vector* out, sceneschema::FieldKind ) {
+    SCENE_STATS_TIME_PHASE(numericParseSeconds);
+    _scene.readVector(_value, out);
+  }
+
+  void read( bool* out, sceneschema::FieldKind ) {
+    _scene.parseBool(_value, out);
+  }
+
+  // Unknown light types leave the type as it was.
+  void read( LightType* out, sceneschema::FieldKind ) {
+    if( strcmp(_value.c_str(), "point") == 0 ) {
+      *out = kLightTypePoint;
+    } else if( strcmp(_value.c_str(), "spot") == 0 ) {
+      *out = kLightTypeSpot;
+    } else if( strcmp(_value.c_str(), "directional") == 0 ) {
+      *out = kLightTypeDirectional;
+    }
+  }
+
+  void read( int* out, sceneschema::FieldKind kind ) {
+    SCENE_STATS_TIME_PHASE(referenceResolveSeconds);
+    switch( kind ) {
+      case sceneschema::kFieldKindTextureRef: {
+        *out = _scene.findTextureIndex(_value);
         break;
       }
-
-      // Check for range.
-      if( strcmp(split[0].c_str(), "range") == 0 ) {
-        light.range = atof(split[1].c_str());
+      case sceneschema::kFieldKindMeshRef: {
+        *out = _scene.findMeshIndex(_value);
         break;
       }
-
-      // Check for direction.
-      if( strcmp(split[0].c_str(), "direction") == 0 ) {
-        readVector(split[1], &light.direction);
+      case sceneschema::kFieldKindMaterialRef: {
+        *out = _scene.findMaterialIndex(_value);
         break;
       }
-
-      // Check for shadows.
-      if( strcmp(split[0].c_str(), "shadows") == 0 ) {
-        parseBool(split[1], &light.shadows);
+      case sceneschema::kFieldKindObjectRef: {
+        *out = _scene.findObjectIndex(_value);
         break;
       }
-
-      // Check for shadow bias.
-      if( strcmp(split[0].c_str(), "shadowBias") == 0 ){
-        light.shadowBias = atof(split[1].c_str());
+      default: {
         break;
       }
+    }
+    SCENE_STATS_RESOLVED(*out);
+  }
 
-      // Check for cone inner angle.
-      if( strcmp(split[0].c_str(), "coneInnerAngle") == 0 ) {
-        light.coneInnerAngle = atof(split[1].c_str());
-        break;
+private:
+  const Scene&       _scene;
+  const int          _field;
+  int                _place;
+  const std::string& _value;
+  Record&            _record;
+#ifdef SCENE_ENABLE_LOAD_STATS
+  LoadStats* const   _activeStats;
+#endif
+};
+
+template<typename Record>
+void Scene::parseField( const std::string& key, const std::string& value, Record& record ) const {
+  FieldParser<Record> parser(*this, key, value, record);
+  sceneschema::Schema<Record>::fields(parser);
+}
+
+void Scene::parseTrackField( const std::string& key, const std::string& value, Track& track ) {
+  // Objects are found by name.
+  if( strcmp(key.c_str(), "object") == 0 ) {
+    SCENE_STATS_TIME(_loadStats.referenceResolveSeconds);
+    track.targetType = kTrackTargetObject;
+    track.target     = findObjectIndex(value);
+    SCENE_STATS(if( track.target == -1 ) { _loadStats.unresolvedReferences += 1; });
+    return;
+  }
+
+  // Lights have no names, so they are found by their index in the file.
+  if( strcmp(key.c_str(), "light") == 0 ) {
+    const int index = atoi(value.c_str());
+    track.targetType = kTrackTargetLight;
+    track.target     = (index >= 0 && index < static_cast<int>(_lights.size())) ? index : -1;
+    SCENE_STATS(if( track.target == -1 ) { _loadStats.unresolvedReferences += 1; });
+    return;
+  }
+
+  if( strcmp(key.c_str(), "channel") == 0 ) {
+    for( unsigned int i = 0; i < kTrackChannelCount; ++i ) {
+      if( strcmp(value.c_str(), kTrackChannelNames[i]) == 0 ) {
+        track.channel = static_cast<TrackChannel>(i);
       }
-      
-      // Check for cone outer angle.
-      if( strcmp(split[0].c_str(), "coneOuterAngle") == 0 ) {
-        light.coneOuterAngle = atof(split[1].c_str());
-        break;
+    }
+    return;
+  }
+
+  if( strcmp(key.c_str(), "interpolation") == 0 ) {
+    for( unsigned int i = 0; i < kInterpolationCount; ++i ) {
+      if( strcmp(value.c_str(), kInterpolationNames[i]) == 0 ) {
+        track.interpolation = static_cast<Interpolation>(i);
       }
+    }
+    return;
+  }
 
-      break;
+  // A key is the time followed by the value; one number for float channels, three for vector channels.
+  if( strcmp(key.c_str(), "key") == 0 ) {
+    SCENE_STATS_TIME(_loadStats.numericParseSeconds);
+    strutils::Range    split[4];
+    const unsigned int count = strutils::splitRanges(value.c_str(), value.size(), ',', false, split, 4);
+    const char* const  text  = value.c_str();
+    if( count == 2 ) {
+      track.times.push_back(atof(text + split[0].begin));
+      track.values.push_back(Vector(atof(text + split[1].begin)));
+    } else if( count == 4 ) {
+      track.times.push_back(atof(text + split[0].begin));
+      track.values.push_back(Vector(atof(text + split[1].begin), atof(text + split[2].begin), atof(text + split[3].begin)));
     }
+    return;
+  }
+}
 
-    default: {
-      break;
+void Scene::finishTrack( Track& track ) {
+  // Only keep tracks that can be played.
+  const bool objectChannel = track.channel == kTrackChannelPosition || track.channel == kTrackChannelOrientation || track.channel == kTrackChannelScale;
+  const bool lightChannel  = track.channel == kTrackChannelPosition || track.channel == kTrackChannelDiffuseIntensity;
+  if( track.target == -1 || track.times.empty() || ((track.targetType == kTrackTargetObject) ? !objectChannel : !lightChannel) ) {
+    // Keep the key vectors for the block in this place when reloading.
+    _droppedTracks.push_back(std::move(track));
+    _droppedTrackPlaces.push_back(_tracks.size());
+    _spareTracks.take(&track);
+    return;
+  }
+
+  // Keys may be written in any order.  Equal times keep their order in the file.
+  if( !std::is_sorted(track.times.begin(), track.times.end()) ) {
+    _keyOrder.resize(track.times.size());
+    for( unsigned int i = 0; i < _keyOrder.size(); ++i ) {
+      _keyOrder[i] = std::make_pair(track.times[i], i);
+    }
+    std::sort(_keyOrder.begin(), _keyOrder.end());
+    _keyValues.resize(track.values.size());
+    for( unsigned int i = 0; i < _keyOrder.size(); ++i ) {
+      track.times[i] = _keyOrder[i].first;
+      _keyValues[i]  = track.values[_keyOrder[i].second];
     }
+    std::copy(_keyValues.begin(), _keyValues.end(), track.values.begin());
   }
+
+  SCENE_STATS(_loadStats.animations.blocks += 1);
+  _tracks.push_back(std::move(track));
+  _spareTracks.take(&track);
 }
 
 void Scene::readVector( const std::string& line, Vector* outVec ) const {
-  // Separate the string by ','.
-  std::vector<std::string> split;
-  strutils::splitString(line.c_str(), line.size(), ',', false, &split);
+  // Separate the string by ','.  A number can't run on past the ',' that ends its piece, so each is read in place.
+  strutils::Range split[3];
 
   // Safety check - should be three components.
-  if( split.size() != 3 ) {
+  if( strutils::splitRanges(line.c_str(), line.size(), ',', false, split, 3) != 3 ) {
     return;
   }
 
   // Parse X, Y, and Z.
-  outVec->x = atof(split[0].c_str());
-  outVec->y = atof(split[1].c_str());
-  outVec->z = atof(split[2].c_str());
+  outVec->x = atof(line.c_str() + split[0].begin);
+  outVec->y = atof(line.c_str() + split[1].begin);
+  outVec->z = atof(line.c_str() + split[2].begin);
 }
 
-void Scene::parseBool( const std::string& value, bool* out ) {
+void Scene::parseBool( const std::string& value, bool* out ) const {
   if( out == nullptr ) {
     return;
   }
@@ -695,39 +3046,400 @@ void Scene::parseBool( const std::string& value, bool* out ) {
 }
 
 int Scene::findTextureIndex( const std::string& file ) const {
-  for( int i = 0; i < _textures.size(); ++i ) {
-    if( strcmp(file.c_str(), _textures[i].name.c_str()) != 0 ) {
-      continue;
-    }
-    return i;
-  }
-  return -1;
+  return _textureNames.find(_textures, file);
 }
 
 int Scene::findMeshIndex( const std::string& file ) const {
-  for( int i = 0; i < _meshes.size(); ++i ) {
-    if( strcmp(file.c_str(), _meshes[i].name.c_str()) != 0 ) {
-      continue;
-    }
-    return i;
-  }
-  return -1;
+  return _meshNames.find(_meshes, file);
 }
 
 int Scene::findMaterialIndex( const std::string& file ) const {
-  for( int i = 0; i < _materials.size(); ++i ) {
-    if( strcmp(file.c_str(), _materials[i].name.c_str()) != 0 ) {
-      continue;
+  return _materialNames.find(_materials, file);
+}
+
+int Scene::findObjectIndex( const std::string& name ) const {
+  return _objectNames.find(_objects, name);
+}
+
+#ifdef SCENE_ENABLE_LOAD_STATS
+const Scene::LoadStats& Scene::loadStats() const {
+  return _loadStats;
+}
+
+Scene::SectionStats& Scene::currentSectionStats() {
+  switch( _parserState ) {
+    case kParserStateResources:
+    case kParserStateResourceTexture:
+    case kParserStateResourceMesh:
+    case kParserStateResourceMaterial: {
+      return _loadStats.resources;
+    }
+
+    case kParserStateObjects:
+    case kParserStateObjectsObj: {
+      return _loadStats.objects;
+    }
+
+    case kParserStateLights:
+    case kParserStateLightsLight: {
+      return _loadStats.lights;
+    }
+
+    case kParserStateAnimations:
+    case kParserStateAnimationsTrack: {
+      return _loadStats.animations;
+    }
+
+    default: {
+      return _loadStats.scene;
     }
-    return i;
   }
-  return -1;
 }
+#endif
 
 void Scene::clean() {
   _parserState = kParserStateWhitespace;
-  _objects.clear();
-  _textures.clear();
-  _meshes.clear();
-  _materials.clear();
+  // The old records become spares for the next load to fill, and the vectors keep their capacity.
+  _spareObjects.recycle(&_objects);
+  _spareTextures.recycle(&_textures);
+  _spareMeshes.recycle(&_meshes);
+  _spareMaterials.recycle(&_materials);
+  recycleTracks();
+  _lights.clear();
+  _pendingParents.clear();
+  _pendingNames.clear();
+  _textureNames.clear();
+  _meshNames.clear();
+  _materialNames.clear();
+  _objectNames.clear();
+  _editing = false;
+  _journal.clear();
+  buildReferences();
+  resetHandles();
+}
+
+void Scene::recycleTracks() {
+  // Tracks that were dropped while loading go back among the others in file order, so that each [track] block of a
+  // reload gets the key vectors of the block that was in its place.
+  _spareTracks.clear();
+  unsigned int dropped = 0;
+  for( unsigned int i = 0; i <= _tracks.size(); ++i ) {
+    for( ; dropped < _droppedTracks.size() && _droppedTrackPlaces[dropped] == i; ++dropped ) {
+      _spareTracks.records.push_back(std::move(_droppedTracks[dropped]));
+    }
+    if( i < _tracks.size() ) {
+      _spareTracks.records.push_back(std::move(_tracks[i]));
+    }
+  }
+  _tracks.clear();
+  _droppedTracks.clear();
+  _droppedTrackPlaces.clear();
+}
+
+void Scene::clearSpares() {
+  _spareTextures.clear();
+  _spareMeshes.clear();
+  _spareMaterials.clear();
+  _spareObjects.clear();
+  _spareTracks.clear();
+}
+
+void Scene::buildReferences() {
+  _textureUsers.reset(2, _textures.size(), _materials.size());
+  for( unsigned int i = 0; i < _materials.size(); ++i ) {
+    EditTraits<Material>::link(*this, i);
+  }
+  _meshUsers.reset(1, _meshes.size(), _objects.size());
+  _materialUsers.reset(1, _materials.size(), _objects.size());
+  _objectChildren.reset(1, _objects.size(), _objects.size());
+  for( unsigned int i = 0; i < _objects.size(); ++i ) {
+    EditTraits<Object>::link(*this, i);
+  }
+  _objectTracks.reset(1, _objects.size(), _tracks.size());
+  _lightTracks.reset(1, _lights.size(), _tracks.size());
+  for( unsigned int i = 0; i < _tracks.size(); ++i ) {
+    const int none   = -1;
+    const int target = _tracks[i].target;
+    _objectTracks.link(i, (_tracks[i].targetType == kTrackTargetObject) ? &target : &none);
+    _lightTracks.link(i, (_tracks[i].targetType == kTrackTargetLight) ? &target : &none);
+  }
+}
+
+void Scene::rebuildIndexes() {
+  indexNames(_textures, &_textureNames);
+  indexNames(_meshes, &_meshNames);
+  indexNames(_materials, &_materialNames);
+  indexNames(_objects, &_objectNames);
+  buildReferences();
+}
+
+void Scene::resetHandles() {
+  _slots[kRecordTypeTexture].reset(_textures.size());
+  _slots[kRecordTypeMesh].reset(_meshes.size());
+  _slots[kRecordTypeMaterial].reset(_materials.size());
+  _slots[kRecordTypeObject].reset(_objects.size());
+  _slots[kRecordTypeLight].reset(_lights.size());
+}
+
+template<typename Record>
+Scene::Handle Scene::addRecord( const Record& record ) {
+  const unsigned int index = EditTraits<Record>::records(*this).size();
+  if( !_editing || !EditTraits<Record>::valid(*this, record, index, true) ) {
+    return Handle();
+  }
+  const Handle handle = _slots[EditTraits<Record>::kType].acquire();
+  insertRecord(index, record, handle);
+  journalChange(kChangeTypeAdd, handle, index, static_cast<const Record*>(nullptr), &record);
+  return handle;
+}
+
+template<typename Record>
+bool Scene::modifyRecord( Handle handle, const Record& record ) {
+  const int index = _slots[EditTraits<Record>::kType].find(handle);
+  if( !_editing || index < 0 || !EditTraits<Record>::valid(*this, record, index, false) ) {
+    return false;
+  }
+  journalChange(kChangeTypeModify, handle, index, &EditTraits<Record>::records(*this)[index], &record);
+  replaceRecord(index, record);
+  return true;
+}
+
+template<typename Record>
+bool Scene::removeRecord( Handle handle ) {
+  const int index = _slots[EditTraits<Record>::kType].find(handle);
+  if( !_editing || index < 0 || EditTraits<Record>::animated(*this, index) ) {
+    return false;
+  }
+  EditTraits<Record>::clearReferences(*this, index);
+  journalChange(kChangeTypeRemove, handle, index, &EditTraits<Record>::records(*this)[index], static_cast<const Record*>(nullptr));
+  eraseRecord<Record>(index);
+  return true;
+}
+
+template<typename Record>
+void Scene::journalChange( ChangeType type, Handle handle, unsigned int index, const Record* before, const Record* after ) {
+  std::vector<Record>& records = EditTraits<Record>::journal(_journal);
+  Change change;
+  change.type       = type;
+  change.recordType = EditTraits<Record>::kType;
+  change.handle     = handle;
+  change.index      = index;
+  change.before     = kNone;
+  change.after      = kNone;
+  if( before != nullptr ) {
+    change.before = records.size();
+    records.push_back(*before);
+  }
+  if( after != nullptr ) {
+    change.after = records.size();
+    records.push_back(*after);
+  }
+  _journal.changes.push_back(change);
+}
+
+// Puts a record at index, which may be the end, moving whatever was there to the end.  The handle's slot must
+// already be taken.
+template<typename Record>
+void Scene::insertRecord( unsigned int index, const Record& record, Handle handle ) {
+  std::vector<Record>& records = EditTraits<Record>::records(*this);
+  SlotMap&             slots   = _slots[EditTraits<Record>::kType];
+  const unsigned int   last    = records.size();
+  records.push_back(Record());
+  slots.slotOfIndex.push_back(kNone);
+  EditTraits<Record>::resize(*this, last + 1);
+  if( index != last ) {
+    moveRecord<Record>(index, last);
+  }
+
+  records[index]                 = record;
+  slots.slotOfIndex[index]       = handle.slot;
+  slots.indexOfSlot[handle.slot] = index;
+  EditTraits<Record>::link(*this, index);
+  addName(EditTraits<Record>::names(*this), records, index);
+}
+
+template<typename Record>
+void Scene::replaceRecord( unsigned int index, const Record& record ) {
+  std::vector<Record>& records = EditTraits<Record>::records(*this);
+  eraseName(EditTraits<Record>::names(*this), EditTraits<Record>::name(records[index]), index);
+  records[index] = record;
+  EditTraits<Record>::link(*this, index);
+  addName(EditTraits<Record>::names(*this), records, index);
+}
+
+// Takes out a record that nothing refers to, moving the last record into its place.
+template<typename Record>
+void Scene::eraseRecord( unsigned int index ) {
+  std::vector<Record>& records = EditTraits<Record>::records(*this);
+  SlotMap&             slots   = _slots[EditTraits<Record>::kType];
+  const unsigned int   last    = records.size() - 1;
+  EditTraits<Record>::unlink(*this, index);
+  eraseName(EditTraits<Record>::names(*this), EditTraits<Record>::name(records[index]), index);
+  slots.release(slots.slotOfIndex[index]);
+  if( index != last ) {
+    moveRecord<Record>(last, index);
+  }
+
+  records.pop_back();
+  slots.slotOfIndex.pop_back();
+  EditTraits<Record>::resize(*this, last);
+}
+
+template<typename Record>
+void Scene::moveRecord( unsigned int from, unsigned int to ) {
+  std::vector<Record>& records = EditTraits<Record>::records(*this);
+  SlotMap&             slots   = _slots[EditTraits<Record>::kType];
+  records[to] = std::move(records[from]);
+  moveName(EditTraits<Record>::names(*this), EditTraits<Record>::name(records[to]), from, to);
+  slots.slotOfIndex[to]                    = slots.slotOfIndex[from];
+  slots.indexOfSlot[slots.slotOfIndex[to]] = to;
+  slots.slotOfIndex[from]                  = kNone;
+  EditTraits<Record>::move(*this, from, to);
+}
+
+bool Scene::applyChange( const Journal& journal, unsigned int change ) {
+  const Change& c = journal.changes[change];
+  switch( c.recordType ) {
+    case kRecordTypeTexture: {
+      return applyChange<Texture>(journal, c);
+    }
+    case kRecordTypeMesh: {
+      return applyChange<Mesh>(journal, c);
+    }
+    case kRecordTypeMaterial: {
+      return applyChange<Material>(journal, c);
+    }
+    case kRecordTypeObject: {
+      return applyChange<Object>(journal, c);
+    }
+    case kRecordTypeLight: {
+      return applyChange<Light>(journal, c);
+    }
+    default: {
+      break;
+    }
+  }
+  return false;
+}
+
+bool Scene::revertChange( const Journal& journal, unsigned int change ) {
+  const Change& c = journal.changes[change];
+  switch( c.recordType ) {
+    case kRecordTypeTexture: {
+      return revertChange<Texture>(journal, c);
+    }
+    case kRecordTypeMesh: {
+      return revertChange<Mesh>(journal, c);
+    }
+    case kRecordTypeMaterial: {
+      return revertChange<Material>(journal, c);
+    }
+    case kRecordTypeObject: {
+      return revertChange<Object>(journal, c);
+    }
+    case kRecordTypeLight: {
+      return revertChange<Light>(journal, c);
+    }
+    default: {
+      break;
+    }
+  }
+  return false;
+}
+
+// Each change is checked against the Scene before anything is touched, so one that doesn't fit changes nothing.  During
+// a transaction, what actually changed is journaled.
+template<typename Record>
+bool Scene::applyChange( const Journal& journal, const Change& change ) {
+  const std::vector<Record>& values  = EditTraits<Record>::journal(journal);
+  std::vector<Record>&       records = EditTraits<Record>::records(*this);
+  SlotMap&                   slots   = _slots[EditTraits<Record>::kType];
+  const int                  current = slots.at(change.handle.slot);
+  const bool                 record  = _editing;
+  // Journals pick out records by slot, so what gets journaled here is the handle the record has now.
+  Handle                     handle  = (current == -1) ? change.handle : Handle(change.handle.slot, slots.generationOfSlot[change.handle.slot]);
+  switch( change.type ) {
+    case kChangeTypeAdd: {
+      if( change.after >= values.size() || change.index > records.size() || !EditTraits<Record>::valid(*this, values[change.after], change.index, true) || !slots.reclaim(&handle) ) {
+        return false;
+      }
+      if( record ) {
+        journalChange(kChangeTypeAdd, handle, change.index, static_cast<const Record*>(nullptr), &values[change.after]);
+      }
+      insertRecord(change.index, values[change.after], handle);
+      return true;
+    }
+    case kChangeTypeModify: {
+      if( change.after >= values.size() || current != static_cast<int>(change.index) || !EditTraits<Record>::valid(*this, values[change.after], change.index, false) ) {
+        return false;
+      }
+      if( record ) {
+        journalChange(kChangeTypeModify, handle, change.index, &records[change.index], &values[change.after]);
+      }
+      replaceRecord(change.index, values[change.after]);
+      return true;
+    }
+    case kChangeTypeRemove: {
+      if( current != static_cast<int>(change.index) || EditTraits<Record>::referenced(*this, change.index) ) {
+        return false;
+      }
+      if( record ) {
+        journalChange(kChangeTypeRemove, handle, change.index, &records[change.index], static_cast<const Record*>(nullptr));
+      }
+      eraseRecord<Record>(change.index);
+      return true;
+    }
+    default: {
+      break;
+    }
+  }
+  return false;
+}
+
+// The inverse of applyChange().
+template<typename Record>
+bool Scene::revertChange( const Journal& journal, const Change& change ) {
+  const std::vector<Record>& values  = EditTraits<Record>::journal(journal);
+  std::vector<Record>&       records = EditTraits<Record>::records(*this);
+  SlotMap&                   slots   = _slots[EditTraits<Record>::kType];
+  const int                  current = slots.at(change.handle.slot);
+  const bool                 record  = _editing;
+  // Journals pick out records by slot, so what gets journaled here is the handle the record has now.
+  Handle                     handle  = (current == -1) ? change.handle : Handle(change.handle.slot, slots.generationOfSlot[change.handle.slot]);
+  switch( change.type ) {
+    case kChangeTypeAdd: {
+      if( current != static_cast<int>(change.index) || EditTraits<Record>::referenced(*this, change.index) ) {
+        return false;
+      }
+      if( record ) {
+        journalChange(kChangeTypeRemove, handle, change.index, &records[change.index], static_cast<const Record*>(nullptr));
+      }
+      eraseRecord<Record>(change.index);
+      return true;
+    }
+    case kChangeTypeModify: {
+      if( change.before >= values.size() || current != static_cast<int>(change.index) || !EditTraits<Record>::valid(*this, values[change.before], change.index, false) ) {
+        return false;
+      }
+      if( record ) {
+        journalChange(kChangeTypeModify, handle, change.index, &records[change.index], &values[change.before]);
+      }
+      replaceRecord(change.index, values[change.before]);
+      return true;
+    }
+    case kChangeTypeRemove: {
+      if( change.before >= values.size() || change.index > records.size() || !EditTraits<Record>::valid(*this, values[change.before], change.index, true) || !slots.reclaim(&handle) ) {
+        return false;
+      }
+      if( record ) {
+        journalChange(kChangeTypeAdd, handle, change.index, static_cast<const Record*>(nullptr), &values[change.before]);
+      }
+      insertRecord(change.index, values[change.before], handle);
+      return true;
+    }
+    default: {
+      break;
+    }
+  }
+  return false;
 }
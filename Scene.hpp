@@ -20,9 +20,17 @@
 #ifndef __Scene__
 #define __Scene__
 
+#include <atomic>
+#include <iosfwd>
 #include <string>
+#include <utility>
 #include <vector>
 
+#if defined(SCENE_ENABLE_LOAD_STATS) && defined(SCENE_LOAD_STATS_COUNT_ALLOCATIONS)
+// Provided by the application; see Scene::LoadStats.
+unsigned long long sceneLoadStatsAllocationCount();
+#endif
+
 class Scene {
 private:
   enum ParserState : unsigned int {
@@ -35,7 +43,9 @@ private:
     kParserStateObjects,
     kParserStateObjectsObj,
     kParserStateLights,
-    kParserStateLightsLight
+    kParserStateLightsLight,
+    kParserStateAnimations,
+    kParserStateAnimationsTrack
   };
 
 public:
@@ -55,32 +65,28 @@ public:
     }
   };
 
+  // Record fields, their .scn keys, and their defaults are listed once in SceneSchema.hpp.  A field added to one of
+  // these structs must be added there too.
   struct Texture {
     std::string file;
     std::string name;
 
-    Texture()
-      : file(""), name("") {
+    Texture() {
+      reset();
     }
 
-    void reset() {
-      file = "";
-      name = "";
-    }
+    void reset();
   };
 
   struct Mesh {
     std::string file;
     std::string name;
 
-    Mesh()
-      : file(""), name("") {
+    Mesh() {
+      reset();
     }
 
-    void reset() {
-      file = "";
-      name = "";
-    }
+    void reset();
   };
 
   struct Material {
@@ -90,17 +96,11 @@ public:
     int         diffuseTex;
     int         normalTex;
 
-    Material()
-      : name(""), color(1.0f), specSize(0.0f), diffuseTex(-1), normalTex(-1) {
+    Material() {
+      reset();
     }
 
-    void reset() {
-      name       = "";
-      color      = Vector(1.0f);
-      specSize   = 0.0f;
-      diffuseTex = -1;
-      normalTex  = -1;
-    }
+    void reset();
   };
 
   struct Object {
@@ -110,19 +110,15 @@ public:
     Vector      scale;
     int         mesh;
     int         material;
+    // Index of the parent object, or -1.  Parents never form a cycle; a parent in a file that would close one is
+    // dropped when loading.
+    int         parent;
 
-    Object()
-      : name(""), position(0.0f), orientation(0.0f), scale(1.0f), mesh(-1), material(-1) {
+    Object() {
+      reset();
     }
 
-    void reset() {
-      name        = "";
-      position    = Vector(0.0f);
-      orientation = Vector(0.0f);
-      scale       = Vector(1.0f);
-      mesh        = -1;
-      material    = -1;
-    }
+    void reset();
   };
 
   enum LightType : unsigned int {
@@ -146,57 +142,521 @@ public:
     float     coneOuterAngle;
 
     Light() {
+      reset();
+    }
+
+    void reset();
+  };
+
+  enum TrackTarget : unsigned int {
+    kTrackTargetObject,
+    kTrackTargetLight
+  };
+
+  enum TrackChannel : unsigned int {
+    kTrackChannelPosition,
+    kTrackChannelOrientation,
+    kTrackChannelScale,
+    kTrackChannelDiffuseIntensity
+  };
+
+  enum Interpolation : unsigned int {
+    kInterpolationLinear,
+    kInterpolationStep,
+    kInterpolationCubic
+  };
+
+  // Keys animating one property of an object or light, sorted by time.  Float channels only use x of each value.
+  // Objects can animate position, orientation, and scale, and lights position and diffuseIntensity.
+  struct Track {
+    TrackTarget         targetType;
+    int                 target;
+    TrackChannel        channel;
+    Interpolation       interpolation;
+    std::vector<float>  times;
+    std::vector<Vector> values;
+
+    Track() {
+      reset();
     }
 
     void reset() {
-      type              = kLightTypePoint;
-      diffuseColor      = Vector(1.0f);
-      diffuseIntensity  = 1.0f;
-      specularColor     = Vector(1.0f);
-      specularIntensity = 1.0f;
-      position          = Vector(0.0f);
-      range             = 64.0f;
-      direction         = Vector(0.0f);
-      shadows           = true;
-      shadowBias        = 0.00001f;
-      coneInnerAngle    = 10.0f;
-      coneOuterAngle    = 12.0f;
+      targetType    = kTrackTargetObject;
+      target        = -1;
+      channel       = kTrackChannelPosition;
+      interpolation = kInterpolationLinear;
+      times.clear();
+      values.clear();
+    }
+  };
+
+  // A list of record indices from one of the inverted indexes.  Valid until the Scene next changes.
+  struct IndexList {
+    const unsigned int* data;
+    unsigned int        count;
+
+    IndexList()
+      : data(nullptr), count(0) {
+    }
+  };
+
+  // The kinds of record that can be edited.
+  enum RecordType : unsigned int {
+    kRecordTypeTexture,
+    kRecordTypeMesh,
+    kRecordTypeMaterial,
+    kRecordTypeObject,
+    kRecordTypeLight
+  };
+
+  // Refers to a record across edits, which move records between indices.  Each kind of record has its own handles.
+  // A handle goes stale once its record is removed, and loading invalidates every handle.  A slot's generation only
+  // goes up, so a stale handle never finds a later record.
+  struct Handle {
+    unsigned int slot;
+    unsigned int generation;
+
+    Handle()
+      : slot(0xFFFFFFFF), generation(0) {
+    }
+    Handle( unsigned int valSlot, unsigned int valGeneration )
+      : slot(valSlot), generation(valGeneration) {
+    }
+  };
+
+  enum ChangeType : unsigned int {
+    kChangeTypeAdd,
+    kChangeTypeModify,
+    kChangeTypeRemove
+  };
+
+  // One edit.  An add puts a record at index and moves any record already there to the end; index is the end except
+  // when undoing a remove.  A remove takes the record at index out and moves the last record of the same kind into
+  // its place.  References follow the records that move.  before and after index the Journal's records of the same
+  // kind, holding the value before a modify or remove and after an add or modify.  When a Journal is applied or
+  // reverted, a change's handle only picks out the slot of its record.
+  struct Change {
+    ChangeType   type;
+    RecordType   recordType;
+    Handle       handle;
+    unsigned int index;
+    unsigned int before;
+    unsigned int after;
+  };
+
+  // The changes made by one transaction, in order.  Removing a record that others refer to clears those references
+  // first, and that shows up as modifies of the records holding them.
+  struct Journal {
+    std::vector<Change>   changes;
+    std::vector<Texture>  textures;
+    std::vector<Mesh>     meshes;
+    std::vector<Material> materials;
+    std::vector<Object>   objects;
+    std::vector<Light>    lights;
+
+    void clear() {
+      changes.clear();
+      textures.clear();
+      meshes.clear();
+      materials.clear();
+      objects.clear();
+      lights.clear();
+    }
+  };
+
+  // Progress of a load, which another thread may watch, and cancel by setting cancelled.  Updated every 1024 lines.
+  struct LoadProgress {
+    std::atomic<unsigned long long> bytesTotal;
+    std::atomic<unsigned long long> bytesParsed;
+    // Texture, mesh, material, object, light, and track blocks added so far.
+    std::atomic<unsigned int>       blocksCommitted;
+    std::atomic<bool>               cancelled;
+
+    LoadProgress()
+      : bytesTotal(0), bytesParsed(0), blocksCommitted(0), cancelled(false) {
     }
   };
 
+#ifdef SCENE_ENABLE_LOAD_STATS
+  // Line, comment, and block counts for one section of a scene file.
+  struct SectionStats {
+    unsigned int lines;
+    unsigned int comments;
+    unsigned int blocks;
+
+    SectionStats()
+      : lines(0), comments(0), blocks(0) {
+    }
+  };
+
+  // Statistics gathered during the most recent load().  Only compiled in when SCENE_ENABLE_LOAD_STATS is defined,
+  // so that a default build pays nothing for the instrumentation.  Timings are in seconds and do not overlap:
+  // dispatch is the time spent in parseLine() minus the tokenize, numeric parse, and reference resolve time within it.
+  // Allocations are only reported if SCENE_LOAD_STATS_COUNT_ALLOCATIONS is also defined, in which case the application
+  // must provide sceneLoadStatsAllocationCount() returning its running allocation count (e.g. from a replaced operator new).
+  struct LoadStats {
+    double             fileReadSeconds;
+    double             tokenizeSeconds;
+    double             dispatchSeconds;
+    double             numericParseSeconds;
+    double             referenceResolveSeconds;
+    unsigned int       lines;
+    unsigned int       comments;
+    unsigned int       unresolvedReferences;
+    unsigned long long allocations;
+    SectionStats       scene;
+    SectionStats       resources;
+    SectionStats       objects;
+    SectionStats       lights;
+    SectionStats       animations;
+
+    LoadStats() {
+      reset();
+    }
+
+    void reset() {
+      fileReadSeconds         = 0.0;
+      tokenizeSeconds         = 0.0;
+      dispatchSeconds         = 0.0;
+      numericParseSeconds     = 0.0;
+      referenceResolveSeconds = 0.0;
+      lines                   = 0;
+      comments                = 0;
+      unresolvedReferences    = 0;
+      allocations             = 0;
+      scene                   = SectionStats();
+      resources               = SectionStats();
+      objects                 = SectionStats();
+      lights                  = SectionStats();
+      animations              = SectionStats();
+    }
+  };
+#endif
+
 public:
   Scene();
   ~Scene();
 
-  bool                         load         ( const std::string& file );
-  void                         debugOutput  () const;
-  const std::vector<Object>&   objects      () const;
-  const std::vector<Texture>&  textures     () const;
-  const std::vector<Mesh>&     meshes       () const;
-  const std::vector<Material>& materials    () const;
-  const std::vector<Light>&    lights       () const;
-  unsigned int                 objectCount  () const;
-  unsigned int                 textureCount () const;
-  unsigned int                 meshCount    () const;
-  unsigned int                 materialCount() const;
-  unsigned int                 lightCount   () const;
+  // Reads the file into a buffer the Scene keeps, or into the given one.  Reloading a file no larger than the last,
+  // with no more records and no longer strings or key lists in each, doesn't allocate.
+  bool                         load          ( const std::string& file );
+  bool                         load          ( const std::string& file, std::vector<char>& buffer );
+  // As above, but reporting progress as it goes.  Fails, leaving the Scene empty, if cancelled before it finishes.
+  bool                         load          ( const std::string& file, std::vector<char>& buffer, LoadProgress* progress );
+  bool                         loadFromMemory( const char* text, long size );
+  // Parses only the [obj] and [light] blocks (and [material] blocks, if outMaterials is given) in the given text,
+  // resolving names against this Scene.  Results are appended to the given vectors rather than this Scene, so it's
+  // safe to call from several threads at once as long as nothing is loading into this Scene.  Object parents are
+  // also resolved against this Scene, so they only resolve if it has objects of its own.
+  bool                         parseBlocks   ( const char* text, long size, std::vector<Object>* outObjects, std::vector<Light>* outLights, std::vector<Material>* outMaterials=nullptr ) const;
+  // Writes the Scene out as a .scn file that load() reads back the same.  With more than one thread, objects and
+  // lights are formatted in chunks on that many threads, counting the calling one, and written out in order.  The
+  // format has no escapes and refers to records by name, so this fails without writing anything if a string holds a
+  // line break, NUL, or '=', or starts or ends with a space, or if a record something refers to has no name or
+  // shares its name with an earlier record of its kind (which the reference would find instead).
+  bool                         save          ( const std::string& file, unsigned int threadCount=1 ) const;
+  bool                         save          ( std::ostream& stream, unsigned int threadCount=1 ) const;
+  // Sorts objects and lights into Morton (Z-order) order by position, so that records close together in space are
+  // close together in memory.  Each remap, if given, receives the new index of every record by its old index.
+  // Parent indices, track targets, and handles are updated to match.  Fails during a transaction, leaving the records
+  // as they were and the remaps empty.
+  bool                         sortSpatially ( std::vector<unsigned int>* outObjectRemap=nullptr, std::vector<unsigned int>* outLightRemap=nullptr );
+  // A compact binary copy of the Scene, in native byte order, for fast reloading on the same platform.
+  bool                         saveBinary    ( const std::string& file ) const;
+  bool                         loadBinary    ( const std::string& file );
+  void                         debugOutput   () const;
+  const std::vector<Object>&   objects       () const;
+  const std::vector<Texture>&  textures      () const;
+  const std::vector<Mesh>&     meshes        () const;
+  const std::vector<Material>& materials     () const;
+  const std::vector<Light>&    lights        () const;
+  const std::vector<Track>&    tracks        () const;
+  unsigned int                 objectCount   () const;
+  unsigned int                 textureCount  () const;
+  unsigned int                 meshCount     () const;
+  unsigned int                 materialCount () const;
+  unsigned int                 lightCount    () const;
+  unsigned int                 trackCount    () const;
+  // Index of the first object with the given name, or -1.  Once objects have been edited, a repeated name finds any
+  // one of the objects that still have it.
+  int                          findObject    ( const std::string& name ) const;
+  // Objects using a mesh or material, and materials using a texture as either diffuseTex or normalTex.  Lists are in
+  // index order after loading, but edits reorder them.
+  IndexList                    meshUsers     ( unsigned int mesh ) const;
+  IndexList                    materialUsers ( unsigned int material ) const;
+  IndexList                    textureUsers  ( unsigned int texture ) const;
+  // Edits happen in transactions.  Every add, modify, and remove must come between beginEdit() and commitEdit(),
+  // which hands back the transaction's Journal, or rollbackEdit(), which undoes it.  Records are stored densely, and
+  // each edit is constant time apart from updating the references to a record that is removed or moved.  Adds and
+  // modifies with out of range references or with an object parent that would make a cycle fail, as do removes of
+  // objects and lights that a track animates.  Loading abandons any open transaction.
+  bool                         beginEdit     ();
+  bool                         commitEdit    ( Journal* outJournal=nullptr );
+  bool                         rollbackEdit  ();
+  Handle                       add           ( const Texture& texture );
+  Handle                       add           ( const Mesh& mesh );
+  Handle                       add           ( const Material& material );
+  Handle                       add           ( const Object& object );
+  Handle                       add           ( const Light& light );
+  bool                         modify        ( Handle handle, const Texture& texture );
+  bool                         modify        ( Handle handle, const Mesh& mesh );
+  bool                         modify        ( Handle handle, const Material& material );
+  bool                         modify        ( Handle handle, const Object& object );
+  bool                         modify        ( Handle handle, const Light& light );
+  bool                         remove        ( RecordType type, Handle handle );
+  Handle                       handle        ( RecordType type, unsigned int index ) const;
+  // Index of the record a handle refers to, or -1 if the handle is stale.
+  int                          indexOf       ( RecordType type, Handle handle ) const;
+  // Replays a committed Journal onto a Scene in the state it was recorded from, or undoes one on a Scene in the state
+  // it left behind, putting removed records back in their old slots.  A record put back gets a newer generation
+  // than it had, so handles from before its removal stay stale.  Fails, changing nothing, if the Journal doesn't fit
+  // the Scene or a transaction is open.
+  bool                         apply         ( const Journal& journal );
+  bool                         revert        ( const Journal& journal );
+  static bool                  saveJournal   ( const std::string& file, const Journal& journal );
+  static bool                  loadJournal   ( const std::string& file, Journal* outJournal );
+#ifdef SCENE_ENABLE_LOAD_STATS
+  const LoadStats&             loadStats     () const;
+#endif
+
+private:
+  // An object whose parent wasn't found when it was read, as the parent may come later in the file.  The name is
+  // kept in _pendingNames.
+  struct PendingParent {
+    unsigned int object;
+    unsigned int nameStart;
+    unsigned int nameSize;
+
+    PendingParent( unsigned int valObject, unsigned int valNameStart, unsigned int valNameSize )
+      : object(valObject), nameStart(valNameStart), nameSize(valNameSize) {
+    }
+  };
+
+  // Maps names to the first record of one kind with each, as an open-addressed hash table of record indices.  Names
+  // are compared against the records themselves rather than copied, and clear() keeps the table for the next load.
+  struct NameIndex {
+    struct Entry {
+      unsigned int hash;
+      // The first record of the name's chain, or -1 for an empty entry.
+      int          index;
+    };
+
+    // A power of two in size, and never more than half full.
+    std::vector<Entry> entries;
+    unsigned int       count;
+    // Per record: the records either side of it in the chain of records with the same name, or -1.
+    std::vector<int>   previous;
+    std::vector<int>   next;
+
+    NameIndex()
+      : count(0) {
+    }
+
+    void clear  ();
+    void reserve( unsigned int names );
+    template<typename Record>
+    int  find   ( const std::vector<Record>& records, const std::string& name ) const;
+    // Adds the record to its name's chain.  A name found first keeps the record it already maps to.
+    template<typename Record>
+    void insert ( const std::vector<Record>& records, unsigned int index );
+    // Takes the record out of its name's chain, passing the name on to the next record with it if there is one.
+    void erase  ( const std::string& name, unsigned int index );
+    // Moves a record to an index that isn't in any chain.
+    void move   ( const std::string& name, unsigned int from, unsigned int to );
+    void rehash ( unsigned int size );
+    // Grows previous and next to cover the record.
+    void cover  ( unsigned int index );
+    // Whether the record shares its name with another.
+    bool shared ( unsigned int index ) const;
+  };
+
+  // Records from before the last clean().  Loading swaps each into its temporary record in turn, so that the strings
+  // and vectors of a reload fill memory that is already there rather than allocating.
+  template<typename Record>
+  struct Spares {
+    std::vector<Record> records;
+    unsigned int        next;
+
+    Spares()
+      : next(0) {
+    }
+
+    // Takes the records as spares, leaving them with the previous spares' empty vector.
+    void recycle( std::vector<Record>* from ) {
+      records.clear();
+      records.swap(*from);
+      next = 0;
+    }
+
+    // Swaps the next spare, if any, into record and resets it.
+    void take( Record* record ) {
+      if( next < records.size() ) {
+        std::swap(*record, records[next]);
+        next += 1;
+      }
+      record->reset();
+    }
+
+    void clear() {
+      records.clear();
+      next = 0;
+    }
+  };
+
+  // Maps the handles of one kind of record to indices and back.  Freed slots are reused last in, first out, which
+  // is what lets revert() give removed records back their old slots.
+  struct SlotMap {
+    std::vector<unsigned int> indexOfSlot;
+    std::vector<unsigned int> generationOfSlot;
+    std::vector<unsigned int> slotOfIndex;
+    std::vector<unsigned int> freeSlots;
+
+    void   reset  ( unsigned int count );
+    void   permute( const std::vector<unsigned int>& remap );
+    int    find   ( Handle handle ) const;
+    // Index of the record in a slot, whatever its generation, or -1.
+    int    at     ( unsigned int slot ) const;
+    Handle acquire();
+    // Takes the given handle's slot back, if it is the next one acquire() would hand out.  The handle's generation is
+    // raised to the slot's if that is newer.
+    bool   reclaim( Handle* handle );
+    void   release( unsigned int slot );
+  };
+
+  // For each record of one kind, the records referring to it through up to two fields, listed once each.  Every link
+  // remembers its place in its list so that it can be dropped in constant time.
+  struct ReferenceIndex {
+    unsigned int                            fieldCount;
+    unsigned int                            targetCount;
+    // Per target.  Lists past targetCount are empty and kept for their memory.
+    std::vector<std::vector<unsigned int> > referrers;
+    // Per field of each referrer: the target it links to (or -1) and its place in the target's list.
+    std::vector<int>                        links;
+    std::vector<unsigned int>               places;
+
+    ReferenceIndex()
+      : fieldCount(1), targetCount(0) {
+    }
+
+    void      reset          ( unsigned int fields, unsigned int targetCount, unsigned int referrerCount );
+    void      resizeTargets  ( unsigned int count );
+    void      resizeReferrers( unsigned int count );
+    // Replaces a referrer's links with links to the given targets, one per field.  Out of range targets are skipped.
+    void      link           ( unsigned int referrer, const int* targets );
+    void      unlink         ( unsigned int referrer );
+    // Moves a referrer or target to an index that has no links.
+    void      moveReferrer   ( unsigned int from, unsigned int to );
+    void      moveTarget     ( unsigned int from, unsigned int to );
+    IndexList list           ( unsigned int target ) const;
+  };
+
+  // How each kind of record is stored and referred to; see Scene.cpp.
+  template<typename Record>
+  struct EditTraits;
+
+  // Parses one field of a record; see SceneSchema.hpp.
+  template<typename Record>
+  class FieldParser;
 
 private:
-  void parseLine        ( const std::string& line, Object& obj, Texture& tex, Mesh& mesh, Material& mat, Light& light );
-  void readVector       ( const std::string& line, Vector* outVec ) const;
-  void parseBool        ( const std::string& value, bool* out );
-  int  findTextureIndex ( const std::string& file ) const;
-  int  findMeshIndex    ( const std::string& file ) const;
-  int  findMaterialIndex( const std::string& file ) const;
-  void clean            ();
+  bool parseBuffer       ( const char* buffer, long size, LoadProgress* progress=nullptr );
+  void reserveBlocks     ( const char* buffer, long size );
+  void reportProgress    ( LoadProgress* progress, long bytesParsed ) const;
+  void parseLine         ( const std::string& line, Object& obj, Texture& tex, Mesh& mesh, Material& mat, Light& light, Track& track );
+  void parseTrackField   ( const std::string& key, const std::string& value, Track& track );
+  void finishTrack       ( Track& track );
+  template<typename Record>
+  void parseField        ( const std::string& key, const std::string& value, Record& record ) const;
+  void readVector        ( const std::string& line, Vector* outVec ) const;
+  void parseBool         ( const std::string& value, bool* out ) const;
+  int  findTextureIndex  ( const std::string& file ) const;
+  int  findMeshIndex     ( const std::string& file ) const;
+  int  findMaterialIndex ( const std::string& file ) const;
+  int  findObjectIndex   ( const std::string& name ) const;
+  void clean             ();
+  void recycleTracks     ();
+  void clearSpares       ();
+  void buildReferences   ();
+  void rebuildIndexes    ();
+  void resetHandles      ();
+  bool savesAsText       () const;
+  template<typename Record>
+  bool namesFindReferrals( const std::vector<Record>& records, const NameIndex& names ) const;
+  bool writeText         ( std::ostream& stream, unsigned int threadCount ) const;
+  template<typename Record>
+  Handle addRecord       ( const Record& record );
+  template<typename Record>
+  bool modifyRecord      ( Handle handle, const Record& record );
+  template<typename Record>
+  bool removeRecord      ( Handle handle );
+  template<typename Record>
+  void journalChange     ( ChangeType type, Handle handle, unsigned int index, const Record* before, const Record* after );
+  template<typename Record>
+  void insertRecord      ( unsigned int index, const Record& record, Handle handle );
+  template<typename Record>
+  void replaceRecord     ( unsigned int index, const Record& record );
+  template<typename Record>
+  void eraseRecord       ( unsigned int index );
+  template<typename Record>
+  void moveRecord        ( unsigned int from, unsigned int to );
+  bool applyChange       ( const Journal& journal, unsigned int change );
+  bool revertChange      ( const Journal& journal, unsigned int change );
+  template<typename Record>
+  bool applyChange       ( const Journal& journal, const Change& change );
+  template<typename Record>
+  bool revertChange      ( const Journal& journal, const Change& change );
+#ifdef SCENE_ENABLE_LOAD_STATS
+  SectionStats& currentSectionStats();
+#endif
 
 private:
-  ParserState           _parserState;
-  std::vector<Object>   _objects;
-  std::vector<Texture>  _textures;
-  std::vector<Mesh>     _meshes;
-  std::vector<Material> _materials;
-  std::vector<Light>    _lights;
+  ParserState                _parserState;
+  std::vector<Object>        _objects;
+  std::vector<Texture>       _textures;
+  std::vector<Mesh>          _meshes;
+  std::vector<Material>      _materials;
+  std::vector<Light>         _lights;
+  std::vector<Track>         _tracks;
+  std::vector<PendingParent> _pendingParents;
+  std::vector<char>          _pendingNames;
+  // Name lookups, kept up to date while loading and editing so that references resolve in constant time.
+  NameIndex                  _textureNames;
+  NameIndex                  _meshNames;
+  NameIndex                  _materialNames;
+  NameIndex                  _objectNames;
+  // Objects by mesh, objects by material, materials by texture, objects by parent, and tracks by target.
+  ReferenceIndex             _meshUsers;
+  ReferenceIndex             _materialUsers;
+  ReferenceIndex             _textureUsers;
+  ReferenceIndex             _objectChildren;
+  ReferenceIndex             _objectTracks;
+  ReferenceIndex             _lightTracks;
+  // Per RecordType.
+  SlotMap                    _slots[kRecordTypeLight + 1];
+  bool                       _editing;
+  Journal                    _journal;
+  Spares<Texture>            _spareTextures;
+  Spares<Mesh>               _spareMeshes;
+  Spares<Material>           _spareMaterials;
+  Spares<Object>             _spareObjects;
+  Spares<Track>              _spareTracks;
+  // Tracks that finishTrack() didn't keep, and how many kept tracks came before each.
+  std::vector<Track>         _droppedTracks;
+  std::vector<unsigned int>  _droppedTrackPlaces;
+  // Scratch space for the line being parsed, kept between loads for its memory.
+  std::string                _line;
+  std::string                _trimmedLine;
+  std::string                _fieldKey;
+  std::string                _fieldValue;
+  // File contents for load( file ), kept between loads for its memory.
+  std::vector<char>          _fileBuffer;
+  // Scratch space for putting a track's keys in order.
+  std::vector<std::pair<float, unsigned int>> _keyOrder;
+  std::vector<Vector>        _keyValues;
+#ifdef SCENE_ENABLE_LOAD_STATS
+  LoadStats                  _loadStats;
+  LoadStats*                 _activeStats;
+#endif
 };
 
 #endif /* __Scene__ */
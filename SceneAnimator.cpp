@@ -0,0 +1,223 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "SceneAnimator.hpp"
+
+#if !defined(SCENE_DISABLE_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define SCENE_ANIMATOR_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+  const float kInfinity = std::numeric_limits<float>::infinity();
+  const float kLargest  = std::numeric_limits<float>::max();
+
+  float vectorComponent( const Scene::Vector& vector, unsigned int component ) {
+    return (component == 0) ? vector.x : ((component == 1) ? vector.y : vector.z);
+  }
+}
+
+SceneAnimator::SceneAnimator() {
+}
+
+SceneAnimator::~SceneAnimator() {
+}
+
+void SceneAnimator::bind( const Scene& scene ) {
+  _firstChannel.clear();
+  _targetType.clear();
+  _target.clear();
+  _channel.clear();
+  _keyStart.clear();
+  _keyCount.clear();
+  _interpolation.clear();
+  _times.clear();
+  _values.clear();
+
+  for( unsigned int i = 0; i < scene.tracks().size(); ++i ) {
+    const Scene::Track& track      = scene.tracks()[i];
+    const unsigned int  components = (track.channel == Scene::kTrackChannelDiffuseIntensity) ? 1 : 3;
+    _firstChannel.push_back(_keyStart.size());
+    _targetType.push_back(track.targetType);
+    _target.push_back(track.target);
+    _channel.push_back(track.channel);
+    for( unsigned int component = 0; component < components; ++component ) {
+      _keyStart.push_back(_times.size());
+      _keyCount.push_back(track.times.size());
+      _interpolation.push_back(track.interpolation);
+      _times.insert(_times.end(), track.times.begin(), track.times.end());
+      for( unsigned int key = 0; key < track.values.size(); ++key ) {
+        _values.push_back(vectorComponent(track.values[key], component));
+      }
+    }
+  }
+
+  // An empty span makes the first evaluate() seek every channel.  Padding channels hold zero for all time.
+  const unsigned int count  = _keyStart.size();
+  const unsigned int padded = (count + 3) & ~3u;
+  _segment.assign(count, -1);
+  _spanBegin.assign(padded, -kInfinity);
+  _spanEnd.assign(padded, kInfinity);
+  std::fill(_spanBegin.begin(), _spanBegin.begin() + count, kInfinity);
+  std::fill(_spanEnd.begin(), _spanEnd.begin() + count, -kInfinity);
+  _start.assign(padded, 0.0f);
+  _inverseLength.assign(padded, 0.0f);
+  _a.assign(padded, 0.0f);
+  _b.assign(padded, 0.0f);
+  _c.assign(padded, 0.0f);
+  _d.assign(padded, 0.0f);
+  _result.assign(padded, 0.0f);
+}
+
+void SceneAnimator::evaluate( float time, std::vector<Scene::Object>* objects, std::vector<Scene::Light>* lights ) {
+  if( std::isnan(time) ) {
+    return;
+  }
+  // Infinite times are pulled in to the largest finite ones, so that spans holding a key (which have no length)
+  // don't multiply infinity by zero.
+  time = std::min(std::max(time, -kLargest), kLargest);
+
+  const unsigned int count  = _keyStart.size();
+  const unsigned int padded = _result.size();
+
+  // Move the channels that have left their cached span onto their new one.  Padding channels never leave theirs,
+  // but are skipped anyway as they have no keys to seek.
+#ifdef SCENE_ANIMATOR_SSE
+  const __m128 t = _mm_set1_ps(time);
+  for( unsigned int i = 0; i < padded; i += 4 ) {
+    const __m128 before = _mm_cmplt_ps(t, _mm_loadu_ps(&_spanBegin[i]));
+    const __m128 after  = _mm_cmpge_ps(t, _mm_loadu_ps(&_spanEnd[i]));
+    const int    moved  = _mm_movemask_ps(_mm_or_ps(before, after));
+    for( unsigned int lane = 0; moved != 0 && lane < 4 && i + lane < count; ++lane ) {
+      if( (moved & (1 << lane)) != 0 ) {
+        seek(i + lane, time);
+      }
+    }
+  }
+#else
+  for( unsigned int i = 0; i < count; ++i ) {
+    if( time < _spanBegin[i] || time >= _spanEnd[i] ) {
+      seek(i, time);
+    }
+  }
+#endif
+
+  // Every interpolation is a cubic in the position within the span, so all channels evaluate the same way.
+#ifdef SCENE_ANIMATOR_SSE
+  for( unsigned int i = 0; i < padded; i += 4 ) {
+    const __m128 u = _mm_mul_ps(_mm_sub_ps(t, _mm_loadu_ps(&_start[i])), _mm_loadu_ps(&_inverseLength[i]));
+    __m128 r = _mm_loadu_ps(&_d[i]);
+    r = _mm_add_ps(_mm_mul_ps(r, u), _mm_loadu_ps(&_c[i]));
+    r = _mm_add_ps(_mm_mul_ps(r, u), _mm_loadu_ps(&_b[i]));
+    r = _mm_add_ps(_mm_mul_ps(r, u), _mm_loadu_ps(&_a[i]));
+    _mm_storeu_ps(&_result[i], r);
+  }
+#else
+  for( unsigned int i = 0; i < padded; ++i ) {
+    const float u = (time - _start[i]) * _inverseLength[i];
+    _result[i] = ((_d[i] * u + _c[i]) * u + _b[i]) * u + _a[i];
+  }
+#endif
+
+  // Write the results out a track at a time.
+  for( unsigned int i = 0; i < _firstChannel.size(); ++i ) {
+    const float* const result = &_result[_firstChannel[i]];
+    if( _targetType[i] == Scene::kTrackTargetObject ) {
+      if( objects == nullptr || _target[i] >= objects->size() ) {
+        continue;
+      }
+      Scene::Object& object = (*objects)[_target[i]];
+      Scene::Vector& vector = (_channel[i] == Scene::kTrackChannelPosition) ? object.position : ((_channel[i] == Scene::kTrackChannelOrientation) ? object.orientation : object.scale);
+      vector = Scene::Vector(result[0], result[1], result[2]);
+    } else {
+      if( lights == nullptr || _target[i] >= lights->size() ) {
+        continue;
+      }
+      Scene::Light& light = (*lights)[_target[i]];
+      if( _channel[i] == Scene::kTrackChannelDiffuseIntensity ) {
+        light.diffuseIntensity = result[0];
+      } else {
+        light.position = Scene::Vector(result[0], result[1], result[2]);
+      }
+    }
+  }
+}
+
+unsigned int SceneAnimator::channelCount() const {
+  return _keyStart.size();
+}
+
+void SceneAnimator::seek( unsigned int channel, float time ) {
+  const float* const times  = &_times[_keyStart[channel]];
+  const float* const values = &_values[_keyStart[channel]];
+  const int          count  = _keyCount[channel];
+
+  // Segment s lies between keys s and s + 1.  Segment -1 is before the first key and count - 1 after the last.
+  // Playing forwards usually only reaches the next segment, so try that before searching.
+  int segment = _segment[channel] + 1;
+  if( !(segment < count && time >= times[segment] && (segment + 1 >= count || time < times[segment + 1])) ) {
+    segment = static_cast<int>(std::upper_bound(times, times + count, time) - times) - 1;
+  }
+  _segment[channel] = segment;
+
+  if( segment < 0 || segment >= count - 1 ) {
+    _spanBegin[channel]     = (segment < 0) ? -kInfinity : times[count - 1];
+    _spanEnd[channel]       = (segment < 0) ? times[0] : kInfinity;
+    _start[channel]         = 0.0f;
+    _inverseLength[channel] = 0.0f;
+    _a[channel]             = values[(segment < 0) ? 0 : count - 1];
+    _b[channel]             = 0.0f;
+    _c[channel]             = 0.0f;
+    _d[channel]             = 0.0f;
+    return;
+  }
+
+  const float p0 = values[(segment > 0) ? segment - 1 : segment];
+  const float p1 = values[segment];
+  const float p2 = values[segment + 1];
+  const float p3 = values[(segment + 2 < count) ? segment + 2 : segment + 1];
+  _spanBegin[channel]     = times[segment];
+  _spanEnd[channel]       = times[segment + 1];
+  _start[channel]         = times[segment];
+  _inverseLength[channel] = 1.0f / (times[segment + 1] - times[segment]);
+  _a[channel]             = p1;
+  switch( _interpolation[channel] ) {
+    case Scene::kInterpolationStep: {
+      _b[channel] = 0.0f;
+      _c[channel] = 0.0f;
+      _d[channel] = 0.0f;
+      break;
+    }
+    case Scene::kInterpolationCubic: {
+      _b[channel] = 0.5f * (p2 - p0);
+      _c[channel] = p0 - 2.5f * p1 + 2.0f * p2 - 0.5f * p3;
+      _d[channel] = 0.5f * (p3 - p0) + 1.5f * (p1 - p2);
+      break;
+    }
+    default: {
+      _b[channel] = p2 - p1;
+      _c[channel] = 0.0f;
+      _d[channel] = 0.0f;
+      break;
+    }
+  }
+}
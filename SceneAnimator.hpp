@@ -0,0 +1,73 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SceneAnimator__
+#define __SceneAnimator__
+
+#include <vector>
+#include "Scene.hpp"
+
+// Plays back the tracks of a Scene.  Each component of a track is a separate float channel, and channels are stored
+// structure-of-arrays so that evaluate() can work on four at a time with SSE (unless SCENE_DISABLE_SIMD is defined).
+// Each channel remembers which pair of keys it was last between, along with the polynomial for that span, so
+// playback that moves forwards a little each frame only does real work when a channel crosses a key.  Cubic
+// interpolation is a uniform Catmull-Rom spline through the keys.
+class SceneAnimator {
+public:
+  SceneAnimator();
+  ~SceneAnimator();
+
+  void         bind        ( const Scene& scene );
+  // Evaluates every channel at the given time and writes the results into the animated fields of the objects and
+  // lights, which are expected to be indexed the same as those of the bound Scene.  Times before the first key or
+  // after the last, infinite ones included, hold that key.  A time that isn't a number is ignored.
+  void         evaluate    ( float time, std::vector<Scene::Object>* objects, std::vector<Scene::Light>* lights );
+  unsigned int channelCount() const;
+
+private:
+  void seek( unsigned int channel, float time );
+
+private:
+  // Per track: its first channel, and where its result goes.  A vector track's channels are x, y, and z in turn.
+  std::vector<unsigned int>          _firstChannel;
+  std::vector<Scene::TrackTarget>    _targetType;
+  std::vector<unsigned int>          _target;
+  std::vector<Scene::TrackChannel>   _channel;
+  // Per channel: the keys, and the segment the cached span belongs to.
+  std::vector<unsigned int>          _keyStart;
+  std::vector<unsigned int>          _keyCount;
+  std::vector<Scene::Interpolation>  _interpolation;
+  std::vector<int>                   _segment;
+  // Per channel, padded to a multiple of four: the time span the cached polynomial holds for, the start time and
+  // inverse length of that span, the polynomial's coefficients, and the latest result.
+  std::vector<float>                 _spanBegin;
+  std::vector<float>                 _spanEnd;
+  std::vector<float>                 _start;
+  std::vector<float>                 _inverseLength;
+  std::vector<float>                 _a;
+  std::vector<float>                 _b;
+  std::vector<float>                 _c;
+  std::vector<float>                 _d;
+  std::vector<float>                 _result;
+  // Key times and values of every channel, back to back.
+  std::vector<float>                 _times;
+  std::vector<float>                 _values;
+};
+
+#endif /* __SceneAnimator__ */
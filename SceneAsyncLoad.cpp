@@ -0,0 +1,57 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+#include "SceneAsyncLoad.hpp"
+
+namespace {
+  std::shared_ptr<Scene> loadScene( const std::string& file, const std::shared_ptr<Scene::LoadProgress>& progress ) {
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+    std::vector<char>      buffer;
+    if( !scene->load(file, buffer, progress.get()) ) {
+      return std::shared_ptr<Scene>();
+    }
+    return scene;
+  }
+
+  // A load handed to an executor.  Jobs must be copyable, so the promise is shared between the copies.
+  struct LoadJob {
+    std::string                                           file;
+    std::shared_ptr<Scene::LoadProgress>                  progress;
+    std::shared_ptr<std::promise<std::shared_ptr<Scene>>> result;
+
+    void operator()() const {
+      result->set_value(loadScene(file, progress));
+    }
+  };
+}
+
+std::future<std::shared_ptr<Scene>> loadAsync( const std::string& file, const std::shared_ptr<Scene::LoadProgress>& progress, const SceneExecutor& executor ) {
+  if( !executor ) {
+    return std::async(std::launch::async, &loadScene, file, progress);
+  }
+
+  LoadJob job;
+  job.file     = file;
+  job.progress = progress;
+  job.result   = std::make_shared<std::promise<std::shared_ptr<Scene>>>();
+  std::future<std::shared_ptr<Scene>> future = job.result->get_future();
+  executor(job);
+  return future;
+}
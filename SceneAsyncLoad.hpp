@@ -0,0 +1,39 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SceneAsyncLoad__
+#define __SceneAsyncLoad__
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include "Scene.hpp"
+
+// Runs a job on a thread of the caller's choosing, such as by queueing it on a thread pool.
+typedef std::function<void( std::function<void()> job )> SceneExecutor;
+
+// Loads a Scene file in the background, on the executor if one is given or on a new thread otherwise.  The Scene is
+// built where nothing else can see it and only handed over through the future once the load is complete, ready to
+// go to a ScenePublisher.  A load that fails or is cancelled through the progress gives a null Scene.  Progress may
+// be null; otherwise it is updated as the load runs, and kept alive until the job is done.  Without an executor,
+// destroying the future waits for the load to finish, as with std::async.
+std::future<std::shared_ptr<Scene>> loadAsync( const std::string& file, const std::shared_ptr<Scene::LoadProgress>& progress=std::shared_ptr<Scene::LoadProgress>(), const SceneExecutor& executor=SceneExecutor() );
+
+#endif /* __SceneAsyncLoad__ */
@@ -0,0 +1,126 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include "SceneBatchLoader.hpp"
+
+namespace {
+  // Returns the size of a file in bytes, or zero if it cannot be opened.
+  long fileSize( const std::string& file ) {
+    FILE* const f = fopen(file.c_str(), "rb");
+    if( f == nullptr ) {
+      return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fclose(f);
+    return size;
+  }
+
+  // Orders indices by descending file size.
+  struct LargestFirst {
+    const std::vector<long>* sizes;
+
+    bool operator()( unsigned int a, unsigned int b ) const {
+      return (*sizes)[a] > (*sizes)[b];
+    }
+  };
+}
+
+SceneBatchLoader::SceneBatchLoader( unsigned int threadCount )
+  : _threadCount(threadCount) {
+  // Default to the hardware thread count, which may be unknown.
+  if( _threadCount == 0 ) {
+    _threadCount = std::thread::hardware_concurrency();
+  }
+  if( _threadCount == 0 ) {
+    _threadCount = 1;
+  }
+  _buffers.resize(_threadCount);
+}
+
+SceneBatchLoader::~SceneBatchLoader() {
+}
+
+std::vector<SceneBatchLoader::Result> SceneBatchLoader::loadMany( const std::vector<std::string>& paths ) {
+  std::vector<Result> results(paths.size());
+  if( paths.empty() ) {
+    return results;
+  }
+
+  // Only one batch at a time, so that each worker's buffer has one user.
+  std::lock_guard<std::mutex> lock(_loadMutex);
+
+  // Schedule the largest files first.  Workers pull from the front of this list as they become free, so the
+  // long loads overlap each other and the small files pack into whatever time is left.
+  std::vector<long>         sizes(paths.size());
+  std::vector<unsigned int> order(paths.size());
+  for( unsigned int i = 0; i < paths.size(); ++i ) {
+    results[i].path = paths[i];
+    sizes[i]        = fileSize(paths[i]);
+    order[i]        = i;
+  }
+  LargestFirst largestFirst;
+  largestFirst.sizes = &sizes;
+  std::stable_sort(order.begin(), order.end(), largestFirst);
+
+  // No point in starting more threads than there are files.
+  const unsigned int workerCount = std::min(_threadCount, static_cast<unsigned int>(paths.size()));
+  std::atomic<unsigned int> next(0);
+
+  // The calling thread acts as the first worker.
+  std::vector<std::thread> threads;
+  threads.reserve(workerCount - 1);
+  for( unsigned int i = 1; i < workerCount; ++i ) {
+    threads.push_back(std::thread(&SceneBatchLoader::worker, this, i, std::cref(order), &next, &results));
+  }
+  worker(0, order, &next, &results);
+  for( unsigned int i = 0; i < threads.size(); ++i ) {
+    threads[i].join();
+  }
+
+  return results;
+}
+
+unsigned int SceneBatchLoader::threadCount() const {
+  return _threadCount;
+}
+
+void SceneBatchLoader::worker( unsigned int workerIndex, const std::vector<unsigned int>& order, std::atomic<unsigned int>* next, std::vector<Result>* results ) {
+  std::vector<char>& buffer = _buffers[workerIndex];
+  while( true ) {
+    // Claim the next unloaded file.
+    const unsigned int claimed = next->fetch_add(1);
+    if( claimed >= order.size() ) {
+      break;
+    }
+
+    // Each Result is only ever touched by the worker that claimed it.
+    Result& result = (*results)[order[claimed]];
+    result.loaded  = result.scene.load(result.path, buffer);
+  }
+}
+
+std::vector<SceneBatchLoader::Result> loadMany( const std::vector<std::string>& paths, unsigned int threadCount ) {
+  SceneBatchLoader loader(threadCount);
+  return loader.loadMany(paths);
+}
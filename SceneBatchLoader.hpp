@@ -0,0 +1,65 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SceneBatchLoader__
+#define __SceneBatchLoader__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+
+// Loads many Scene files across a number of worker threads.  Files are handed out largest first from a shared
+// queue, so big files start early and small files fill in the gaps at the end.  Each worker keeps its own file
+// buffer, which is reused across every file it loads and across calls to loadMany().
+class SceneBatchLoader {
+public:
+  struct Result {
+    std::string path;
+    bool        loaded;
+    Scene       scene;
+
+    Result()
+      : path(""), loaded(false) {
+    }
+  };
+
+public:
+  // A thread count of zero uses the number of hardware threads.
+  SceneBatchLoader( unsigned int threadCount=0 );
+  ~SceneBatchLoader();
+
+  // Safe to call from several threads, but calls take turns, since they share the workers' buffers.
+  std::vector<Result> loadMany   ( const std::vector<std::string>& paths );
+  unsigned int        threadCount() const;
+
+private:
+  void worker( unsigned int workerIndex, const std::vector<unsigned int>& order, std::atomic<unsigned int>* next, std::vector<Result>* results );
+
+private:
+  unsigned int                   _threadCount;
+  std::mutex                     _loadMutex;
+  std::vector<std::vector<char>> _buffers;
+};
+
+// Convenience wrapper around SceneBatchLoader.  Results are in the same order as the paths.
+std::vector<SceneBatchLoader::Result> loadMany( const std::vector<std::string>& paths, unsigned int threadCount=0 );
+
+#endif /* __SceneBatchLoader__ */
@@ -0,0 +1,361 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include "SceneCellIndex.hpp"
+#include "StringUtils.hpp"
+
+namespace {
+  const char         kCellIndexMagic[8] = { 'S', 'C', 'N', 'C', 'E', 'L', 'L', 'S' };
+  const unsigned int kCellIndexVersion  = 2;
+
+  // Rounds down to an int, clamping to the range of an int.  The value must be finite.
+  int floorToInt( float value ) {
+    const float rounded = floorf(value);
+    if( rounded <= static_cast<float>(INT_MIN) ) {
+      return INT_MIN;
+    }
+    if( rounded >= static_cast<float>(INT_MAX) ) {
+      return INT_MAX;
+    }
+    return static_cast<int>(rounded);
+  }
+
+  // The size and modification time of a file, which tell whether it has changed since an index was built from it.
+  bool fileStamp( const std::string& file, unsigned long long* size, long long* time ) {
+    struct stat info;
+    if( stat(file.c_str(), &info) != 0 ) {
+      return false;
+    }
+    *size = static_cast<unsigned long long>(info.st_size);
+    *time = static_cast<long long>(info.st_mtime);
+    return true;
+  }
+
+  // Orders cells by x, then y, then z.
+  bool cellLess( const SceneCellIndex::Cell& a, const SceneCellIndex::Cell& b ) {
+    if( a.x != b.x ) {
+      return a.x < b.x;
+    }
+    if( a.y != b.y ) {
+      return a.y < b.y;
+    }
+    return a.z < b.z;
+  }
+
+  template<typename T>
+  bool writeValue( FILE* f, const T& value ) {
+    return fwrite(&value, sizeof(T), 1, f) == 1;
+  }
+
+  template<typename T>
+  bool readValue( FILE* f, T* value ) {
+    return fread(value, sizeof(T), 1, f) == 1;
+  }
+
+  // Blocks are written field by field so that no struct padding ends up in the file.
+  bool writeBlock( FILE* f, const SceneCellIndex::Block& block ) {
+    return writeValue(f, block.offset) && writeValue(f, block.size);
+  }
+
+  bool readBlock( FILE* f, SceneCellIndex::Block* block ) {
+    return readValue(f, &block->offset) && readValue(f, &block->size);
+  }
+
+  // Orders blocks by their position in the file.
+  bool blockLess( const SceneCellIndex::Block& a, const SceneCellIndex::Block& b ) {
+    return a.offset < b.offset;
+  }
+}
+
+SceneCellIndex::SceneCellIndex()
+  : _sceneSize(0), _sceneTime(0), _cellSize(0.0f) {
+}
+
+SceneCellIndex::~SceneCellIndex() {
+}
+
+bool SceneCellIndex::build( const std::string& sceneFile, float cellSize ) {
+  clean();
+
+  if( cellSize <= 0.0f ) {
+    return false;
+  }
+  _cellSize = cellSize;
+
+  // Read the whole Scene file, which must be the size it was stamped at.
+  if( !fileStamp(sceneFile, &_sceneSize, &_sceneTime) ) {
+    clean();
+    return false;
+  }
+  FILE* const f = fopen(sceneFile.c_str(), "rb");
+  if( f == nullptr ) {
+    clean();
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if( size <= 0 || static_cast<unsigned long long>(size) != _sceneSize ) {
+    fclose(f);
+    clean();
+    return false;
+  }
+  std::vector<char> buffer(size);
+  const bool read = fread(&buffer[0], sizeof(char), size, f) == static_cast<size_t>(size);
+  fclose(f);
+  if( !read ) {
+    clean();
+    return false;
+  }
+
+  // Find the byte range of the resources section and of every [obj] and [light] block.  This mirrors the sections
+  // that the Scene parser accepts blocks in, so the same blocks are found.
+  std::vector<Block> objectBlocks;
+  std::vector<Block> lightBlocks;
+  bool inObjects  = false;
+  bool inLights   = false;
+  long blockStart = -1;
+  long index      = 0;
+  while( index < size ) {
+    long end = index;
+    while( end < size && buffer[end] != '\r' && buffer[end] != '\n' ) {
+      end += 1;
+    }
+    if( end == index ) {
+      index += 1;
+      continue;
+    }
+    const std::string line = strutils::removeSpaces(std::string(&buffer[index], end - index));
+
+    if( strcmp(line.c_str(), "[resources]") == 0 ) {
+      _resources.offset = index;
+    } else if( strcmp(line.c_str(), "[/resources]") == 0 ) {
+      _resources.size = static_cast<unsigned int>(end - _resources.offset);
+    } else if( strcmp(line.c_str(), "[objects]") == 0 ) {
+      inObjects = true;
+    } else if( strcmp(line.c_str(), "[/objects]") == 0 ) {
+      inObjects = false;
+    } else if( strcmp(line.c_str(), "[lights]") == 0 ) {
+      inLights = true;
+    } else if( strcmp(line.c_str(), "[/lights]") == 0 ) {
+      inLights = false;
+    } else if( (inObjects && strcmp(line.c_str(), "[obj]") == 0) || (inLights && strcmp(line.c_str(), "[light]") == 0) ) {
+      blockStart = index;
+    } else if( inObjects && blockStart >= 0 && strcmp(line.c_str(), "[/obj]") == 0 ) {
+      objectBlocks.push_back(Block(blockStart, static_cast<unsigned int>(end - blockStart)));
+      blockStart = -1;
+    } else if( inLights && blockStart >= 0 && strcmp(line.c_str(), "[/light]") == 0 ) {
+      lightBlocks.push_back(Block(blockStart, static_cast<unsigned int>(end - blockStart)));
+      blockStart = -1;
+    }
+
+    index = end + 1;
+  }
+
+  // Parse each block on its own to find its position.  Names don't need resolving for this, so an empty Scene will do.
+  const Scene                empty;
+  std::vector<Scene::Object> objects;
+  std::vector<Scene::Light>  lights;
+  std::vector<Cell>          cells;
+  for( unsigned int i = 0; i < objectBlocks.size() + lightBlocks.size(); ++i ) {
+    const bool   isObject = i < objectBlocks.size();
+    const Block& block    = isObject ? objectBlocks[i] : lightBlocks[i - objectBlocks.size()];
+
+    objects.clear();
+    lights.clear();
+    empty.parseBlocks(&buffer[block.offset], block.size, &objects, &lights);
+
+    Scene::Vector position;
+    if( isObject && !objects.empty() ) {
+      position = objects[0].position;
+    } else if( !isObject && !lights.empty() ) {
+      // Directional lights affect everything, so they are always loaded.
+      if( lights[0].type == Scene::kLightTypeDirectional ) {
+        _globalBlocks.push_back(block);
+        continue;
+      }
+      position = lights[0].position;
+    } else {
+      continue;
+    }
+
+    Cell cell;
+    if( !cellCoords(position, &cell.x, &cell.y, &cell.z) ) {
+      _globalBlocks.push_back(block);
+      continue;
+    }
+    cell.bytes = block.size;
+    cell.blocks.push_back(block);
+    cells.push_back(cell);
+  }
+
+  // Merge the single block cells into one cell per grid coordinate, keeping the blocks in file order.
+  std::stable_sort(cells.begin(), cells.end(), cellLess);
+  for( unsigned int i = 0; i < cells.size(); ++i ) {
+    if( _cells.empty() || cellLess(_cells.back(), cells[i]) ) {
+      _cells.push_back(cells[i]);
+      continue;
+    }
+    _cells.back().bytes += cells[i].bytes;
+    _cells.back().blocks.push_back(cells[i].blocks[0]);
+  }
+  for( unsigned int i = 0; i < _cells.size(); ++i ) {
+    std::sort(_cells[i].blocks.begin(), _cells[i].blocks.end(), blockLess);
+  }
+
+  return true;
+}
+
+bool SceneCellIndex::save( const std::string& file ) const {
+  FILE* const f = fopen(file.c_str(), "wb");
+  if( f == nullptr ) {
+    return false;
+  }
+
+  bool ok = fwrite(kCellIndexMagic, sizeof(kCellIndexMagic), 1, f) == 1;
+  ok = ok && writeValue(f, kCellIndexVersion);
+  ok = ok && writeValue(f, _sceneSize);
+  ok = ok && writeValue(f, _sceneTime);
+  ok = ok && writeValue(f, _cellSize);
+  ok = ok && writeBlock(f, _resources);
+  ok = ok && writeValue(f, static_cast<unsigned int>(_globalBlocks.size()));
+  for( unsigned int i = 0; ok && i < _globalBlocks.size(); ++i ) {
+    ok = writeBlock(f, _globalBlocks[i]);
+  }
+  ok = ok && writeValue(f, static_cast<unsigned int>(_cells.size()));
+  for( unsigned int i = 0; ok && i < _cells.size(); ++i ) {
+    const Cell& cell = _cells[i];
+    ok = writeValue(f, cell.x) && writeValue(f, cell.y) && writeValue(f, cell.z) && writeValue(f, cell.bytes);
+    ok = ok && writeValue(f, static_cast<unsigned int>(cell.blocks.size()));
+    for( unsigned int j = 0; ok && j < cell.blocks.size(); ++j ) {
+      ok = writeBlock(f, cell.blocks[j]);
+    }
+  }
+
+  fclose(f);
+  return ok;
+}
+
+bool SceneCellIndex::load( const std::string& file, const std::string& sceneFile ) {
+  clean();
+
+  FILE* const f = fopen(file.c_str(), "rb");
+  if( f == nullptr ) {
+    return false;
+  }
+
+  char         magic[sizeof(kCellIndexMagic)];
+  unsigned int version = 0;
+  unsigned int count   = 0;
+  bool ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, kCellIndexMagic, sizeof(magic)) == 0;
+  ok = ok && readValue(f, &version) && version == kCellIndexVersion;
+  ok = ok && readValue(f, &_sceneSize) && readValue(f, &_sceneTime) && matches(sceneFile);
+  ok = ok && readValue(f, &_cellSize);
+  ok = ok && readBlock(f, &_resources);
+  ok = ok && readValue(f, &count);
+  if( ok ) {
+    _globalBlocks.resize(count);
+  }
+  for( unsigned int i = 0; ok && i < _globalBlocks.size(); ++i ) {
+    ok = readBlock(f, &_globalBlocks[i]);
+  }
+  ok = ok && readValue(f, &count);
+  if( ok ) {
+    _cells.resize(count);
+  }
+  for( unsigned int i = 0; ok && i < _cells.size(); ++i ) {
+    Cell& cell = _cells[i];
+    ok = readValue(f, &cell.x) && readValue(f, &cell.y) && readValue(f, &cell.z) && readValue(f, &cell.bytes);
+    ok = ok && readValue(f, &count);
+    if( ok ) {
+      cell.blocks.resize(count);
+    }
+    for( unsigned int j = 0; ok && j < cell.blocks.size(); ++j ) {
+      ok = readBlock(f, &cell.blocks[j]);
+    }
+  }
+
+  fclose(f);
+  if( !ok ) {
+    clean();
+  }
+  return ok;
+}
+
+bool SceneCellIndex::matches( const std::string& sceneFile ) const {
+  unsigned long long size = 0;
+  long long          time = 0;
+  return fileStamp(sceneFile, &size, &time) && size == _sceneSize && time == _sceneTime;
+}
+
+float SceneCellIndex::cellSize() const {
+  return _cellSize;
+}
+
+const SceneCellIndex::Block& SceneCellIndex::resources() const {
+  return _resources;
+}
+
+const std::vector<SceneCellIndex::Block>& SceneCellIndex::globalBlocks() const {
+  return _globalBlocks;
+}
+
+const std::vector<SceneCellIndex::Cell>& SceneCellIndex::cells() const {
+  return _cells;
+}
+
+int SceneCellIndex::findCell( int x, int y, int z ) const {
+  Cell key;
+  key.x = x;
+  key.y = y;
+  key.z = z;
+  const std::vector<Cell>::const_iterator it = std::lower_bound(_cells.begin(), _cells.end(), key, cellLess);
+  if( it == _cells.end() || cellLess(key, *it) ) {
+    return -1;
+  }
+  return static_cast<int>(it - _cells.begin());
+}
+
+bool SceneCellIndex::cellCoords( const Scene::Vector& position, int* x, int* y, int* z ) const {
+  const float cellX = position.x / _cellSize;
+  const float cellY = position.y / _cellSize;
+  const float cellZ = position.z / _cellSize;
+  if( !std::isfinite(cellX) || !std::isfinite(cellY) || !std::isfinite(cellZ) ) {
+    return false;
+  }
+  *x = floorToInt(cellX);
+  *y = floorToInt(cellY);
+  *z = floorToInt(cellZ);
+  return true;
+}
+
+void SceneCellIndex::clean() {
+  _sceneSize = 0;
+  _sceneTime = 0;
+  _cellSize  = 0.0f;
+  _resources = Block();
+  _globalBlocks.clear();
+  _cells.clear();
+}
@@ -0,0 +1,90 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SceneCellIndex__
+#define __SceneCellIndex__
+
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+
+// A sidecar index for a Scene file that buckets every [obj] and [light] block into a uniform grid by position.  It
+// only stores where each block lives in the Scene file, so the blocks of a cell can be read and parsed on their own.
+// Directional lights have no meaningful position, so they are kept apart as global blocks, as are blocks whose position
+// isn't finite.  The index records the size and modification time of the Scene file it was built from, and load()
+// and SceneStreamer::open() refuse it for a Scene file that no longer matches.  The saved file is in native byte order.
+class SceneCellIndex {
+public:
+  // A byte range within the Scene file.
+  struct Block {
+    unsigned long long offset;
+    unsigned int       size;
+
+    Block()
+      : offset(0), size(0) {
+    }
+    Block( unsigned long long valOffset, unsigned int valSize )
+      : offset(valOffset), size(valSize) {
+    }
+  };
+
+  struct Cell {
+    int                x;
+    int                y;
+    int                z;
+    unsigned long long bytes;
+    std::vector<Block> blocks;
+
+    Cell()
+      : x(0), y(0), z(0), bytes(0) {
+    }
+  };
+
+public:
+  SceneCellIndex();
+  ~SceneCellIndex();
+
+  bool                      build        ( const std::string& sceneFile, float cellSize );
+  bool                      save         ( const std::string& file ) const;
+  // Fails if the index wasn't built from sceneFile as it is now.
+  bool                      load         ( const std::string& file, const std::string& sceneFile );
+  // Whether sceneFile has the size and modification time the index was built from.
+  bool                      matches      ( const std::string& sceneFile ) const;
+  float                     cellSize     () const;
+  const Block&              resources    () const;
+  const std::vector<Block>& globalBlocks () const;
+  const std::vector<Cell>&  cells        () const;
+  // Returns the index of the cell at the given grid coordinates, or -1 if it holds nothing.
+  int                       findCell     ( int x, int y, int z ) const;
+  // Fails for positions that aren't finite.  Coordinates beyond the range of an int are clamped to it.
+  bool                      cellCoords   ( const Scene::Vector& position, int* x, int* y, int* z ) const;
+
+private:
+  void clean();
+
+private:
+  unsigned long long _sceneSize;
+  long long          _sceneTime;
+  float              _cellSize;
+  Block              _resources;
+  std::vector<Block> _globalBlocks;
+  std::vector<Cell>  _cells; // Sorted by x, then y, then z.
+};
+
+#endif /* __SceneCellIndex__ */
@@ -0,0 +1,292 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "SceneHierarchy.hpp"
+
+namespace {
+  // Levels are only split across threads when each thread gets at least this many nodes, as starting a thread
+  // costs about as much as computing a few thousand transforms.
+  const unsigned int kMinNodesPerThread = 8192;
+  const float        kDegToRad          = 3.14159265358979f / 180.0f;
+
+  enum VisitState : unsigned char {
+    kVisitStateNew,
+    kVisitStateOnPath,
+    kVisitStateDone
+  };
+
+  // Clears the parent of one object in each parent cycle, so that every object leads up to a root.
+  void breakCycles( std::vector<int>* parents ) {
+    const unsigned int         count = parents->size();
+    std::vector<unsigned char> state(count, kVisitStateNew);
+    std::vector<unsigned int>  path;
+    for( unsigned int i = 0; i < count; ++i ) {
+      // Walk up from i until reaching a root or an object that has already been checked.
+      int node = i;
+      while( node != -1 && state[node] == kVisitStateNew ) {
+        state[node] = kVisitStateOnPath;
+        path.push_back(node);
+        node = (*parents)[node];
+      }
+      if( node != -1 && state[node] == kVisitStateOnPath ) {
+        (*parents)[node] = -1;
+      }
+      for( unsigned int j = 0; j < path.size(); ++j ) {
+        state[path[j]] = kVisitStateDone;
+      }
+      path.clear();
+    }
+  }
+}
+
+SceneHierarchy::SceneHierarchy( unsigned int threadCount )
+  : _threadCount(threadCount) {
+  if( _threadCount == 0 ) {
+    _threadCount = std::thread::hardware_concurrency();
+  }
+  if( _threadCount == 0 ) {
+    _threadCount = 1;
+  }
+}
+
+SceneHierarchy::~SceneHierarchy() {
+}
+
+void SceneHierarchy::build( const std::vector<Scene::Object>& objects ) {
+  const unsigned int count = objects.size();
+
+  std::vector<int> parents(count);
+  for( unsigned int i = 0; i < count; ++i ) {
+    const int parent = objects[i].parent;
+    parents[i] = (parent >= 0 && parent < static_cast<int>(count) && parent != static_cast<int>(i)) ? parent : -1;
+  }
+  breakCycles(&parents);
+
+  // Group each object's children together, keeping them in Scene order.
+  std::vector<unsigned int> childStart(count + 1, 0);
+  for( unsigned int i = 0; i < count; ++i ) {
+    if( parents[i] != -1 ) {
+      childStart[parents[i] + 1] += 1;
+    }
+  }
+  for( unsigned int i = 0; i < count; ++i ) {
+    childStart[i + 1] += childStart[i];
+  }
+  std::vector<unsigned int> children(childStart[count]);
+  std::vector<unsigned int> fill(childStart.begin(), childStart.end() - 1);
+  for( unsigned int i = 0; i < count; ++i ) {
+    if( parents[i] != -1 ) {
+      children[fill[parents[i]]++] = i;
+    }
+  }
+
+  // Breadth-first from the roots.  A level ends where the nodes added while going through the previous one end.
+  _objectOfNode.clear();
+  _objectOfNode.reserve(count);
+  for( unsigned int i = 0; i < count; ++i ) {
+    if( parents[i] == -1 ) {
+      _objectOfNode.push_back(i);
+    }
+  }
+  _nodeOfObject.resize(count);
+  _parent.resize(count);
+  _firstChild.resize(count);
+  _childCount.resize(count);
+  _levelStart.clear();
+  _levelStart.push_back(0);
+  unsigned int levelEnd = _objectOfNode.size();
+  for( unsigned int node = 0; node < _objectOfNode.size(); ++node ) {
+    if( node == levelEnd ) {
+      _levelStart.push_back(levelEnd);
+      levelEnd = _objectOfNode.size();
+    }
+    const unsigned int object = _objectOfNode[node];
+    _nodeOfObject[object] = node;
+    _parent[node]         = (parents[object] == -1) ? -1 : static_cast<int>(_nodeOfObject[parents[object]]);
+    _firstChild[node]     = _objectOfNode.size();
+    _childCount[node]     = childStart[object + 1] - childStart[object];
+    _objectOfNode.insert(_objectOfNode.end(), children.begin() + childStart[object], children.begin() + childStart[object + 1]);
+  }
+  if( count > 0 ) {
+    _levelStart.push_back(count);
+  }
+
+  _local.resize(count);
+  _world.resize(count);
+  for( unsigned int node = 0; node < count; ++node ) {
+    _local[node] = fromObject(objects[_objectOfNode[node]]);
+  }
+  _flags.assign(count, 0);
+  _dirty.clear();
+
+  // Everything is new, so compute whole levels at a time.
+  for( unsigned int level = 0; level < levelCount(); ++level ) {
+    runParallel(nullptr, _levelStart[level], _levelStart[level + 1]);
+  }
+}
+
+void SceneHierarchy::setLocal( unsigned int object, const Transform& local ) {
+  const unsigned int node = _nodeOfObject[object];
+  _local[node] = local;
+  if( (_flags[node] & kNodeFlagMarked) == 0 ) {
+    _flags[node] |= kNodeFlagMarked;
+    _dirty.push_back(node);
+  }
+}
+
+void SceneHierarchy::update() {
+  if( _dirty.empty() ) {
+    return;
+  }
+
+  // Node order is level order, so going through the sorted dirty nodes picks them up a level at a time.  Each level
+  // computes its dirty nodes plus the children of whatever the previous level computed.  Levels with nothing to do
+  // between changed subtrees are skipped over.
+  std::sort(_dirty.begin(), _dirty.end());
+  unsigned int next  = 0;
+  unsigned int level = levelOf(_dirty[0]);
+  _current.clear();
+  while( level < levelCount() ) {
+    if( _current.empty() ) {
+      if( next == _dirty.size() ) {
+        break;
+      }
+      level = levelOf(_dirty[next]);
+    }
+    for( ; next < _dirty.size() && _dirty[next] < _levelStart[level + 1]; ++next ) {
+      if( (_flags[_dirty[next]] & kNodeFlagQueued) == 0 ) {
+        _current.push_back(_dirty[next]);
+      }
+    }
+
+    runParallel(&_current[0], 0, _current.size());
+
+    _next.clear();
+    for( unsigned int i = 0; i < _current.size(); ++i ) {
+      const unsigned int node = _current[i];
+      _flags[node] = 0;
+      for( unsigned int child = _firstChild[node]; child < _firstChild[node] + _childCount[node]; ++child ) {
+        _flags[child] |= kNodeFlagQueued;
+        _next.push_back(child);
+      }
+    }
+    _current.swap(_next);
+    level += 1;
+  }
+  _dirty.clear();
+}
+
+const SceneHierarchy::Transform& SceneHierarchy::local( unsigned int object ) const {
+  return _local[_nodeOfObject[object]];
+}
+
+const SceneHierarchy::Transform& SceneHierarchy::world( unsigned int object ) const {
+  return _world[_nodeOfObject[object]];
+}
+
+unsigned int SceneHierarchy::objectCount() const {
+  return _objectOfNode.size();
+}
+
+unsigned int SceneHierarchy::levelCount() const {
+  return _levelStart.empty() ? 0 : _levelStart.size() - 1;
+}
+
+unsigned int SceneHierarchy::levelStart( unsigned int level ) const {
+  return _levelStart[level];
+}
+
+unsigned int SceneHierarchy::objectAt( unsigned int order ) const {
+  return _objectOfNode[order];
+}
+
+SceneHierarchy::Transform SceneHierarchy::fromObject( const Scene::Object& object ) {
+  const float cx = cosf(object.orientation.x * kDegToRad);
+  const float sx = sinf(object.orientation.x * kDegToRad);
+  const float cy = cosf(object.orientation.y * kDegToRad);
+  const float sy = sinf(object.orientation.y * kDegToRad);
+  const float cz = cosf(object.orientation.z * kDegToRad);
+  const float sz = sinf(object.orientation.z * kDegToRad);
+
+  // Columns of Rz * Ry * Rx, each scaled by the matching axis of the scale.
+  Transform t;
+  t.m[0]  = (cz * cy) * object.scale.x;
+  t.m[1]  = (sz * cy) * object.scale.x;
+  t.m[2]  = (-sy) * object.scale.x;
+  t.m[3]  = (cz * sy * sx - sz * cx) * object.scale.y;
+  t.m[4]  = (sz * sy * sx + cz * cx) * object.scale.y;
+  t.m[5]  = (cy * sx) * object.scale.y;
+  t.m[6]  = (cz * sy * cx + sz * sx) * object.scale.z;
+  t.m[7]  = (sz * sy * cx - cz * sx) * object.scale.z;
+  t.m[8]  = (cy * cx) * object.scale.z;
+  t.m[9]  = object.position.x;
+  t.m[10] = object.position.y;
+  t.m[11] = object.position.z;
+  return t;
+}
+
+SceneHierarchy::Transform SceneHierarchy::multiply( const Transform& a, const Transform& b ) {
+  Transform out;
+  for( unsigned int col = 0; col < 4; ++col ) {
+    const float* const in = &b.m[col * 3];
+    for( unsigned int row = 0; row < 3; ++row ) {
+      out.m[col * 3 + row] = a.m[row] * in[0] + a.m[3 + row] * in[1] + a.m[6 + row] * in[2];
+    }
+  }
+  // The translation column also picks up a's translation.
+  out.m[9]  += a.m[9];
+  out.m[10] += a.m[10];
+  out.m[11] += a.m[11];
+  return out;
+}
+
+void SceneHierarchy::computeWorlds( const unsigned int* nodes, unsigned int begin, unsigned int end ) {
+  for( unsigned int i = begin; i < end; ++i ) {
+    const unsigned int node   = (nodes != nullptr) ? nodes[i] : i;
+    const int          parent = _parent[node];
+    _world[node] = (parent == -1) ? _local[node] : multiply(_world[parent], _local[node]);
+  }
+}
+
+void SceneHierarchy::runParallel( const unsigned int* nodes, unsigned int begin, unsigned int end ) {
+  // Nodes within a level don't depend on each other, so a level can be split up any way.
+  const unsigned int count   = end - begin;
+  const unsigned int threads = std::min(_threadCount, count / kMinNodesPerThread);
+  if( threads <= 1 ) {
+    computeWorlds(nodes, begin, end);
+    return;
+  }
+
+  const unsigned int       chunk = (count + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for( unsigned int start = begin + chunk; start < end; start += chunk ) {
+    workers.push_back(std::thread(&SceneHierarchy::computeWorlds, this, nodes, start, std::min(start + chunk, end)));
+  }
+  computeWorlds(nodes, begin, std::min(begin + chunk, end));
+  for( unsigned int i = 0; i < workers.size(); ++i ) {
+    workers[i].join();
+  }
+}
+
+unsigned int SceneHierarchy::levelOf( unsigned int node ) const {
+  return std::upper_bound(_levelStart.begin(), _levelStart.end(), node) - _levelStart.begin() - 1;
+}
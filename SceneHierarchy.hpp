@@ -0,0 +1,97 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SceneHierarchy__
+#define __SceneHierarchy__
+
+#include <vector>
+#include "Scene.hpp"
+
+// World transforms for the objects of a Scene, following their parent links.  The hierarchy is stored breadth-first,
+// so each level is contiguous and every parent is in an earlier level than its children, and the children of any
+// one object are contiguous too.  update() works through the levels in order, splitting large levels across
+// threads, and only recomputes the subtrees under objects whose local transform changed.
+class SceneHierarchy {
+public:
+  // An affine transform: a column-major 3x3 rotation and scale in m[0..8], then the translation in m[9..11].
+  struct Transform {
+    float m[12];
+
+    Transform() {
+      for( unsigned int i = 0; i < 12; ++i ) {
+        m[i] = (i == 0 || i == 4 || i == 8) ? 1.0f : 0.0f;
+      }
+    }
+  };
+
+public:
+  // A thread count of zero uses the number of hardware threads.
+  SceneHierarchy( unsigned int threadCount=0 );
+  ~SceneHierarchy();
+
+  // Builds the hierarchy from the objects' parents and local transforms, then computes every world transform.
+  // Objects whose parents are out of range or form a cycle are treated as roots.
+  void               build         ( const std::vector<Scene::Object>& objects );
+  // Sets an object's local transform.  Its world transform, and those below it, are recomputed by the next update().
+  void               setLocal      ( unsigned int object, const Transform& local );
+  void               update        ();
+  const Transform&   local         ( unsigned int object ) const;
+  const Transform&   world         ( unsigned int object ) const;
+  unsigned int       objectCount   () const;
+  unsigned int       levelCount    () const;
+  // Objects in breadth-first order.  Level i holds orders [levelStart(i), levelStart(i + 1)).
+  unsigned int       levelStart    ( unsigned int level ) const;
+  unsigned int       objectAt      ( unsigned int order ) const;
+  // Scale, then rotation about X, Y, and Z in degrees, then translation.
+  static Transform   fromObject    ( const Scene::Object& object );
+  // The transform that applies b and then a.
+  static Transform   multiply      ( const Transform& a, const Transform& b );
+
+private:
+  enum NodeFlag : unsigned char {
+    kNodeFlagMarked = 1,
+    kNodeFlagQueued = 2
+  };
+
+private:
+  void         computeWorlds( const unsigned int* nodes, unsigned int begin, unsigned int end );
+  void         runParallel  ( const unsigned int* nodes, unsigned int begin, unsigned int end );
+  unsigned int levelOf      ( unsigned int node ) const;
+
+private:
+  unsigned int               _threadCount;
+  // Per object.
+  std::vector<unsigned int>  _nodeOfObject;
+  // Per node, in breadth-first order.
+  std::vector<unsigned int>  _objectOfNode;
+  std::vector<int>           _parent;
+  std::vector<unsigned int>  _firstChild;
+  std::vector<unsigned int>  _childCount;
+  std::vector<Transform>     _local;
+  std::vector<Transform>     _world;
+  std::vector<unsigned char> _flags;
+  // Per level, plus one past the end.
+  std::vector<unsigned int>  _levelStart;
+  // Nodes given a new local transform since the last update(), and scratch lists of nodes to compute per level.
+  std::vector<unsigned int>  _dirty;
+  std::vector<unsigned int>  _current;
+  std::vector<unsigned int>  _next;
+};
+
+#endif /* __SceneHierarchy__ */
@@ -0,0 +1,206 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "ScenePacker.hpp"
+
+namespace {
+  const unsigned int kLightTypeCount = 3;
+  const float        kDegToRad       = 3.14159265358979f / 180.0f;
+
+  void putFloat( unsigned char* out, unsigned int offset, float value ) {
+    memcpy(out + offset, &value, sizeof(float));
+  }
+
+  void putInt( unsigned char* out, unsigned int offset, int value ) {
+    memcpy(out + offset, &value, sizeof(int));
+  }
+
+  void putUint( unsigned char* out, unsigned int offset, unsigned int value ) {
+    memcpy(out + offset, &value, sizeof(unsigned int));
+  }
+
+  void putVector( unsigned char* out, unsigned int offset, const Scene::Vector& value ) {
+    putFloat(out, offset, value.x);
+    putFloat(out, offset + 4, value.y);
+    putFloat(out, offset + 8, value.z);
+  }
+
+  // Zero-length vectors are left as they are.
+  Scene::Vector normalize( const Scene::Vector& value ) {
+    const float length = sqrtf(value.x*value.x + value.y*value.y + value.z*value.z);
+    if( length <= 0.0f ) {
+      return value;
+    }
+    return Scene::Vector(value.x / length, value.y / length, value.z / length);
+  }
+
+  // Grows a dirty range to cover [begin, end).
+  void extendDirty( ScenePacker::DirtyRange* dirty, unsigned int begin, unsigned int end ) {
+    if( dirty->begin == dirty->end ) {
+      dirty->begin = begin;
+      dirty->end   = end;
+      return;
+    }
+    dirty->begin = std::min(dirty->begin, begin);
+    dirty->end   = std::max(dirty->end, end);
+  }
+}
+
+ScenePacker::ScenePacker() {
+}
+
+ScenePacker::~ScenePacker() {
+}
+
+void ScenePacker::packLights( const std::vector<Scene::Light>& lights ) {
+  // Count each type to find where its group starts.
+  for( unsigned int i = 0; i < kLightTypeCount; ++i ) {
+    _lightRanges[i] = LightRange();
+  }
+  _lightTypes.resize(lights.size());
+  for( unsigned int i = 0; i < lights.size(); ++i ) {
+    _lightTypes[i] = lights[i].type;
+    _lightRanges[std::min<unsigned int>(lights[i].type, kLightTypeCount - 1)].count += 1;
+  }
+  for( unsigned int i = 1; i < kLightTypeCount; ++i ) {
+    _lightRanges[i].first = _lightRanges[i-1].first + _lightRanges[i-1].count;
+  }
+
+  // Place each light at the next slot of its group.
+  unsigned int next[kLightTypeCount];
+  for( unsigned int i = 0; i < kLightTypeCount; ++i ) {
+    next[i] = _lightRanges[i].first;
+  }
+  _lightSlots.resize(lights.size());
+  _lightBuffer.resize(lights.size() * kLightStride);
+  for( unsigned int i = 0; i < lights.size(); ++i ) {
+    _lightSlots[i] = next[std::min<unsigned int>(lights[i].type, kLightTypeCount - 1)]++;
+    writeLight(_lightSlots[i], lights[i]);
+  }
+  extendDirty(&_lightDirty, 0, _lightBuffer.size());
+}
+
+void ScenePacker::packMaterials( const std::vector<Scene::Material>& materials ) {
+  _materialBuffer.resize(materials.size() * kMaterialStride);
+  for( unsigned int i = 0; i < materials.size(); ++i ) {
+    writeMaterial(i, materials[i]);
+  }
+  extendDirty(&_materialDirty, 0, _materialBuffer.size());
+}
+
+void ScenePacker::repackLights( const std::vector<Scene::Light>& lights, unsigned int first, unsigned int count ) {
+  const unsigned int end = std::min<unsigned int>(first + count, lights.size());
+  bool               regroup = lights.size() != _lightSlots.size();
+  for( unsigned int i = first; !regroup && i < end; ++i ) {
+    regroup = lights[i].type != _lightTypes[i];
+  }
+  if( regroup ) {
+    packLights(lights);
+    return;
+  }
+
+  for( unsigned int i = first; i < end; ++i ) {
+    writeLight(_lightSlots[i], lights[i]);
+    extendDirty(&_lightDirty, _lightSlots[i] * kLightStride, (_lightSlots[i] + 1) * kLightStride);
+  }
+}
+
+void ScenePacker::repackMaterials( const std::vector<Scene::Material>& materials, unsigned int first, unsigned int count ) {
+  if( materials.size() * kMaterialStride != _materialBuffer.size() ) {
+    packMaterials(materials);
+    return;
+  }
+
+  const unsigned int end = std::min<unsigned int>(first + count, materials.size());
+  for( unsigned int i = first; i < end; ++i ) {
+    writeMaterial(i, materials[i]);
+  }
+  if( first < end ) {
+    extendDirty(&_materialDirty, first * kMaterialStride, end * kMaterialStride);
+  }
+}
+
+const std::vector<unsigned char>& ScenePacker::lightBuffer() const {
+  return _lightBuffer;
+}
+
+const std::vector<unsigned char>& ScenePacker::materialBuffer() const {
+  return _materialBuffer;
+}
+
+unsigned int ScenePacker::lightCount() const {
+  return _lightSlots.size();
+}
+
+unsigned int ScenePacker::materialCount() const {
+  return _materialBuffer.size() / kMaterialStride;
+}
+
+const ScenePacker::LightRange& ScenePacker::lightRange( Scene::LightType type ) const {
+  return _lightRanges[std::min<unsigned int>(type, kLightTypeCount - 1)];
+}
+
+int ScenePacker::packedLightIndex( unsigned int sceneIndex ) const {
+  if( sceneIndex >= _lightSlots.size() ) {
+    return -1;
+  }
+  return static_cast<int>(_lightSlots[sceneIndex]);
+}
+
+const ScenePacker::DirtyRange& ScenePacker::lightDirty() const {
+  return _lightDirty;
+}
+
+const ScenePacker::DirtyRange& ScenePacker::materialDirty() const {
+  return _materialDirty;
+}
+
+void ScenePacker::clearDirty() {
+  _lightDirty    = DirtyRange();
+  _materialDirty = DirtyRange();
+}
+
+void ScenePacker::writeLight( unsigned int slot, const Scene::Light& light ) {
+  unsigned char* const out = &_lightBuffer[slot * kLightStride];
+  putVector(out, kLightOffsetPosition, light.position);
+  putFloat(out, kLightOffsetRange, light.range);
+  putVector(out, kLightOffsetDirection, normalize(light.direction));
+  putFloat(out, kLightOffsetShadowBias, light.shadowBias);
+  putVector(out, kLightOffsetDiffuseColor, light.diffuseColor);
+  putFloat(out, kLightOffsetDiffuseIntensity, light.diffuseIntensity);
+  putVector(out, kLightOffsetSpecularColor, light.specularColor);
+  putFloat(out, kLightOffsetSpecularIntensity, light.specularIntensity);
+  putFloat(out, kLightOffsetCosConeInner, cosf(light.coneInnerAngle * kDegToRad));
+  putFloat(out, kLightOffsetCosConeOuter, cosf(light.coneOuterAngle * kDegToRad));
+  putUint(out, kLightOffsetType, light.type);
+  putUint(out, kLightOffsetShadows, light.shadows ? 1 : 0);
+}
+
+void ScenePacker::writeMaterial( unsigned int slot, const Scene::Material& material ) {
+  unsigned char* const out = &_materialBuffer[slot * kMaterialStride];
+  putVector(out, kMaterialOffsetColor, material.color);
+  putFloat(out, kMaterialOffsetSpecSize, material.specSize);
+  putInt(out, kMaterialOffsetDiffuseTex, material.diffuseTex);
+  putInt(out, kMaterialOffsetNormalTex, material.normalTex);
+  // Zero the padding so that identical materials pack to identical bytes.
+  memset(out + kMaterialOffsetNormalTex + 4, 0, kMaterialStride - kMaterialOffsetNormalTex - 4);
+}
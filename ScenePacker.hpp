@@ -0,0 +1,132 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ScenePacker__
+#define __ScenePacker__
+
+#include <vector>
+#include "Scene.hpp"
+
+// Packs Scene lights and materials into byte buffers ready to upload as arrays of the structs below.  The structs
+// are laid out so that std140 and std430 agree on every offset and on the array stride, so the same buffers back
+// either a uniform block or a storage block:
+//
+//   struct Light {                    struct Material {
+//     vec3  position;          // 0      vec3  color;        // 0
+//     float range;             // 12     float specSize;     // 12
+//     vec3  direction;         // 16     int   diffuseTex;   // 16
+//     float shadowBias;        // 28     int   normalTex;    // 20
+//     vec3  diffuseColor;      // 32   };                    // stride 32
+//     float diffuseIntensity;  // 44
+//     vec3  specularColor;     // 48
+//     float specularIntensity; // 60
+//     float cosConeInner;      // 64
+//     float cosConeOuter;      // 68
+//     uint  type;              // 72
+//     uint  shadows;           // 76
+//   };                         // stride 80
+//
+// Directions are normalized and cone angles (in degrees, from the cone's axis) turned into cosines while packing.
+// Lights are grouped by type, points first, then spots, then directionals, each group in Scene order.  The buffers
+// persist between packs and only the records in a repacked range are rewritten; the dirty byte range says what
+// needs uploading again.  Values are written in native byte order.
+class ScenePacker {
+public:
+  enum LightOffset : unsigned int {
+    kLightOffsetPosition          = 0,
+    kLightOffsetRange             = 12,
+    kLightOffsetDirection         = 16,
+    kLightOffsetShadowBias        = 28,
+    kLightOffsetDiffuseColor      = 32,
+    kLightOffsetDiffuseIntensity  = 44,
+    kLightOffsetSpecularColor     = 48,
+    kLightOffsetSpecularIntensity = 60,
+    kLightOffsetCosConeInner      = 64,
+    kLightOffsetCosConeOuter      = 68,
+    kLightOffsetType              = 72,
+    kLightOffsetShadows           = 76,
+    kLightStride                  = 80
+  };
+
+  enum MaterialOffset : unsigned int {
+    kMaterialOffsetColor      = 0,
+    kMaterialOffsetSpecSize   = 12,
+    kMaterialOffsetDiffuseTex = 16,
+    kMaterialOffsetNormalTex  = 20,
+    kMaterialStride           = 32
+  };
+
+  // A run of packed lights of one type.
+  struct LightRange {
+    unsigned int first;
+    unsigned int count;
+
+    LightRange()
+      : first(0), count(0) {
+    }
+  };
+
+  // Bytes [begin, end) of a buffer that changed since the last clearDirty().  Empty when begin == end.
+  struct DirtyRange {
+    unsigned int begin;
+    unsigned int end;
+
+    DirtyRange()
+      : begin(0), end(0) {
+    }
+  };
+
+public:
+  ScenePacker();
+  ~ScenePacker();
+
+  // Packs every light or material.
+  void                              packLights      ( const std::vector<Scene::Light>& lights );
+  void                              packMaterials   ( const std::vector<Scene::Material>& materials );
+  // Repacks only Scene lights or materials [first, first + count).  Falls back to a full pack if the number of
+  // records changed, or if a light changed type and so belongs in a different group.
+  void                              repackLights    ( const std::vector<Scene::Light>& lights, unsigned int first, unsigned int count );
+  void                              repackMaterials ( const std::vector<Scene::Material>& materials, unsigned int first, unsigned int count );
+  const std::vector<unsigned char>& lightBuffer     () const;
+  const std::vector<unsigned char>& materialBuffer  () const;
+  unsigned int                      lightCount      () const;
+  unsigned int                      materialCount   () const;
+  // Where a light of each type starts in the packed light buffer, and how many there are.
+  const LightRange&                 lightRange      ( Scene::LightType type ) const;
+  // The packed index of a Scene light, or -1 if the last pack had no light at that index.
+  int                               packedLightIndex( unsigned int sceneIndex ) const;
+  const DirtyRange&                 lightDirty      () const;
+  const DirtyRange&                 materialDirty   () const;
+  void                              clearDirty      ();
+
+private:
+  void writeLight   ( unsigned int slot, const Scene::Light& light );
+  void writeMaterial( unsigned int slot, const Scene::Material& material );
+
+private:
+  std::vector<unsigned char>    _lightBuffer;
+  std::vector<unsigned char>    _materialBuffer;
+  std::vector<unsigned int>     _lightSlots;
+  std::vector<Scene::LightType> _lightTypes;
+  LightRange                    _lightRanges[3];
+  DirtyRange                    _lightDirty;
+  DirtyRange                    _materialDirty;
+};
+
+#endif /* __ScenePacker__ */
@@ -0,0 +1,49 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include "ScenePublisher.hpp"
+
+ScenePublisher::ScenePublisher() {
+}
+
+ScenePublisher::~ScenePublisher() {
+}
+
+ScenePublisher::Snapshot ScenePublisher::acquire() const {
+  return std::atomic_load(&_current);
+}
+
+void ScenePublisher::publish( const Snapshot& snapshot ) {
+  std::atomic_store(&_current, snapshot);
+}
+
+bool ScenePublisher::reload( const std::string& file ) {
+  // Only one reload at a time, so that the file buffer can be reused.  Readers never take this lock.
+  std::lock_guard<std::mutex> lock(_reloadMutex);
+
+  // Build the next snapshot completely before anyone can see it.
+  std::shared_ptr<Scene> next = std::make_shared<Scene>();
+  if( !next->load(file, _reloadBuffer) ) {
+    return false;
+  }
+
+  publish(next);
+  return true;
+}
@@ -0,0 +1,54 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ScenePublisher__
+#define __ScenePublisher__
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+
+// Publishes immutable Scene snapshots to concurrent readers.  Reading a Scene while another thread calls load() on
+// it is a data race, so instead a writer builds a whole new Scene and swaps it in atomically.  Readers call acquire()
+// once (e.g. per frame) and keep the returned snapshot for as long as they need a consistent view; a snapshot is
+// freed when the last reader holding it lets go.
+class ScenePublisher {
+public:
+  typedef std::shared_ptr<const Scene> Snapshot;
+
+public:
+  ScenePublisher();
+  ~ScenePublisher();
+
+  // Safe to call from any thread at any time.  Returns an empty snapshot if nothing has been published yet.
+  Snapshot acquire() const;
+  // Replaces the current snapshot.  Readers holding the previous snapshot are unaffected.
+  void     publish( const Snapshot& snapshot );
+  // Loads the file into a new Scene on the calling thread and publishes it if the load succeeded.
+  bool     reload ( const std::string& file );
+
+private:
+  Snapshot          _current;
+  std::mutex        _reloadMutex;
+  std::vector<char> _reloadBuffer;
+};
+
+#endif /* __ScenePublisher__ */
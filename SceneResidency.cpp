@@ -0,0 +1,334 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include "SceneResidency.hpp"
+
+namespace {
+  // Objects nearer than their own size are treated as being that far away, so that one surrounding the view doesn't
+  // outrank everything else without limit.
+  const float kMinDistance = 0.001f;
+
+  bool loadResource( SceneResidency::Loader::LoadFunction load, SceneResidency::ResourceType type, unsigned int index, std::string file ) {
+    return load(type, index, file);
+  }
+
+  // A load handed to an executor.  Jobs must be copyable, so the promise is shared between the copies.
+  struct LoadJob {
+    SceneResidency::Loader::LoadFunction load;
+    SceneResidency::ResourceType         type;
+    unsigned int                         index;
+    std::string                          file;
+    std::shared_ptr<std::promise<bool>>  result;
+
+    void operator()() const {
+      result->set_value(load(type, index, file));
+    }
+  };
+
+  // Higher rank first, then lower resource index.
+  struct ByRank {
+    bool operator()( const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b ) const {
+      return (a.first != b.first) ? a.first > b.first : a.second < b.second;
+    }
+  };
+
+  // More recently used first, then lower resource index.
+  struct ByRecency {
+    bool operator()( const std::pair<unsigned int, unsigned int>& a, const std::pair<unsigned int, unsigned int>& b ) const {
+      return (a.first != b.first) ? a.first > b.first : a.second < b.second;
+    }
+  };
+}
+
+SceneResidency::SceneResidency( const Loader& loader, const Options& options, const SceneExecutor& executor )
+  : _loader(loader), _options(options), _executor(executor), _textureCount(0), _frame(0), _residentCount(0), _residentBytes(0), _pendingBytes(0) {
+}
+
+SceneResidency::~SceneResidency() {
+  clean();
+}
+
+void SceneResidency::bind( const Scene& scene ) {
+  clean();
+
+  _textureCount = scene.textureCount();
+  _resources.resize(scene.textureCount() + scene.meshCount());
+  for( unsigned int i = 0; i < _resources.size(); ++i ) {
+    Resource& resource = _resources[i];
+    resource.file     = (i < _textureCount) ? scene.textures()[i].file : scene.meshes()[i - _textureCount].file;
+    resource.bytes    = 0;
+    resource.sized    = false;
+    resource.state    = kResourceStateAbsent;
+    resource.wanted   = false;
+    resource.lastUsed = 0;
+    resource.priority = 0.0f;
+  }
+}
+
+void SceneResidency::update( const Scene& scene, const std::vector<unsigned int>& visibleObjects, const View& view, unsigned long long byteBudget, const SceneHierarchy* hierarchy ) {
+  _frame += 1;
+
+  // Find what the visible objects need, and the largest screen size each resource is seen at.
+  _needed.clear();
+  const std::vector<Scene::Object>&   objects   = scene.objects();
+  const std::vector<Scene::Material>& materials = scene.materials();
+  const bool                          useWorld  = hierarchy != nullptr && hierarchy->objectCount() == objects.size();
+  for( unsigned int i = 0; i < visibleObjects.size(); ++i ) {
+    const unsigned int object = visibleObjects[i];
+    if( object >= objects.size() ) {
+      continue;
+    }
+
+    Scene::Vector position;
+    float         size = 0.0f;
+    if( useWorld ) {
+      const SceneHierarchy::Transform& world = hierarchy->world(object);
+      for( unsigned int axis = 0; axis < 3; ++axis ) {
+        const float* const column = &world.m[axis * 3];
+        size = std::max(size, sqrtf(column[0]*column[0] + column[1]*column[1] + column[2]*column[2]));
+      }
+      position = Scene::Vector(world.m[9], world.m[10], world.m[11]);
+    } else {
+      const Scene::Vector& scale = objects[object].scale;
+      size     = std::max(std::max(fabsf(scale.x), fabsf(scale.y)), fabsf(scale.z));
+      position = objects[object].position;
+    }
+    const float dx       = position.x - view.position.x;
+    const float dy       = position.y - view.position.y;
+    const float dz       = position.z - view.position.z;
+    const float distance = std::max(std::max(sqrtf(dx*dx + dy*dy + dz*dz), size), kMinDistance);
+    const float priority = view.projectionScale * size / distance;
+
+    need((objects[object].mesh >= 0 && objects[object].mesh < static_cast<int>(scene.meshCount())) ? static_cast<int>(_textureCount) + objects[object].mesh : -1, priority);
+    const int material = objects[object].material;
+    if( material >= 0 && material < static_cast<int>(materials.size()) ) {
+      need(materials[material].diffuseTex, priority);
+      need(materials[material].normalTex, priority);
+    }
+  }
+
+  // Needed resources come first, highest ranked first.  Those already resident or on their way get the keep ratio,
+  // so that two resources of about the same rank don't keep swapping places at the edge of the budget.
+  _ranked.clear();
+  for( unsigned int i = 0; i < _needed.size(); ++i ) {
+    const Resource& resource = _resources[_needed[i]];
+    const bool      present  = resource.state == kResourceStatePending || resource.state == kResourceStateResident;
+    _ranked.push_back(std::make_pair(resource.priority * (present ? _options.keepRatio : 1.0f), _needed[i]));
+  }
+  std::sort(_ranked.begin(), _ranked.end(), ByRank());
+
+  for( unsigned int i = 0; i < _resources.size(); ++i ) {
+    _resources[i].wanted = false;
+  }
+  unsigned long long used = 0;
+  for( unsigned int i = 0; i < _ranked.size(); ++i ) {
+    const unsigned int resource = _ranked[i].second;
+    if( _resources[resource].state == kResourceStateFailed ) {
+      continue;
+    }
+    const unsigned long long bytes = bytesOf(resource);
+    if( used + bytes <= byteBudget ) {
+      used                        += bytes;
+      _resources[resource].wanted = true;
+    }
+  }
+
+  // Whatever else is resident or on its way stays, most recently used first, for as long as it fits.
+  _recent.clear();
+  for( unsigned int i = 0; i < _resources.size(); ++i ) {
+    const Resource& resource = _resources[i];
+    if( !resource.wanted && resource.lastUsed != _frame && (resource.state == kResourceStatePending || resource.state == kResourceStateResident) ) {
+      _recent.push_back(std::make_pair(resource.lastUsed, i));
+    }
+  }
+  std::sort(_recent.begin(), _recent.end(), ByRecency());
+  for( unsigned int i = 0; i < _recent.size(); ++i ) {
+    const unsigned int       resource = _recent[i].second;
+    const unsigned long long bytes    = _resources[resource].bytes;
+    if( used + bytes <= byteBudget ) {
+      used                        += bytes;
+      _resources[resource].wanted = true;
+    }
+  }
+
+  // Evict first so that the loads that follow have room.
+  for( unsigned int i = 0; i < _resources.size(); ++i ) {
+    if( _resources[i].state == kResourceStateResident && !_resources[i].wanted ) {
+      evict(i);
+    }
+  }
+  // Loads that are no longer wanted still hold their bytes until poll() sees them finish, so new loads only start
+  // while they fit alongside everything resident or on its way.  The rest wait for a later update().
+  for( unsigned int i = 0; i < _ranked.size() && _pending.size() < _options.maxPendingLoads; ++i ) {
+    const unsigned int resource = _ranked[i].second;
+    if( _resources[resource].wanted && _resources[resource].state == kResourceStateAbsent && _residentBytes + _pendingBytes + _resources[resource].bytes <= byteBudget ) {
+      startLoad(resource);
+    }
+  }
+}
+
+unsigned int SceneResidency::poll() {
+  unsigned int completed = 0;
+  for( unsigned int i = 0; i < _pending.size(); ) {
+    Pending& request = _pending[i];
+    if( request.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready ) {
+      ++i;
+      continue;
+    }
+
+    Resource&  resource = _resources[request.resource];
+    const bool loaded   = request.result.get();
+    _pendingBytes -= resource.bytes;
+    if( !loaded ) {
+      resource.state = kResourceStateFailed;
+    } else if( resource.wanted ) {
+      resource.state  = kResourceStateResident;
+      _residentCount += 1;
+      _residentBytes += resource.bytes;
+      completed      += 1;
+    } else {
+      resource.state = kResourceStateAbsent;
+      _loader.evict(typeOf(request.resource), indexOf(request.resource));
+    }
+
+    // Swap-remove the finished request.
+    if( i != _pending.size() - 1 ) {
+      _pending[i] = std::move(_pending.back());
+    }
+    _pending.pop_back();
+  }
+  return completed;
+}
+
+bool SceneResidency::isResident( ResourceType type, unsigned int index ) const {
+  const int resource = resourceOf(type, index);
+  return resource != -1 && _resources[resource].state == kResourceStateResident;
+}
+
+bool SceneResidency::isPending( ResourceType type, unsigned int index ) const {
+  const int resource = resourceOf(type, index);
+  return resource != -1 && _resources[resource].state == kResourceStatePending;
+}
+
+unsigned int SceneResidency::residentCount() const {
+  return _residentCount;
+}
+
+unsigned int SceneResidency::pendingCount() const {
+  return _pending.size();
+}
+
+unsigned long long SceneResidency::residentBytes() const {
+  return _residentBytes;
+}
+
+unsigned long long SceneResidency::pendingBytes() const {
+  return _pendingBytes;
+}
+
+void SceneResidency::need( int resource, float priority ) {
+  if( resource < 0 || resource >= static_cast<int>(_resources.size()) ) {
+    return;
+  }
+  Resource& record = _resources[resource];
+  if( record.lastUsed != _frame ) {
+    record.lastUsed = _frame;
+    record.priority = priority;
+    _needed.push_back(resource);
+  } else {
+    record.priority = std::max(record.priority, priority);
+  }
+}
+
+unsigned long long SceneResidency::bytesOf( unsigned int resource ) {
+  Resource& record = _resources[resource];
+  if( !record.sized ) {
+    record.bytes = _loader.size(typeOf(resource), indexOf(resource), record.file);
+    record.sized = true;
+  }
+  return record.bytes;
+}
+
+void SceneResidency::startLoad( unsigned int resource ) {
+  Resource& record = _resources[resource];
+  record.state   = kResourceStatePending;
+  _pendingBytes += record.bytes;
+
+  Pending request;
+  request.resource = resource;
+  if( !_executor ) {
+    request.result = std::async(std::launch::async, &loadResource, _loader.load, typeOf(resource), indexOf(resource), record.file);
+  } else {
+    LoadJob job;
+    job.load       = _loader.load;
+    job.type       = typeOf(resource);
+    job.index      = indexOf(resource);
+    job.file       = record.file;
+    job.result     = std::make_shared<std::promise<bool>>();
+    request.result = job.result->get_future();
+    _executor(job);
+  }
+  _pending.push_back(std::move(request));
+}
+
+void SceneResidency::evict( unsigned int resource ) {
+  _resources[resource].state = kResourceStateAbsent;
+  _residentCount -= 1;
+  _residentBytes -= _resources[resource].bytes;
+  _loader.evict(typeOf(resource), indexOf(resource));
+}
+
+SceneResidency::ResourceType SceneResidency::typeOf( unsigned int resource ) const {
+  return (resource < _textureCount) ? kResourceTypeTexture : kResourceTypeMesh;
+}
+
+unsigned int SceneResidency::indexOf( unsigned int resource ) const {
+  return (resource < _textureCount) ? resource : resource - _textureCount;
+}
+
+int SceneResidency::resourceOf( ResourceType type, unsigned int index ) const {
+  const unsigned int resource = (type == kResourceTypeTexture) ? index : _textureCount + index;
+  if( (type == kResourceTypeTexture && index >= _textureCount) || resource >= _resources.size() ) {
+    return -1;
+  }
+  return resource;
+}
+
+void SceneResidency::clean() {
+  // Loads in flight may finish resident, so wait for them before evicting everything.
+  for( unsigned int i = 0; i < _pending.size(); ++i ) {
+    if( _pending[i].result.get() ) {
+      _loader.evict(typeOf(_pending[i].resource), indexOf(_pending[i].resource));
+    }
+  }
+  _pending.clear();
+  for( unsigned int i = 0; i < _resources.size(); ++i ) {
+    if( _resources[i].state == kResourceStateResident ) {
+      _loader.evict(typeOf(i), indexOf(i));
+    }
+  }
+  _resources.clear();
+  _textureCount  = 0;
+  _residentCount = 0;
+  _residentBytes = 0;
+  _pendingBytes  = 0;
+}
@@ -0,0 +1,158 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __SceneResidency__
+#define __SceneResidency__
+
+#include <functional>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Scene.hpp"
+#include "SceneAsyncLoad.hpp"
+#include "SceneHierarchy.hpp"
+
+// Decides which textures and meshes of a Scene should be resident, given the objects that are currently visible.
+// Each visible object needs its mesh and its material's diffuse and normal textures, and each resource is ranked by
+// the largest screen size of the visible objects that need it, which takes in their distance.  update() keeps as
+// many of the highest ranked resources as fit in a byte budget, requests loads of the missing ones on background
+// threads, and evicts the rest; poll() makes finished loads resident.  To avoid thrashing, a resident resource is
+// only displaced by one whose rank is a good deal higher, and resources that are no longer needed stay resident,
+// most recently used first, until their space is wanted.  Textures and meshes share one budget.
+class SceneResidency {
+public:
+  enum ResourceType : unsigned int {
+    kResourceTypeTexture,
+    kResourceTypeMesh
+  };
+
+  // What actually holds resources.  size() and evict() are called on the thread calling update() and poll(), and
+  // size() at most once per resource between calls to bind().  load() is called on background threads, possibly
+  // several at once, and returns false if the resource can't be loaded, in which case it isn't tried again until the
+  // next bind().
+  struct Loader {
+    typedef std::function<unsigned long long( ResourceType type, unsigned int index, const std::string& file )> SizeFunction;
+    typedef std::function<bool( ResourceType type, unsigned int index, const std::string& file )>               LoadFunction;
+    typedef std::function<void( ResourceType type, unsigned int index )>                                       EvictFunction;
+
+    SizeFunction  size;
+    LoadFunction  load;
+    EvictFunction evict;
+  };
+
+  struct View {
+    Scene::Vector position;
+    // Converts an object's size over its distance into screen size, such as the viewport height over twice the
+    // tangent of half the vertical field of view.
+    float         projectionScale;
+
+    View()
+      : position(0.0f), projectionScale(1.0f) {
+    }
+  };
+
+  struct Options {
+    // A resource that is resident or on its way ranks as if its screen size were this many times larger.
+    float        keepRatio;
+    // The most loads in flight at once.
+    unsigned int maxPendingLoads;
+
+    Options()
+      : keepRatio(1.5f), maxPendingLoads(8) {
+    }
+  };
+
+public:
+  // Without an executor, each load runs on a new thread.
+  SceneResidency( const Loader& loader, const Options& options=Options(), const SceneExecutor& executor=SceneExecutor() );
+  // Waits for loads in flight, then evicts everything resident.
+  ~SceneResidency();
+
+  // Starts tracking the resources of a Scene, evicting everything from the previous one.
+  void               bind         ( const Scene& scene );
+  // Ranks the resources that the visible objects need and requests loads and evictions to fit the byte budget.  The
+  // Scene should be the bound one.  Object sizes are their largest scale, as if every mesh were about a unit across,
+  // and positions and scales come from the hierarchy's world transforms if one is given.  Loads that are no longer
+  // wanted are left to finish and then evicted by poll(), and hold back new loads until then.  Resident and pending
+  // bytes together stay within the budget, except while loads started under a larger budget are still in flight.
+  void               update       ( const Scene& scene, const std::vector<unsigned int>& visibleObjects, const View& view, unsigned long long byteBudget, const SceneHierarchy* hierarchy=nullptr );
+  // Makes any finished loads resident.  Returns how many became resident.
+  unsigned int       poll         ();
+  bool               isResident   ( ResourceType type, unsigned int index ) const;
+  bool               isPending    ( ResourceType type, unsigned int index ) const;
+  unsigned int       residentCount() const;
+  unsigned int       pendingCount () const;
+  unsigned long long residentBytes() const;
+  // Bytes of the loads in flight, which count against the budget as if they were already resident.
+  unsigned long long pendingBytes () const;
+
+private:
+  enum ResourceState : unsigned char {
+    kResourceStateAbsent,
+    kResourceStatePending,
+    kResourceStateResident,
+    kResourceStateFailed
+  };
+
+  // Per texture, then per mesh.
+  struct Resource {
+    std::string        file;
+    unsigned long long bytes;
+    bool               sized;
+    ResourceState      state;
+    bool               wanted;
+    // The update() that last needed the resource, and its screen size then.
+    unsigned int       lastUsed;
+    float              priority;
+  };
+
+  struct Pending {
+    unsigned int      resource;
+    std::future<bool> result;
+  };
+
+private:
+  void               need        ( int resource, float priority );
+  unsigned long long bytesOf     ( unsigned int resource );
+  void               startLoad   ( unsigned int resource );
+  void               evict       ( unsigned int resource );
+  ResourceType       typeOf      ( unsigned int resource ) const;
+  unsigned int       indexOf     ( unsigned int resource ) const;
+  int                resourceOf  ( ResourceType type, unsigned int index ) const;
+  void               clean       ();
+
+private:
+  Loader                                             _loader;
+  Options                                            _options;
+  SceneExecutor                                      _executor;
+  std::vector<Resource>                              _resources;
+  unsigned int                                       _textureCount;
+  std::vector<Pending>                               _pending;
+  unsigned int                                       _frame;
+  unsigned int                                       _residentCount;
+  unsigned long long                                 _residentBytes;
+  unsigned long long                                 _pendingBytes;
+  // Scratch space for update(): the resources needed this update, and (rank, resource) and (last used, resource)
+  // pairs to sort.
+  std::vector<unsigned int>                          _needed;
+  std::vector<std::pair<float, unsigned int>>        _ranked;
+  std::vector<std::pair<unsigned int, unsigned int>> _recent;
+};
+
+#endif /* __SceneResidency__ */
@@ -0,0 +1,151 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SceneSchema__
+#define __SceneSchema__
+
+#include "Scene.hpp"
+
+// The one list of fields for each Scene record type.  Each entry gives the key used in .scn files, a pointer to the
+// member, how the value is stored, and its default.  Parsing, resetting, writing (text and binary), and debug output
+// are all generated from these lists by passing a visitor to fields(), so adding a field here adds it everywhere.
+// The lists are templates, so every use is expanded and specialized per record type and visitor at compile time.
+//
+// A visitor of Record's fields provides:
+//   template<typename T, typename D>
+//   void operator()( const char* key, T Record::* member, sceneschema::FieldKind kind, const D& defaultValue );
+namespace sceneschema {
+  enum FieldKind : unsigned int {
+    kFieldKindString,
+    kFieldKindFloat,
+    kFieldKindVector,
+    kFieldKindBool,
+    kFieldKindLightType,
+    kFieldKindTextureRef,
+    kFieldKindMeshRef,
+    kFieldKindMaterialRef,
+    kFieldKindObjectRef
+  };
+
+  template<typename Record>
+  struct Schema;
+
+  template<>
+  struct Schema<Scene::Texture> {
+    static const char* tag() {
+      return "texture";
+    }
+
+    template<typename Visitor>
+    static void fields( Visitor& v ) {
+      v("file", &Scene::Texture::file, kFieldKindString, "");
+      v("name", &Scene::Texture::name, kFieldKindString, "");
+    }
+  };
+
+  template<>
+  struct Schema<Scene::Mesh> {
+    static const char* tag() {
+      return "mesh";
+    }
+
+    template<typename Visitor>
+    static void fields( Visitor& v ) {
+      v("file", &Scene::Mesh::file, kFieldKindString, "");
+      v("name", &Scene::Mesh::name, kFieldKindString, "");
+    }
+  };
+
+  template<>
+  struct Schema<Scene::Material> {
+    static const char* tag() {
+      return "material";
+    }
+
+    template<typename Visitor>
+    static void fields( Visitor& v ) {
+      v("name",       &Scene::Material::name,       kFieldKindString,     "");
+      v("color",      &Scene::Material::color,      kFieldKindVector,     Scene::Vector(1.0f));
+      v("specSize",   &Scene::Material::specSize,   kFieldKindFloat,      0.0f);
+      v("diffuseTex", &Scene::Material::diffuseTex, kFieldKindTextureRef, -1);
+      v("normalTex",  &Scene::Material::normalTex,  kFieldKindTextureRef, -1);
+    }
+  };
+
+  template<>
+  struct Schema<Scene::Object> {
+    static const char* tag() {
+      return "obj";
+    }
+
+    template<typename Visitor>
+    static void fields( Visitor& v ) {
+      v("name",        &Scene::Object::name,        kFieldKindString,      "");
+      v("position",    &Scene::Object::position,    kFieldKindVector,      Scene::Vector(0.0f));
+      v("orientation", &Scene::Object::orientation, kFieldKindVector,      Scene::Vector(0.0f));
+      v("scale",       &Scene::Object::scale,       kFieldKindVector,      Scene::Vector(1.0f));
+      v("mesh",        &Scene::Object::mesh,        kFieldKindMeshRef,     -1);
+      v("material",    &Scene::Object::material,    kFieldKindMaterialRef, -1);
+      v("parent",      &Scene::Object::parent,      kFieldKindObjectRef,   -1);
+    }
+  };
+
+  template<>
+  struct Schema<Scene::Light> {
+    static const char* tag() {
+      return "light";
+    }
+
+    template<typename Visitor>
+    static void fields( Visitor& v ) {
+      v("type",              &Scene::Light::type,              kFieldKindLightType, Scene::kLightTypePoint);
+      v("diffuseColor",      &Scene::Light::diffuseColor,      kFieldKindVector,    Scene::Vector(1.0f));
+      v("diffuseIntensity",  &Scene::Light::diffuseIntensity,  kFieldKindFloat,     1.0f);
+      v("specularColor",     &Scene::Light::specularColor,     kFieldKindVector,    Scene::Vector(1.0f));
+      v("specularIntensity", &Scene::Light::specularIntensity, kFieldKindFloat,     1.0f);
+      v("position",          &Scene::Light::position,          kFieldKindVector,    Scene::Vector(0.0f));
+      v("range",             &Scene::Light::range,             kFieldKindFloat,     64.0f);
+      v("direction",         &Scene::Light::direction,         kFieldKindVector,    Scene::Vector(0.0f));
+      v("shadows",           &Scene::Light::shadows,           kFieldKindBool,      true);
+      v("shadowBias",        &Scene::Light::shadowBias,        kFieldKindFloat,     0.00001f);
+      v("coneInnerAngle",    &Scene::Light::coneInnerAngle,    kFieldKindFloat,     10.0f);
+      v("coneOuterAngle",    &Scene::Light::coneOuterAngle,    kFieldKindFloat,     12.0f);
+    }
+  };
+
+  // Sets every field of a record to its default.
+  template<typename Record>
+  struct ResetVisitor {
+    Record* record;
+
+    template<typename T, typename D>
+    void operator()( const char*, T Record::* member, FieldKind, const D& defaultValue ) {
+      record->*member = defaultValue;
+    }
+  };
+
+  template<typename Record>
+  void reset( Record& record ) {
+    ResetVisitor<Record> visitor;
+    visitor.record = &record;
+    Schema<Record>::fields(visitor);
+  }
+}
+
+#endif /* __SceneSchema__ */
@@ -0,0 +1,264 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include "SceneStreamer.hpp"
+
+namespace {
+  // Reads the given byte ranges of a file into one buffer, one range per line.
+  bool readBlocks( const std::string& file, const std::vector<SceneCellIndex::Block>& blocks, std::vector<char>* outBuffer ) {
+    FILE* const f = fopen(file.c_str(), "rb");
+    if( f == nullptr ) {
+      return false;
+    }
+
+    unsigned long long total = 0;
+    for( unsigned int i = 0; i < blocks.size(); ++i ) {
+      total += blocks[i].size + 1;
+    }
+    outBuffer->resize(total);
+
+    bool               ok     = true;
+    unsigned long long offset = 0;
+    for( unsigned int i = 0; ok && i < blocks.size(); ++i ) {
+      ok = fseek(f, static_cast<long>(blocks[i].offset), SEEK_SET) == 0;
+      ok = ok && fread(&(*outBuffer)[offset], sizeof(char), blocks[i].size, f) == blocks[i].size;
+      offset += blocks[i].size;
+      (*outBuffer)[offset] = '\n';
+      offset += 1;
+    }
+
+    fclose(f);
+    return ok;
+  }
+
+  // Reads and parses one cell.  Runs on a background thread.
+  std::unique_ptr<SceneStreamer::Cell> loadCell( std::string file, const Scene* resources, const SceneCellIndex::Cell* indexCell ) {
+    std::unique_ptr<SceneStreamer::Cell> cell(new SceneStreamer::Cell());
+    cell->x = indexCell->x;
+    cell->y = indexCell->y;
+    cell->z = indexCell->z;
+
+    std::vector<char> buffer;
+    if( readBlocks(file, indexCell->blocks, &buffer) && !buffer.empty() ) {
+      resources->parseBlocks(&buffer[0], buffer.size(), &cell->objects, &cell->lights);
+    }
+    return cell;
+  }
+
+  // Distance from a point to the nearest point of a cell.
+  float cellDistance( const SceneCellIndex::Cell& cell, float cellSize, const Scene::Vector& point ) {
+    const float minX = cell.x * cellSize;
+    const float minY = cell.y * cellSize;
+    const float minZ = cell.z * cellSize;
+    const float dx   = std::max(std::max(minX - point.x, point.x - (minX + cellSize)), 0.0f);
+    const float dy   = std::max(std::max(minY - point.y, point.y - (minY + cellSize)), 0.0f);
+    const float dz   = std::max(std::max(minZ - point.z, point.z - (minZ + cellSize)), 0.0f);
+    return sqrtf(dx*dx + dy*dy + dz*dz);
+  }
+}
+
+SceneStreamer::SceneStreamer( unsigned int maxPendingLoads )
+  : _residentCount(0), _maxPendingLoads(maxPendingLoads), _residentBytes(0), _pendingBytes(0) {
+}
+
+SceneStreamer::~SceneStreamer() {
+  clean();
+}
+
+bool SceneStreamer::open( const std::string& sceneFile, const SceneCellIndex& index ) {
+  clean();
+
+  // Block offsets are only good for the file as it was when the index was built.
+  if( !index.matches(sceneFile) ) {
+    return false;
+  }
+  _sceneFile = sceneFile;
+  _index     = index;
+
+  // Load the resources section on its own.  It is wrapped in a [scene] so that the regular parser accepts it.
+  std::vector<SceneCellIndex::Block> blocks(1, _index.resources());
+  std::vector<char>                  buffer;
+  if( _index.resources().size > 0 ) {
+    if( !readBlocks(_sceneFile, blocks, &buffer) ) {
+      clean();
+      return false;
+    }
+    const std::string text = "[scene]\n" + std::string(buffer.begin(), buffer.end()) + "[/scene]\n";
+    _resources.loadFromMemory(text.c_str(), text.size());
+  }
+
+  // Global blocks are always resident.
+  if( !_index.globalBlocks().empty() ) {
+    if( !readBlocks(_sceneFile, _index.globalBlocks(), &buffer) ) {
+      clean();
+      return false;
+    }
+    std::vector<Scene::Object> objects;
+    _resources.parseBlocks(&buffer[0], buffer.size(), &objects, &_globalLights);
+  }
+
+  _resident.resize(_index.cells().size());
+  return true;
+}
+
+void SceneStreamer::update( const Scene::Vector& focus, float radius, unsigned long long byteBudget ) {
+  const std::vector<SceneCellIndex::Cell>& cells = _index.cells();
+
+  // Gather the cells in range, nearest first.
+  std::vector<std::pair<float, unsigned int>> inRange;
+  for( unsigned int i = 0; i < cells.size(); ++i ) {
+    const float distance = cellDistance(cells[i], _index.cellSize(), focus);
+    if( distance <= radius ) {
+      inRange.push_back(std::make_pair(distance, i));
+    }
+  }
+  std::sort(inRange.begin(), inRange.end());
+
+  // Keep as many of the nearest cells as fit in the budget.
+  std::vector<bool>  wanted(cells.size(), false);
+  unsigned long long used = 0;
+  for( unsigned int i = 0; i < inRange.size(); ++i ) {
+    const unsigned int cell = inRange[i].second;
+    if( used + cells[cell].bytes > byteBudget ) {
+      break;
+    }
+    used        += cells[cell].bytes;
+    wanted[cell] = true;
+  }
+
+  // Update what's in flight.  Loads that are no longer wanted are left to finish and then discarded by poll().
+  std::vector<bool> pending(cells.size(), false);
+  for( unsigned int i = 0; i < _pending.size(); ++i ) {
+    _pending[i].wanted = wanted[_pending[i].cell];
+    if( _pending[i].wanted ) {
+      pending[_pending[i].cell] = true;
+    }
+  }
+
+  // Unload resident cells that are no longer wanted.
+  for( unsigned int i = 0; i < cells.size(); ++i ) {
+    if( !wanted[i] && _resident[i] != nullptr ) {
+      _resident[i].reset();
+      _residentCount -= 1;
+      _residentBytes -= cells[i].bytes;
+    }
+  }
+
+  // Request wanted cells that aren't already resident or on their way, nearest first.  Unwanted loads in flight
+  // still take memory until poll() discards them, so a request waits while it wouldn't fit alongside them.
+  for( unsigned int i = 0; i < inRange.size() && _pending.size() < _maxPendingLoads; ++i ) {
+    const unsigned int cell = inRange[i].second;
+    if( !wanted[cell] || _resident[cell] != nullptr || pending[cell] ) {
+      continue;
+    }
+    if( _residentBytes + _pendingBytes + cells[cell].bytes > byteBudget ) {
+      continue;
+    }
+    Pending request;
+    request.cell   = cell;
+    request.wanted = true;
+    request.result = std::async(std::launch::async, loadCell, _sceneFile, &_resources, &cells[cell]);
+    _pending.push_back(std::move(request));
+    _pendingBytes += cells[cell].bytes;
+  }
+}
+
+unsigned int SceneStreamer::poll() {
+  unsigned int completed = 0;
+  for( unsigned int i = 0; i < _pending.size(); ) {
+    Pending& request = _pending[i];
+    if( request.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready ) {
+      ++i;
+      continue;
+    }
+
+    std::unique_ptr<Cell>    cell  = request.result.get();
+    const unsigned long long bytes = _index.cells()[request.cell].bytes;
+    _pendingBytes -= bytes;
+    if( request.wanted && _resident[request.cell] == nullptr ) {
+      _resident[request.cell] = std::move(cell);
+      _residentCount         += 1;
+      _residentBytes         += bytes;
+      completed              += 1;
+    }
+
+    // Swap-remove the finished request.
+    if( i != _pending.size() - 1 ) {
+      _pending[i] = std::move(_pending.back());
+    }
+    _pending.pop_back();
+  }
+  return completed;
+}
+
+const Scene& SceneStreamer::resources() const {
+  return _resources;
+}
+
+const std::vector<Scene::Light>& SceneStreamer::globalLights() const {
+  return _globalLights;
+}
+
+const SceneStreamer::Cell* SceneStreamer::cell( unsigned int index ) const {
+  if( index >= _resident.size() ) {
+    return nullptr;
+  }
+  return _resident[index].get();
+}
+
+unsigned int SceneStreamer::cellCount() const {
+  return _resident.size();
+}
+
+unsigned int SceneStreamer::residentCount() const {
+  return _residentCount;
+}
+
+unsigned int SceneStreamer::pendingCount() const {
+  return _pending.size();
+}
+
+unsigned long long SceneStreamer::residentBytes() const {
+  return _residentBytes;
+}
+
+unsigned long long SceneStreamer::pendingBytes() const {
+  return _pendingBytes;
+}
+
+void SceneStreamer::clean() {
+  // Outstanding loads refer to the index and resources, so wait for them before letting go of either.
+  for( unsigned int i = 0; i < _pending.size(); ++i ) {
+    _pending[i].result.wait();
+  }
+  _pending.clear();
+  _resident.clear();
+  _residentCount = 0;
+  _residentBytes = 0;
+  _pendingBytes  = 0;
+  _globalLights.clear();
+  _resources     = Scene();
+  _index         = SceneCellIndex();
+  _sceneFile     = "";
+}
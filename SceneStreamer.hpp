@@ -0,0 +1,95 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SceneStreamer__
+#define __SceneStreamer__
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+#include "SceneCellIndex.hpp"
+
+// Streams the objects and lights of a large Scene file in and out by grid cell, using a SceneCellIndex built for
+// that file.  Resources and directional lights are loaded once by open() and stay resident, so the mesh and material
+// indices of streamed objects refer to resources() no matter which cells are loaded.  Cells are read and parsed on
+// background threads; update() requests them and poll() makes finished ones resident.  A cell is parsed on its own,
+// with no other objects to resolve names against, so streamed objects have no parents (parent is always -1).
+class SceneStreamer {
+public:
+  struct Cell {
+    int                        x;
+    int                        y;
+    int                        z;
+    std::vector<Scene::Object> objects;
+    std::vector<Scene::Light>  lights;
+
+    Cell()
+      : x(0), y(0), z(0) {
+    }
+  };
+
+public:
+  SceneStreamer( unsigned int maxPendingLoads=4 );
+  ~SceneStreamer();
+
+  // Fails if the index wasn't built from sceneFile as it is now.
+  bool                             open          ( const std::string& sceneFile, const SceneCellIndex& index );
+  // Requests every cell within radius of the focus, nearest first, for as long as the cells fit in the byte budget
+  // (measured in Scene file bytes).  Resident or pending cells that are out of range or over budget are dropped.
+  // Loads in flight count against the budget until they finish, wanted or not, and at most maxPendingLoads of them
+  // run at once, so some requests may wait for a later update().
+  void                             update        ( const Scene::Vector& focus, float radius, unsigned long long byteBudget );
+  // Makes any finished cell loads resident.  Returns how many became resident.
+  unsigned int                     poll          ();
+  const Scene&                     resources     () const;
+  const std::vector<Scene::Light>& globalLights  () const;
+  // Resident cells, indexed the same as the SceneCellIndex's cells.  Null if not resident.
+  const Cell*                      cell          ( unsigned int index ) const;
+  unsigned int                     cellCount     () const;
+  unsigned int                     residentCount () const;
+  unsigned int                     pendingCount  () const;
+  unsigned long long               residentBytes () const;
+  unsigned long long               pendingBytes  () const;
+
+private:
+  struct Pending {
+    unsigned int                       cell;
+    bool                               wanted;
+    std::future<std::unique_ptr<Cell>> result;
+  };
+
+private:
+  void clean();
+
+private:
+  std::string                        _sceneFile;
+  SceneCellIndex                     _index;
+  Scene                              _resources;
+  std::vector<Scene::Light>          _globalLights;
+  std::vector<std::unique_ptr<Cell>> _resident;
+  std::vector<Pending>               _pending;
+  unsigned int                       _residentCount;
+  unsigned int                       _maxPendingLoads;
+  unsigned long long                 _residentBytes;
+  unsigned long long                 _pendingBytes;
+};
+
+#endif /* __SceneStreamer__ */
@@ -26,9 +26,10 @@
 #include <sstream>
 
 namespace strutils {
-  static std::string removeSpaces( const std::string& str ) {
+  // Finds where removeSpaces() would cut a string, without copying it.
+  inline void trimRange( const char* const str, const int size, int* outBegin, int* outSize ) {
     int begin       = 0;
-    int end         = str.size()-1;
+    int end         = size-1;
     bool beginFound = false;
     bool endFound   = false;
     while( !beginFound || !endFound ) {
@@ -59,15 +60,95 @@ namespace strutils {
     }
 
     // Size safety check.  Add 1 to end as it catches the first non-space character.
-    const int size = (end+1) - begin;
-    if( size <= 0 ) {
-      return str;
+    *outBegin = begin;
+    *outSize  = (end+1) - begin;
+    if( *outSize <= 0 ) {
+      *outBegin = 0;
+      *outSize  = size;
     }
+  }
+
+  inline std::string removeSpaces( const std::string& str ) {
+    int begin = 0;
+    int size  = 0;
+    trimRange(str.c_str(), str.size(), &begin, &size);
+    return str.substr(begin, size);
+  }
 
-    return std::string(&str[begin], size);
+  // As above, but into an existing string so that its memory is reused.
+  inline void removeSpaces( const std::string& str, std::string* out ) {
+    int begin = 0;
+    int size  = 0;
+    trimRange(str.c_str(), str.size(), &begin, &size);
+    out->assign(str, begin, size);
+  }
+
+  // Part of a string, as an offset and a length.
+  struct Range {
+    int begin;
+    int size;
+  };
+
+  // As splitString(), but gives the pieces as ranges of the original string, writing at most maxRanges of them.
+  // Returns how many pieces there are in all.
+  inline unsigned int splitRanges( const char* const str, const int size, const char delim, bool keepSpaces, Range* outRanges, unsigned int maxRanges ) {
+    unsigned int count = 0;
+    long index = 0;
+    long end   = 0;
+    char c = ' ';
+    for( ;; ) {
+      // Bounds check of index.
+      if( index > size ) {
+        break;
+      }
+
+      // Read current character.
+      c = str[index];
+
+      // EoF check.
+      if( c == '\0' ) {
+        break;
+      }
+
+      // Update the end to the current index.
+      end = index;
+
+      // Read until we find the next delim character.
+      for( ;; ) {
+        c = str[end];
+        if( c == delim || c == '\0' ) {
+          break;
+        }
+        end += 1;
+      }
+
+      // Skip empty ranges.
+      const long len = end - index;
+      if( len <= 0 ) {
+        index += 1;
+        continue;
+      }
+
+      // Trim prefix and postfix whitespace, if required.
+      Range range;
+      range.begin = index;
+      range.size  = len;
+      if( !keepSpaces ) {
+        trimRange(&str[index], len, &range.begin, &range.size);
+        range.begin += index;
+      }
+      if( count < maxRanges ) {
+        outRanges[count] = range;
+      }
+      count += 1;
+
+      // Set the new index to the end + 1 to read the next character.
+      index = end + 1;
+    }
+    return count;
   }
 
-  static void splitString( const char* const str, const int size, const char delim, bool keepSpaces, std::vector<std::string>* outStr ) {
+  inline void splitString( const char* const str, const int size, const char delim, bool keepSpaces, std::vector<std::string>* outStr ) {
     // Safety check.
     if( outStr == nullptr ) {
       return;
@@ -0,0 +1,179 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Measures CompactScene against the Scene structs it copies.  A scene of randomly placed, rotated, and scaled objects
+// with path-like names is loaded and sorted spatially, then encoded both with and without names.  Reports the bytes
+// per object of each (counting name storage outside Scene::Object where the string doesn't hold it inline), and the
+// time per object to decode every object into structure-of-arrays floats, next to copying the same fields out of the
+// Scene structs.  Build and run with an optional object count:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. CompactSceneBench.cpp ../CompactScene.cpp ../Scene.cpp -o CompactSceneBench && ./CompactSceneBench 1000000
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CompactScene.hpp"
+#include "Scene.hpp"
+
+namespace {
+  const float        kWorldSize = 1000.0f;
+  const unsigned int kBatchSize = 1024;
+  const unsigned int kRepeats   = 5;
+
+  std::string makeScene( unsigned int objectCount ) {
+    std::mt19937                          random(1);
+    std::uniform_real_distribution<float> coordinate(0.0f, kWorldSize);
+    std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    std::ostringstream                    out;
+    out << "[scene]\n[objects]\n";
+    for( unsigned int i = 0; i < objectCount; ++i ) {
+      const float x = coordinate(random);
+      const float y = coordinate(random);
+      const float z = coordinate(random);
+      out << "[obj]\nname = props/crate_" << i << "\nposition = " << x << "," << y << "," << z << "\n";
+      out << "orientation = " << angle(random) << "," << angle(random) << "," << angle(random) << "\n";
+      out << "scale = " << scale(random) << "," << scale(random) << "," << scale(random) << "\n[/obj]\n";
+    }
+    out << "[/objects]\n[/scene]\n";
+    return out.str();
+  }
+
+  // The size of each object, plus its name's characters if they are held outside the object.
+  std::size_t sceneObjectBytes( const std::vector<Scene::Object>& objects ) {
+    std::size_t bytes = objects.size() * sizeof(Scene::Object);
+    for( unsigned int i = 0; i < objects.size(); ++i ) {
+      const char* const start = reinterpret_cast<const char*>(&objects[i]);
+      const char* const data  = objects[i].name.data();
+      if( data < start || data >= start + sizeof(Scene::Object) ) {
+        bytes += objects[i].name.capacity() + 1;
+      }
+    }
+    return bytes;
+  }
+
+  // What decode() is up against: copying position, orientation, and scale out of the Scene into the same layout.
+  struct CopyFromScene {
+    const std::vector<Scene::Object>* objects;
+
+    void operator()( unsigned int first, unsigned int count, float* outPositions, float* outRotations, float* outScales ) const {
+      for( unsigned int i = 0; i < count; ++i ) {
+        const Scene::Object& object = (*objects)[first + i];
+        outPositions[i]             = object.position.x;
+        outPositions[count + i]     = object.position.y;
+        outPositions[2 * count + i] = object.position.z;
+        outRotations[i]             = object.orientation.x;
+        outRotations[count + i]     = object.orientation.y;
+        outRotations[2 * count + i] = object.orientation.z;
+        outScales[i]                = object.scale.x;
+        outScales[count + i]        = object.scale.y;
+        outScales[2 * count + i]    = object.scale.z;
+      }
+    }
+  };
+
+  struct DecodeFromCompact {
+    const CompactScene* compact;
+
+    void operator()( unsigned int first, unsigned int count, float* outPositions, float* outRotations, float* outScales ) const {
+      compact->decode(first, count, outPositions, outRotations, outScales);
+    }
+  };
+
+  // The best of a few passes over every object in batches, in nanoseconds per object.
+  template<typename Reader>
+  double timeBatches( const Reader& reader, unsigned int objectCount, float* checksum ) {
+    std::vector<float> positions(3 * kBatchSize);
+    std::vector<float> rotations(4 * kBatchSize);
+    std::vector<float> scales(3 * kBatchSize);
+    double             best = 0.0;
+    for( unsigned int repeat = 0; repeat < kRepeats; ++repeat ) {
+      float                                                sum   = 0.0f;
+      const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+      for( unsigned int first = 0; first < objectCount; first += kBatchSize ) {
+        const unsigned int count = std::min(kBatchSize, objectCount - first);
+        reader(first, count, &positions[0], &rotations[0], &scales[0]);
+        // Uses the output so that it can't be optimized away.
+        sum += positions[count - 1] + rotations[count - 1] + scales[count - 1];
+      }
+      const double nanoseconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() * 1e9 / objectCount;
+      if( repeat == 0 || nanoseconds < best ) {
+        best = nanoseconds;
+      }
+      *checksum = sum;
+    }
+    return best;
+  }
+}
+
+int main( int argc, char* argv[] ) {
+  const unsigned int objectCount = (argc > 1) ? static_cast<unsigned int>(atoi(argv[1])) : 1000000;
+  const std::string  text        = makeScene(objectCount);
+  Scene              scene;
+  if( objectCount == 0 || !scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())) || scene.objectCount() != objectCount ) {
+    printf("FAILED: the scene didn't load\n");
+    return 1;
+  }
+  scene.sortSpatially();
+  const std::vector<Scene::Object>& objects = scene.objects();
+
+  CompactScene          named;
+  CompactScene          unnamed;
+  CompactScene::Options options;
+  named.encode(scene, options);
+  options.names = CompactScene::kNameModeDrop;
+  unnamed.encode(scene, options);
+
+  printf("%u objects, position error bound %g, %u blocks\n", objectCount, options.positionError, named.blockCount());
+  printf("Scene::Object:                 %6.1f bytes/object (%u in the struct)\n", static_cast<double>(sceneObjectBytes(objects)) / objectCount, static_cast<unsigned int>(sizeof(Scene::Object)));
+  printf("CompactScene with name table:  %6.1f bytes/object\n", static_cast<double>(named.byteSize()) / objectCount);
+  printf("CompactScene without names:    %6.1f bytes/object\n", static_cast<double>(unnamed.byteSize()) / objectCount);
+
+  // The decoded positions must be within the error bound, or the sizes above mean nothing.
+  std::vector<float> positions(3 * objectCount);
+  unnamed.decode(0, objectCount, &positions[0], nullptr, nullptr);
+  float largestError = 0.0f;
+  for( unsigned int i = 0; i < objectCount; ++i ) {
+    largestError = std::max(largestError, std::fabs(positions[i] - objects[i].position.x));
+    largestError = std::max(largestError, std::fabs(positions[objectCount + i] - objects[i].position.y));
+    largestError = std::max(largestError, std::fabs(positions[2 * objectCount + i] - objects[i].position.z));
+  }
+  printf("largest position error:        %g\n", largestError);
+
+  CopyFromScene copy;
+  copy.objects = &objects;
+  DecodeFromCompact decode;
+  decode.compact = &unnamed;
+  float        checksum   = 0.0f;
+  const double copyTime   = timeBatches(copy, objectCount, &checksum);
+  const double decodeTime = timeBatches(decode, objectCount, &checksum);
+  printf("copy from Scene::Object:       %6.2f ns/object (%.0f M objects/s)\n", copyTime, 1e3 / copyTime);
+  printf("CompactScene::decode():        %6.2f ns/object (%.0f M objects/s)\n", decodeTime, 1e3 / decodeTime);
+
+  if( largestError > options.positionError ) {
+    printf("FAILED: positions are off by more than the error bound (checksum %g)\n", checksum);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Measures SceneAnimator::evaluate() playing a scene forwards at 60 frames a second.  Every object has a position,
+// orientation, and scale track of ten keys a second apart, for three channels per track.  Reports the time per frame
+// of evaluate() both without and with writing results into the objects, next to evaluating every track directly
+// from its keys with a binary search each frame.  Build with -DSCENE_DISABLE_SIMD as well to time the scalar path.
+// Build and run with an optional object count:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. SceneAnimatorBench.cpp ../SceneAnimator.cpp ../Scene.cpp -o SceneAnimatorBench && ./SceneAnimatorBench 11400
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+#include "SceneAnimator.hpp"
+
+namespace {
+  const unsigned int kKeyCount   = 10;
+  const unsigned int kFrameCount = 600;
+  const float        kFrameTime  = 1.0f / 60.0f;
+  const char* const  kInterpolationNames[] = { "linear", "step", "cubic" };
+  const char* const  kChannelNames[]       = { "position", "orientation", "scale" };
+
+  std::string makeScene( unsigned int objectCount ) {
+    std::mt19937                          random(1);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    std::ostringstream                    out;
+    out << "[scene]\n[objects]\n";
+    for( unsigned int i = 0; i < objectCount; ++i ) {
+      out << "[obj]\nname = object" << i << "\n[/obj]\n";
+    }
+    out << "[/objects]\n[animations]\n";
+    for( unsigned int i = 0; i < objectCount; ++i ) {
+      for( unsigned int channel = 0; channel < 3; ++channel ) {
+        out << "[track]\nobject = object" << i << "\nchannel = " << kChannelNames[channel] << "\ninterpolation = " << kInterpolationNames[random() % 3] << "\n";
+        for( unsigned int key = 0; key < kKeyCount; ++key ) {
+          out << "key = " << key << ", " << value(random) << "," << value(random) << "," << value(random) << "\n";
+        }
+        out << "[/track]\n";
+      }
+    }
+    out << "[/animations]\n[/scene]\n";
+    return out.str();
+  }
+
+  float component( const Scene::Vector& vector, unsigned int axis ) {
+    return (axis == 0) ? vector.x : ((axis == 1) ? vector.y : vector.z);
+  }
+
+  // What evaluate() saves on: finding each channel's keys and interpolating them from scratch every frame.
+  void evaluateDirectly( const Scene& scene, float time, std::vector<Scene::Object>* objects ) {
+    const std::vector<Scene::Track>& tracks = scene.tracks();
+    for( unsigned int i = 0; i < tracks.size(); ++i ) {
+      const Scene::Track& track  = tracks[i];
+      const int           count  = track.times.size();
+      const int           key    = static_cast<int>(std::upper_bound(track.times.begin(), track.times.end(), time) - track.times.begin()) - 1;
+      float               result[3];
+      for( unsigned int axis = 0; axis < 3; ++axis ) {
+        if( key < 0 || key >= count - 1 ) {
+          result[axis] = component(track.values[(key < 0) ? 0 : count - 1], axis);
+          continue;
+        }
+        const float u  = (time - track.times[key]) / (track.times[key + 1] - track.times[key]);
+        const float p0 = component(track.values[(key > 0) ? key - 1 : key], axis);
+        const float p1 = component(track.values[key], axis);
+        const float p2 = component(track.values[key + 1], axis);
+        const float p3 = component(track.values[(key + 2 < count) ? key + 2 : key + 1], axis);
+        if( track.interpolation == Scene::kInterpolationStep ) {
+          result[axis] = p1;
+        } else if( track.interpolation == Scene::kInterpolationCubic ) {
+          result[axis] = 0.5f * (2.0f * p1 + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u * u + (3.0f * p1 - p0 - 3.0f * p2 + p3) * u * u * u);
+        } else {
+          result[axis] = p1 + (p2 - p1) * u;
+        }
+      }
+      Scene::Object& object = (*objects)[track.target];
+      Scene::Vector& vector = (track.channel == Scene::kTrackChannelPosition) ? object.position : ((track.channel == Scene::kTrackChannelOrientation) ? object.orientation : object.scale);
+      vector = Scene::Vector(result[0], result[1], result[2]);
+    }
+  }
+
+  double elapsedMilliseconds( const std::chrono::high_resolution_clock::time_point& start ) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() * 1e3;
+  }
+}
+
+int main( int argc, char* argv[] ) {
+  const unsigned int objectCount = (argc > 1) ? static_cast<unsigned int>(atoi(argv[1])) : 11400;
+  const std::string  text        = makeScene(objectCount);
+  Scene              scene;
+  if( !scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())) || scene.tracks().size() != 3 * objectCount ) {
+    printf("FAILED: the scene didn't load\n");
+    return 1;
+  }
+
+  SceneAnimator animator;
+  animator.bind(scene);
+  std::vector<Scene::Object> objects = scene.objects();
+  std::vector<Scene::Object> direct  = scene.objects();
+  printf("%u objects, %u channels, %u frames\n", objectCount, animator.channelCount(), kFrameCount);
+
+  std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for( unsigned int frame = 0; frame < kFrameCount; ++frame ) {
+    animator.evaluate(frame * kFrameTime, nullptr, nullptr);
+  }
+  const double evaluateOnly = elapsedMilliseconds(start) / kFrameCount;
+
+  start = std::chrono::high_resolution_clock::now();
+  for( unsigned int frame = 0; frame < kFrameCount; ++frame ) {
+    animator.evaluate(frame * kFrameTime, &objects, nullptr);
+  }
+  const double evaluateAndWrite = elapsedMilliseconds(start) / kFrameCount;
+
+  start = std::chrono::high_resolution_clock::now();
+  for( unsigned int frame = 0; frame < kFrameCount; ++frame ) {
+    evaluateDirectly(scene, frame * kFrameTime, &direct);
+  }
+  const double directly = elapsedMilliseconds(start) / kFrameCount;
+
+  printf("evaluate() without writing results: %7.3f ms/frame\n", evaluateOnly);
+  printf("evaluate() writing into objects:    %7.3f ms/frame\n", evaluateAndWrite);
+  printf("direct evaluation from the keys:    %7.3f ms/frame\n", directly);
+
+  // Both end on the same frame, so they must agree.
+  float largestError = 0.0f;
+  for( unsigned int i = 0; i < objectCount; ++i ) {
+    for( unsigned int axis = 0; axis < 3; ++axis ) {
+      largestError = std::max(largestError, std::fabs(component(objects[i].position, axis) - component(direct[i].position, axis)));
+      largestError = std::max(largestError, std::fabs(component(objects[i].orientation, axis) - component(direct[i].orientation, axis)));
+      largestError = std::max(largestError, std::fabs(component(objects[i].scale, axis) - component(direct[i].scale, axis)));
+    }
+  }
+  printf("largest difference on the last frame: %g\n", largestError);
+  if( largestError > 1e-3f ) {
+    printf("FAILED: evaluate() and direct evaluation disagree\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Measures what Scene::sortSpatially() does for neighbourhood queries.  A scene of randomly placed objects (in
+// random file order) is loaded, a uniform grid of object indices is built over it, and the same set of radius
+// queries is run against the objects before and after sorting.  Reports the time per query and, as stand-ins for
+// cache misses that don't need hardware counters, what each query reads of the object array: distinct 64-byte lines,
+// distinct 4 KiB pages, and runs of adjacent lines (each run costing roughly one miss once the prefetcher catches
+// on).  An object is bigger than a line, so sorting can't change the line count, only how scattered the lines are.
+// For real cache misses, run under perf (e.g. perf stat -e cache-misses,dTLB-load-misses).  Build and run with an
+// optional object count:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. SpatialSortBench.cpp ../Scene.cpp -o SpatialSortBench && ./SpatialSortBench 500000
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+
+namespace {
+  const float        kWorldSize   = 200.0f;
+  const float        kQueryRadius = 5.0f;
+  const unsigned int kQueryCount  = 100000;
+  const unsigned int kRepeats     = 5;
+  const std::size_t  kLineSize    = 64;
+  const std::size_t  kPageSize    = 4096;
+
+  std::string makeScene( unsigned int objectCount ) {
+    std::mt19937                          random(1);
+    std::uniform_real_distribution<float> coordinate(0.0f, kWorldSize);
+    std::ostringstream                    out;
+    out << "[scene]\n[objects]\n";
+    for( unsigned int i = 0; i < objectCount; ++i ) {
+      const float x = coordinate(random);
+      const float y = coordinate(random);
+      const float z = coordinate(random);
+      out << "[obj]\nname = object" << i << "\nposition = " << x << "," << y << "," << z << "\n[/obj]\n";
+    }
+    out << "[/objects]\n[/scene]\n";
+    return out.str();
+  }
+
+  // Object indices bucketed by cell, each cell one query radius across.
+  struct Grid {
+    int                       cells;
+    std::vector<unsigned int> starts;
+    std::vector<unsigned int> indices;
+
+    int cellOf( float value ) const {
+      return std::min(cells - 1, std::max(0, static_cast<int>(value / kQueryRadius)));
+    }
+
+    unsigned int cellIndex( int x, int y, int z ) const {
+      return static_cast<unsigned int>((z * cells + y) * cells + x);
+    }
+
+    void build( const std::vector<Scene::Object>& objects ) {
+      cells = static_cast<int>(std::ceil(kWorldSize / kQueryRadius));
+      starts.assign(static_cast<std::size_t>(cells) * cells * cells + 1, 0);
+      indices.resize(objects.size());
+      std::vector<unsigned int> objectCells(objects.size());
+      for( unsigned int i = 0; i < objects.size(); ++i ) {
+        const Scene::Vector& position = objects[i].position;
+        objectCells[i] = cellIndex(cellOf(position.x), cellOf(position.y), cellOf(position.z));
+        starts[objectCells[i] + 1] += 1;
+      }
+      for( std::size_t cell = 1; cell < starts.size(); ++cell ) {
+        starts[cell] += starts[cell - 1];
+      }
+      std::vector<unsigned int> next(starts.begin(), starts.end() - 1);
+      for( unsigned int i = 0; i < objects.size(); ++i ) {
+        indices[next[objectCells[i]]++] = i;
+      }
+    }
+  };
+
+  struct Result {
+    double             nanosecondsPerQuery;
+    double             linesPerQuery;
+    double             pagesPerQuery;
+    double             runsPerQuery;
+    unsigned long long found;
+  };
+
+  // Counts the objects within the query radius of each query point.  Lines are counted in a separate, untimed pass.
+  Result runQueries( const std::vector<Scene::Object>& objects, const std::vector<Scene::Vector>& queries ) {
+    Grid grid;
+    grid.build(objects);
+    const float radiusSquared = kQueryRadius * kQueryRadius;
+
+    Result result;
+    result.nanosecondsPerQuery = 0.0;
+    result.linesPerQuery       = 0.0;
+    result.pagesPerQuery       = 0.0;
+    result.runsPerQuery        = 0.0;
+    result.found               = 0;
+    std::vector<std::size_t> lines;
+    for( unsigned int repeat = 0; repeat <= kRepeats; ++repeat ) {
+      // The last pass counts lines rather than being timed.
+      const bool                                           countLines = repeat == kRepeats;
+      unsigned long long                                   found      = 0;
+      unsigned long long                                   lineCount  = 0;
+      unsigned long long                                   pageCount  = 0;
+      unsigned long long                                   runCount   = 0;
+      const std::chrono::high_resolution_clock::time_point start      = std::chrono::high_resolution_clock::now();
+      for( unsigned int q = 0; q < queries.size(); ++q ) {
+        const Scene::Vector& query = queries[q];
+        const int            minX  = grid.cellOf(query.x - kQueryRadius);
+        const int            maxX  = grid.cellOf(query.x + kQueryRadius);
+        const int            minY  = grid.cellOf(query.y - kQueryRadius);
+        const int            maxY  = grid.cellOf(query.y + kQueryRadius);
+        const int            minZ  = grid.cellOf(query.z - kQueryRadius);
+        const int            maxZ  = grid.cellOf(query.z + kQueryRadius);
+        lines.clear();
+        for( int z = minZ; z <= maxZ; ++z ) {
+          for( int y = minY; y <= maxY; ++y ) {
+            for( int x = minX; x <= maxX; ++x ) {
+              const unsigned int cell = grid.cellIndex(x, y, z);
+              for( unsigned int i = grid.starts[cell]; i < grid.starts[cell + 1]; ++i ) {
+                const Scene::Object& object = objects[grid.indices[i]];
+                const float          dx     = object.position.x - query.x;
+                const float          dy     = object.position.y - query.y;
+                const float          dz     = object.position.z - query.z;
+                found += (dx * dx + dy * dy + dz * dz <= radiusSquared) ? 1 : 0;
+                if( countLines ) {
+                  lines.push_back(reinterpret_cast<std::size_t>(&object.position) / kLineSize);
+                }
+              }
+            }
+          }
+        }
+        if( countLines ) {
+          std::sort(lines.begin(), lines.end());
+          lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+          for( std::size_t line = 0; line < lines.size(); ++line ) {
+            runCount  += (line == 0 || lines[line] != lines[line - 1] + 1) ? 1 : 0;
+            pageCount += (line == 0 || lines[line] * kLineSize / kPageSize != lines[line - 1] * kLineSize / kPageSize) ? 1 : 0;
+          }
+          lineCount += lines.size();
+        }
+      }
+      const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+      if( countLines ) {
+        result.linesPerQuery = static_cast<double>(lineCount) / queries.size();
+        result.pagesPerQuery = static_cast<double>(pageCount) / queries.size();
+        result.runsPerQuery  = static_cast<double>(runCount) / queries.size();
+      } else {
+        const double nanoseconds = seconds * 1e9 / queries.size();
+        if( repeat == 0 || nanoseconds < result.nanosecondsPerQuery ) {
+          result.nanosecondsPerQuery = nanoseconds;
+        }
+      }
+      result.found = found;
+    }
+    return result;
+  }
+}
+
+int main( int argc, char* argv[] ) {
+  const unsigned int objectCount = (argc > 1) ? static_cast<unsigned int>(atoi(argv[1])) : 500000;
+  const std::string  text        = makeScene(objectCount);
+  Scene              scene;
+  if( !scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())) || scene.objectCount() != objectCount ) {
+    printf("FAILED: the scene didn't load\n");
+    return 1;
+  }
+
+  std::mt19937                          random(2);
+  std::uniform_real_distribution<float> coordinate(0.0f, kWorldSize);
+  std::vector<Scene::Vector>            queries(kQueryCount);
+  for( unsigned int q = 0; q < kQueryCount; ++q ) {
+    queries[q].x = coordinate(random);
+    queries[q].y = coordinate(random);
+    queries[q].z = coordinate(random);
+  }
+
+  printf("%u objects of %u bytes, %u queries of radius %g\n", objectCount, static_cast<unsigned int>(sizeof(Scene::Object)), kQueryCount, kQueryRadius);
+  const Result before = runQueries(scene.objects(), queries);
+  printf("file order:   %8.1f ns/query, %7.1f lines, %7.1f pages, %7.1f runs of lines per query\n", before.nanosecondsPerQuery, before.linesPerQuery, before.pagesPerQuery, before.runsPerQuery);
+  scene.sortSpatially();
+  const Result after = runQueries(scene.objects(), queries);
+  printf("Morton order: %8.1f ns/query, %7.1f lines, %7.1f pages, %7.1f runs of lines per query\n", after.nanosecondsPerQuery, after.linesPerQuery, after.pagesPerQuery, after.runsPerQuery);
+
+  // Sorting moves objects but must not change which ones each query finds.
+  if( before.found != after.found ) {
+    printf("FAILED: %llu objects found before sorting but %llu after\n", before.found, after.found);
+    return 1;
+  }
+  return 0;
+}
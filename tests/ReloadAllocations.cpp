@@ -0,0 +1,122 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Checks that reloading a Scene from a file of the same size doesn't allocate.  Every allocation through operator
+// new is counted, and a scene with a bit of everything (including forward parent references, unsorted keys, and a
+// track that gets dropped) is loaded a few times both with and without a caller's buffer.  Build and run with:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. ReloadAllocations.cpp ../Scene.cpp -o ReloadAllocations && ./ReloadAllocations
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+
+namespace {
+  unsigned long long gAllocations = 0;
+
+  const char* const kSceneFile = "ReloadAllocations.scn";
+
+  bool writeScene( const std::string& file ) {
+    std::ofstream out(file.c_str());
+    out << "[scene]\n[resources]\n";
+    for( unsigned int i = 0; i < 8; ++i ) {
+      out << "[texture]\nfile = textures/texture_with_a_long_path_" << i << ".png\nname = tex" << i << "\n[/texture]\n";
+      out << "[mesh]\nfile = meshes/mesh" << i << ".obj\nname = mesh" << i << "\n[/mesh]\n";
+      out << "[material]\nname = material" << i << "\ncolor = 1,0.5,0.25\nspecSize = 0.5\ndiffuseTex = tex" << i << "\nnormalTex = tex" << (7 - i) << "\n[/material]\n";
+    }
+    out << "[/resources]\n[objects]\n";
+    for( unsigned int i = 0; i < 2000; ++i ) {
+      out << "[obj]\nname = object_" << std::string(i % 40, 'x') << i << "\nposition = " << i << ",2,3\norientation = 0,90,0\nscale = 1,1,1\n";
+      out << "mesh = mesh" << (i % 8) << "\nmaterial = material" << (i % 8) << "\n";
+      if( i % 3 == 1 ) {
+        out << "parent = object_" << std::string((i + 1) % 40, 'x') << (i + 1) << "\n";
+      }
+      out << "[/obj]\n";
+    }
+    out << "[/objects]\n[lights]\n";
+    for( unsigned int i = 0; i < 4; ++i ) {
+      out << "[light]\ntype = point\nposition = " << i << ",1,1\nrange = 10\n[/light]\n";
+    }
+    out << "[/lights]\n[animations]\n";
+    for( unsigned int i = 0; i < 200; ++i ) {
+      // Every tenth track animates something objects don't have, and is dropped.
+      out << "[track]\nobject = object_" << std::string(i % 40, 'x') << i << "\nchannel = " << ((i % 10 == 5) ? "diffuseIntensity" : "position") << "\n";
+      for( unsigned int key = 0; key < 1 + i % 7; ++key ) {
+        out << "key = " << ((key * 7) % 5) << ", " << key << "," << i << ",0\n";
+      }
+      out << "[/track]\n";
+    }
+    out << "[/animations]\n[/scene]\n";
+    return out.good();
+  }
+}
+
+void* operator new( std::size_t size ) {
+  gAllocations += 1;
+  void* const memory = malloc((size == 0) ? 1 : size);
+  if( memory == nullptr ) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete( void* memory ) noexcept {
+  free(memory);
+}
+
+void operator delete( void* memory, std::size_t ) noexcept {
+  free(memory);
+}
+
+int main() {
+  if( !writeScene(kSceneFile) ) {
+    printf("FAILED: couldn't write %s\n", kSceneFile);
+    return 1;
+  }
+
+  // Made once here, as making it for each load would count as an allocation.
+  const std::string file(kSceneFile);
+  bool              passed = true;
+  for( unsigned int pass = 0; pass < 2; ++pass ) {
+    const bool        ownBuffer = pass == 0;
+    Scene             scene;
+    std::vector<char> buffer;
+    for( unsigned int load = 0; load < 4; ++load ) {
+      const unsigned long long before = gAllocations;
+      const bool               loaded = ownBuffer ? scene.load(file) : scene.load(file, buffer);
+      const unsigned long long count  = gAllocations - before;
+      printf("%s load %u: %llu allocations\n", ownBuffer ? "load( file )        " : "load( file, buffer )", load, count);
+      if( !loaded || scene.objectCount() != 2000 || scene.trackCount() != 180 ) {
+        printf("FAILED: the scene didn't load as expected\n");
+        passed = false;
+      }
+      // Everything after the first load should fit in memory from before.
+      if( load > 0 && count != 0 ) {
+        passed = false;
+      }
+    }
+  }
+
+  remove(kSceneFile);
+  printf("%s\n", passed ? "PASSED" : "FAILED");
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Checks that save() writes what load() reads back.  A scene with every kind of record, random values, parents, and
+// tracks is saved, loaded, and saved again; both loads must match the original field for field (compared through
+// saveBinary(), which refers to records by index) and the two texts must be the same.  Saving on several threads
+// must write the same text as saving on one.  Scenes that the text can't hold (a record referred to by a name an
+// earlier record has, or a string with a line break in it) must fail to save and leave the file alone.  Build and
+// run with:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. SaveRoundTrip.cpp ../Scene.cpp -o SaveRoundTrip && ./SaveRoundTrip
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include "Scene.hpp"
+
+namespace {
+  const char* const kSceneFile    = "SaveRoundTrip.scn";
+  const char* const kSnapshotFile = "SaveRoundTrip.snapshot";
+
+  bool gPassed = true;
+
+  void check( bool condition, const char* what ) {
+    if( !condition ) {
+      printf("FAILED: %s\n", what);
+      gPassed = false;
+    }
+  }
+
+  float randomFloat() {
+    return static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 200.0f - 100.0f;
+  }
+
+  // Textures, meshes, and materials using them, objects with parents before and after them in the file, lights of
+  // every type, and object and light tracks.  Names that are repeated are only referred to on their first record.
+  std::string makeScene() {
+    std::ostringstream out;
+    out.precision(9);
+    out << "[scene]\n[resources]\n";
+    for( unsigned int i = 0; i < 8; ++i ) {
+      out << "[texture]\nfile = textures/texture" << i << ".png\nname = texture" << i << "\n[/texture]\n";
+      out << "[mesh]\nfile = meshes/mesh" << i << ".obj\nname = mesh" << (i % 6) << "\n[/mesh]\n";
+      out << "[material]\nname = material " << i << "\ncolor = " << randomFloat() << "," << randomFloat() << "," << randomFloat();
+      out << "\nspecSize = " << randomFloat() << "\ndiffuseTex = texture" << i << "\nnormalTex = texture" << ((i * 3) % 8) << "\n[/material]\n";
+    }
+    out << "[/resources]\n[objects]\n";
+    for( unsigned int i = 0; i < 40; ++i ) {
+      out << "[obj]\nname = [object] " << (i % 36) << "\nposition = " << randomFloat() << "," << randomFloat() << "," << randomFloat();
+      out << "\norientation = " << randomFloat() << "," << randomFloat() << "," << randomFloat();
+      out << "\nmesh = mesh" << (i % 6) << "\nmaterial = material " << (i % 8) << "\n";
+      if( i % 4 == 1 ) {
+        out << "parent = [object] " << ((i * 7) % 30) << "\n";
+      }
+      out << "[/obj]\n";
+    }
+    out << "[/objects]\n[lights]\n";
+    const char* const types[] = { "point", "spot", "directional" };
+    for( unsigned int i = 0; i < 6; ++i ) {
+      out << "[light]\ntype = " << types[i % 3] << "\nposition = " << randomFloat() << ",1,0\nrange = " << randomFloat();
+      out << "\nshadows = " << ((i % 2) ? "true" : "false") << "\nshadowBias = " << randomFloat() / 1000.0f << "\n[/light]\n";
+    }
+    out << "[/lights]\n[animations]\n";
+    out << "[track]\nobject = [object] 3\nchannel = position\ninterpolation = linear\nkey = 0, 0,0,0\nkey = 1.5, 1,2,3\n[/track]\n";
+    out << "[track]\nobject = [object] 20\nchannel = rotation\nkey = 0, 0,0,0\nkey = 0.25, 0,90,0\n[/track]\n";
+    out << "[track]\nlight = 4\nchannel = diffuseIntensity\nkey = 0, 1\nkey = 1, " << randomFloat() << "\n[/track]\n";
+    out << "[/animations]\n[/scene]\n";
+    return out.str();
+  }
+
+  std::string saved( const Scene& scene, unsigned int threadCount ) {
+    std::ostringstream out;
+    check(scene.save(out, threadCount), "the scene didn't save");
+    return out.str();
+  }
+
+  // The scene as saveBinary() writes it.
+  std::string snapshot( const Scene& scene ) {
+    std::string bytes;
+    check(scene.saveBinary(kSnapshotFile), "couldn't save a snapshot");
+    FILE* const f = fopen(kSnapshotFile, "rb");
+    char        chunk[4096];
+    size_t      read = 0;
+    while( f != nullptr && (read = fread(chunk, 1, sizeof(chunk), f)) > 0 ) {
+      bytes.append(chunk, read);
+    }
+    if( f != nullptr ) {
+      fclose(f);
+    }
+    remove(kSnapshotFile);
+    return bytes;
+  }
+
+  std::string fileText( const char* file ) {
+    std::string text;
+    FILE* const f = fopen(file, "rb");
+    char        chunk[4096];
+    size_t      read = 0;
+    while( f != nullptr && (read = fread(chunk, 1, sizeof(chunk), f)) > 0 ) {
+      text.append(chunk, read);
+    }
+    if( f != nullptr ) {
+      fclose(f);
+    }
+    return text;
+  }
+
+  void testRoundTrip( const Scene& original ) {
+    check(original.objects()[1].parent != -1 && original.tracks().size() == 3, "round trip: the scene isn't as built");
+
+    const std::string text = saved(original, 1);
+    Scene             loaded;
+    check(loaded.loadFromMemory(text.c_str(), static_cast<long>(text.size())), "round trip: the saved text didn't load");
+    check(snapshot(loaded) == snapshot(original), "round trip: the loaded scene isn't the one saved");
+    check(saved(loaded, 1) == text, "round trip: saving the loaded scene wrote different text");
+    for( unsigned int threadCount = 2; threadCount <= 8; threadCount *= 2 ) {
+      check(saved(original, threadCount) == text, "round trip: saving on several threads wrote different text");
+    }
+
+    check(original.save(kSceneFile, 4), "round trip: couldn't save to a file");
+    Scene fromFile;
+    check(fromFile.load(kSceneFile) && snapshot(fromFile) == snapshot(original), "round trip: the saved file didn't load back");
+    remove(kSceneFile);
+  }
+
+  // Applies one edit to a copy of the scene and checks whether it still saves, and that a failed save leaves an
+  // existing file as it was and writes nothing to a stream.
+  template<typename Record>
+  void checkEdit( const Scene& scene, Scene::RecordType type, unsigned int index, const Record& record, bool saves, const char* what ) {
+    Scene edited = scene;
+    check(edited.beginEdit() && edited.modify(edited.handle(type, index), record) && edited.commitEdit(), what);
+
+    const std::string before = "not a scene\n";
+    FILE* const       f      = fopen(kSceneFile, "wb");
+    if( f != nullptr ) {
+      fwrite(before.data(), 1, before.size(), f);
+      fclose(f);
+    }
+    std::ostringstream out;
+    const bool         toStream = edited.save(out);
+    const bool         toFile   = edited.save(kSceneFile);
+    check(toStream == saves && toFile == saves, what);
+    if( !saves ) {
+      check(out.str().empty() && fileText(kSceneFile) == before, what);
+      return;
+    }
+
+    const std::string text = out.str();
+    Scene             loaded;
+    check(loaded.loadFromMemory(text.c_str(), static_cast<long>(text.size())) && snapshot(loaded) == snapshot(edited), what);
+    remove(kSceneFile);
+  }
+
+  void testRefusals( const Scene& scene ) {
+    // Nothing refers to object 4, so object 36 may share its name.
+    Scene::Object object = scene.objects()[36];
+    object.name = "[object] 4";
+    checkEdit(scene, Scene::kRecordTypeObject, 36, object, true, "refusals: an unreferred repeated name didn't save");
+
+    // Object 7 is the parent of object 1; giving object 0 its name would make the parent read back as object 0.
+    check(scene.objects()[1].parent == 7, "refusals: object 1's parent isn't object 7");
+    object      = scene.objects()[0];
+    object.name = scene.objects()[7].name;
+    checkEdit(scene, Scene::kRecordTypeObject, 0, object, false, "refusals: a parent named after an earlier object saved");
+
+    // Object 3 is animated.
+    object      = scene.objects()[2];
+    object.name = scene.objects()[3].name;
+    checkEdit(scene, Scene::kRecordTypeObject, 2, object, false, "refusals: an animated object named after an earlier one saved");
+
+    // A later record taking the name of a referred one is fine: the reference still finds the earlier record.
+    object      = scene.objects()[39];
+    object.name = scene.objects()[7].name;
+    checkEdit(scene, Scene::kRecordTypeObject, 39, object, true, "refusals: a later record with a referred name didn't save");
+
+    Scene::Mesh mesh = scene.meshes()[6];
+    mesh.name = scene.meshes()[2].name;
+    checkEdit(scene, Scene::kRecordTypeMesh, 6, mesh, true, "refusals: an unused mesh with a used mesh's name didn't save");
+    mesh      = scene.meshes()[1];
+    mesh.name = scene.meshes()[0].name;
+    checkEdit(scene, Scene::kRecordTypeMesh, 1, mesh, false, "refusals: a used mesh named after an earlier one saved");
+
+    Scene::Material material = scene.materials()[5];
+    material.name = "";
+    checkEdit(scene, Scene::kRecordTypeMaterial, 5, material, false, "refusals: a used material with no name saved");
+
+    Scene::Texture texture = scene.textures()[2];
+    texture.name = "texture 2\n[/texture]";
+    checkEdit(scene, Scene::kRecordTypeTexture, 2, texture, false, "refusals: a name with a line break saved");
+    texture      = scene.textures()[2];
+    texture.file = "c:\\textures\\brick = old.png";
+    checkEdit(scene, Scene::kRecordTypeTexture, 2, texture, false, "refusals: a file with an '=' saved");
+    texture      = scene.textures()[2];
+    texture.name = " texture 2";
+    checkEdit(scene, Scene::kRecordTypeTexture, 2, texture, false, "refusals: a name with a leading space saved");
+    texture      = scene.textures()[2];
+    texture.name = "texture [2] # \\ \"two\"";
+    checkEdit(scene, Scene::kRecordTypeTexture, 2, texture, true, "refusals: a name with brackets and quotes didn't save");
+  }
+}
+
+int main() {
+  srand(42);
+  const std::string text = makeScene();
+  Scene             scene;
+  check(scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())), "the scene didn't load");
+
+  testRoundTrip(scene);
+  testRefusals(scene);
+
+  printf(gPassed ? "PASSED\n" : "FAILED\n");
+  return gPassed ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Checks SceneAnimator against a direct, scalar evaluation of every track.  Random tracks of every channel and
+// interpolation are played forwards in small steps, backwards, at random times, and at infinite times, with a
+// channel count that isn't a multiple of four.  Build and run with (adding -DSCENE_DISABLE_SIMD for the scalar path):
+//
+//   g++ -std=c++11 -O2 -pthread -I.. SceneAnimator.cpp ../SceneAnimator.cpp ../Scene.cpp -o SceneAnimator && ./SceneAnimator
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+#include "SceneAnimator.hpp"
+
+namespace {
+  const unsigned int kObjectCount = 20;
+  const unsigned int kLightCount  = 5;
+  const char* const  kInterpolationNames[] = { "linear", "step", "cubic" };
+  const char* const  kObjectChannelNames[] = { "position", "orientation", "scale" };
+
+  float randomFloat( float low, float high ) {
+    return low + (high - low) * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+  }
+
+  // Tracks with 1 to 6 keys in random order, some sharing a time.  Three channels per object track and one per light
+  // track make 185 channels, so the last group of four has padding.
+  std::string makeScene() {
+    std::ostringstream out;
+    out << "[scene]\n[objects]\n";
+    for( unsigned int i = 0; i < kObjectCount; ++i ) {
+      out << "[obj]\nname = object" << i << "\n[/obj]\n";
+    }
+    out << "[/objects]\n[lights]\n";
+    for( unsigned int i = 0; i < kLightCount; ++i ) {
+      out << "[light]\ntype = point\n[/light]\n";
+    }
+    out << "[/lights]\n[animations]\n";
+    for( unsigned int i = 0; i < 3 * kObjectCount + kLightCount; ++i ) {
+      const bool light = i >= 3 * kObjectCount;
+      out << "[track]\n";
+      if( light ) {
+        out << "light = " << (i - 3 * kObjectCount) << "\nchannel = diffuseIntensity\n";
+      } else {
+        out << "object = object" << (i / 3) << "\nchannel = " << kObjectChannelNames[i % 3] << "\n";
+      }
+      out << "interpolation = " << kInterpolationNames[rand() % 3] << "\n";
+      const unsigned int keys = 1 + rand() % 6;
+      for( unsigned int key = 0; key < keys; ++key ) {
+        out << "key = " << static_cast<float>(rand() % 20) * 0.5f;
+        for( unsigned int component = 0; component < (light ? 1u : 3u); ++component ) {
+          out << ", " << randomFloat(-10.0f, 10.0f);
+        }
+        out << "\n";
+      }
+      out << "[/track]\n";
+    }
+    out << "[/animations]\n[/scene]\n";
+    return out.str();
+  }
+
+  float component( const Scene::Vector& vector, unsigned int axis ) {
+    return (axis == 0) ? vector.x : ((axis == 1) ? vector.y : vector.z);
+  }
+
+  // One component of a track at a time, straight from its keys.
+  float reference( const Scene::Track& track, unsigned int axis, float time ) {
+    const int count = track.times.size();
+    int       key   = -1;
+    while( key + 1 < count && track.times[key + 1] <= time ) {
+      key += 1;
+    }
+    if( key < 0 ) {
+      return component(track.values[0], axis);
+    }
+    if( key == count - 1 ) {
+      return component(track.values[count - 1], axis);
+    }
+
+    const float u  = (time - track.times[key]) / (track.times[key + 1] - track.times[key]);
+    const float p0 = component(track.values[(key > 0) ? key - 1 : key], axis);
+    const float p1 = component(track.values[key], axis);
+    const float p2 = component(track.values[key + 1], axis);
+    const float p3 = component(track.values[(key + 2 < count) ? key + 2 : key + 1], axis);
+    switch( track.interpolation ) {
+      case Scene::kInterpolationStep: {
+        return p1;
+      }
+      case Scene::kInterpolationCubic: {
+        return 0.5f * (2.0f * p1 + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u * u + (3.0f * p1 - p0 - 3.0f * p2 + p3) * u * u * u);
+      }
+      default: {
+        return p1 + (p2 - p1) * u;
+      }
+    }
+  }
+
+  // Compares what evaluate() wrote for every track with the reference.  Finite times beyond the keys hold them, just
+  // as infinite ones do, so the reference is given a large finite time for those.
+  bool matches( const Scene& scene, const std::vector<Scene::Object>& objects, const std::vector<Scene::Light>& lights, float time ) {
+    const float at = std::min(std::max(time, -1e30f), 1e30f);
+    for( unsigned int i = 0; i < scene.tracks().size(); ++i ) {
+      const Scene::Track& track = scene.tracks()[i];
+      for( unsigned int axis = 0; axis < ((track.channel == Scene::kTrackChannelDiffuseIntensity) ? 1u : 3u); ++axis ) {
+        float actual = 0.0f;
+        if( track.targetType == Scene::kTrackTargetLight ) {
+          actual = lights[track.target].diffuseIntensity;
+        } else {
+          const Scene::Object& object = objects[track.target];
+          actual = component((track.channel == Scene::kTrackChannelPosition) ? object.position : ((track.channel == Scene::kTrackChannelOrientation) ? object.orientation : object.scale), axis);
+        }
+        const float expected = reference(track, axis, at);
+        if( !(std::fabs(actual - expected) <= 1e-4f * (1.0f + std::fabs(expected))) ) {
+          printf("FAILED: track %u axis %u at time %g gave %g rather than %g\n", i, axis, time, actual, expected);
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
+int main() {
+  srand(1);
+  bool passed = true;
+  for( unsigned int round = 0; round < 20 && passed; ++round ) {
+    const std::string text = makeScene();
+    Scene             scene;
+    if( !scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())) || scene.tracks().size() != 3 * kObjectCount + kLightCount ) {
+      printf("FAILED: the scene didn't load\n");
+      return 1;
+    }
+    SceneAnimator animator;
+    animator.bind(scene);
+    if( animator.channelCount() % 4 == 0 ) {
+      printf("FAILED: the channel count should leave padding\n");
+      return 1;
+    }
+    std::vector<Scene::Object> objects = scene.objects();
+    std::vector<Scene::Light>  lights  = scene.lights();
+
+    std::vector<float> times;
+    for( float time = -1.0f; time < 11.0f; time += 0.05f ) {
+      times.push_back(time);
+    }
+    for( float time = 11.0f; time > -1.0f; time -= 0.3f ) {
+      times.push_back(time);
+    }
+    for( unsigned int i = 0; i < 200; ++i ) {
+      times.push_back((rand() % 4 == 0) ? static_cast<float>(rand() % 20) * 0.5f : randomFloat(-2.0f, 12.0f));
+    }
+    times.push_back(std::numeric_limits<float>::infinity());
+    times.push_back(-std::numeric_limits<float>::infinity());
+    times.push_back(1e30f);
+    times.push_back(std::numeric_limits<float>::infinity());
+    for( unsigned int i = 0; i < times.size() && passed; ++i ) {
+      animator.evaluate(times[i], &objects, &lights);
+      passed = matches(scene, objects, lights, times[i]);
+    }
+
+    // A time that isn't a number leaves the results of the last evaluate() alone.
+    animator.evaluate(std::numeric_limits<float>::quiet_NaN(), &objects, &lights);
+    passed = passed && matches(scene, objects, lights, times.back());
+  }
+
+  printf("%s\n", passed ? "PASSED" : "FAILED");
+  return passed ? 0 : 1;
+}
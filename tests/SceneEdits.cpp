@@ -0,0 +1,384 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Checks edit transactions and Journals.  Random adds, modifies, and removes of every kind of record are made to a
+// loaded scene and then rolled back, or committed and then reverted and applied again.  After each step the scene
+// is compared with what saveBinary() wrote at the same point, and the name lookup and the mesh, material, and texture
+// user lists are checked against a search of the records.  Handles must go stale when their record is removed and
+// stay that way, whatever takes their slot next.  sortSpatially() must refuse to run during a transaction.  Build and
+// run with:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. SceneEdits.cpp ../Scene.cpp -o SceneEdits && ./SceneEdits
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+
+namespace {
+  const char* const kJournalFile  = "SceneEdits.journal";
+  const char* const kSnapshotFile = "SceneEdits.snapshot";
+
+  bool gPassed = true;
+
+  void check( bool condition, const char* what ) {
+    if( !condition ) {
+      printf("FAILED: %s\n", what);
+      gPassed = false;
+    }
+  }
+
+  // Textures, meshes, and materials referring to them, objects using those with some parents, lights, and tracks,
+  // with a few names repeated.
+  std::string makeScene() {
+    std::ostringstream out;
+    out << "[scene]\n[resources]\n";
+    for( unsigned int i = 0; i < 6; ++i ) {
+      out << "[texture]\nfile = texture" << i << ".png\nname = texture" << i << "\n[/texture]\n";
+      out << "[mesh]\nfile = mesh" << i << ".obj\nname = mesh" << (i % 5) << "\n[/mesh]\n";
+      out << "[material]\nname = material" << i << "\ndiffuseTex = texture" << i << "\nnormalTex = texture" << ((i * 7) % 6) << "\n[/material]\n";
+    }
+    out << "[/resources]\n[objects]\n";
+    for( unsigned int i = 0; i < 30; ++i ) {
+      out << "[obj]\nname = object" << (i % 25) << "\nposition = " << i << ",0,0\nmesh = mesh" << (i % 5) << "\nmaterial = material" << (i % 6) << "\n";
+      if( i % 3 == 2 ) {
+        out << "parent = object" << (i / 2) << "\n";
+      }
+      out << "[/obj]\n";
+    }
+    out << "[/objects]\n[lights]\n";
+    for( unsigned int i = 0; i < 4; ++i ) {
+      out << "[light]\ntype = point\nposition = " << i << ",1,0\n[/light]\n";
+    }
+    out << "[/lights]\n[animations]\n";
+    out << "[track]\nobject = object3\nchannel = position\nkey = 0, 0,0,0\nkey = 1, 1,0,0\n[/track]\n";
+    out << "[track]\nlight = 1\nchannel = diffuseIntensity\nkey = 0, 1\nkey = 1, 0\n[/track]\n";
+    out << "[/animations]\n[/scene]\n";
+    return out.str();
+  }
+
+  // The scene as saveBinary() writes it, which refers to records by index, so unlike save() it takes any scene.
+  std::string saved( const Scene& scene ) {
+    std::string bytes;
+    if( !scene.saveBinary(kSnapshotFile) ) {
+      check(false, "couldn't save a snapshot");
+      return bytes;
+    }
+    FILE* const f = fopen(kSnapshotFile, "rb");
+    char        chunk[4096];
+    size_t      read = 0;
+    while( f != nullptr && (read = fread(chunk, 1, sizeof(chunk), f)) > 0 ) {
+      bytes.append(chunk, read);
+    }
+    if( f != nullptr ) {
+      fclose(f);
+    }
+    remove(kSnapshotFile);
+    return bytes;
+  }
+
+  bool sameList( Scene::IndexList list, std::vector<unsigned int> expected ) {
+    std::vector<unsigned int> actual(list.data, list.data + list.count);
+    std::sort(actual.begin(), actual.end());
+    std::sort(expected.begin(), expected.end());
+    return actual == expected;
+  }
+
+  // Compares the name lookup and the user lists with a search of the records.
+  bool indexesMatch( const Scene& scene ) {
+    const std::vector<Scene::Object>& objects = scene.objects();
+    for( unsigned int i = 0; i < objects.size(); ++i ) {
+      const int found = scene.findObject(objects[i].name);
+      if( found < 0 || found >= static_cast<int>(objects.size()) || objects[found].name != objects[i].name ) {
+        return false;
+      }
+    }
+    // Names no object has any more (or ever had) find nothing.
+    for( unsigned int i = 0; i < 40; ++i ) {
+      std::ostringstream name;
+      name << "object" << i;
+      bool present = false;
+      for( unsigned int j = 0; j < objects.size(); ++j ) {
+        present = present || objects[j].name == name.str();
+      }
+      if( !present && scene.findObject(name.str()) != -1 ) {
+        return false;
+      }
+    }
+
+    for( unsigned int mesh = 0; mesh < scene.meshCount(); ++mesh ) {
+      std::vector<unsigned int> users;
+      for( unsigned int i = 0; i < objects.size(); ++i ) {
+        if( objects[i].mesh == static_cast<int>(mesh) ) {
+          users.push_back(i);
+        }
+      }
+      if( !sameList(scene.meshUsers(mesh), users) ) {
+        return false;
+      }
+    }
+    for( unsigned int material = 0; material < scene.materialCount(); ++material ) {
+      std::vector<unsigned int> users;
+      for( unsigned int i = 0; i < objects.size(); ++i ) {
+        if( objects[i].material == static_cast<int>(material) ) {
+          users.push_back(i);
+        }
+      }
+      if( !sameList(scene.materialUsers(material), users) ) {
+        return false;
+      }
+    }
+    for( unsigned int texture = 0; texture < scene.textureCount(); ++texture ) {
+      std::vector<unsigned int> users;
+      for( unsigned int i = 0; i < scene.materialCount(); ++i ) {
+        const Scene::Material& material = scene.materials()[i];
+        if( material.diffuseTex == static_cast<int>(texture) || material.normalTex == static_cast<int>(texture) ) {
+          users.push_back(i);
+        }
+      }
+      if( !sameList(scene.textureUsers(texture), users) ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  unsigned int countOf( const Scene& scene, Scene::RecordType type ) {
+    switch( type ) {
+      case Scene::kRecordTypeTexture: {
+        return scene.textureCount();
+      }
+      case Scene::kRecordTypeMesh: {
+        return scene.meshCount();
+      }
+      case Scene::kRecordTypeMaterial: {
+        return scene.materialCount();
+      }
+      case Scene::kRecordTypeObject: {
+        return scene.objectCount();
+      }
+      default: {
+        return scene.lightCount();
+      }
+    }
+  }
+
+  int randomReference( unsigned int count ) {
+    return static_cast<int>(rand() % (count + 1)) - 1;
+  }
+
+  // One random add, modify, or remove of a random kind of record.  Some fail, such as removing an animated object
+  // or referring to a record that isn't there, and that's part of the test.
+  void randomEdit( Scene* scene ) {
+    const Scene::RecordType type  = static_cast<Scene::RecordType>(rand() % 5);
+    const unsigned int      count = countOf(*scene, type);
+    const unsigned int      what  = rand() % 3;
+    if( what == 2 && count > 0 ) {
+      scene->remove(type, scene->handle(type, rand() % count));
+      return;
+    }
+
+    const bool          adding = what == 0 || count == 0;
+    const unsigned int  index  = adding ? 0 : rand() % count;
+    const Scene::Handle handle = adding ? Scene::Handle() : scene->handle(type, index);
+    std::ostringstream  name;
+    name << ((type == Scene::kRecordTypeObject) ? "object" : "record") << rand() % 40;
+    switch( type ) {
+      case Scene::kRecordTypeTexture: {
+        Scene::Texture texture = adding ? Scene::Texture() : scene->textures()[index];
+        texture.name = name.str();
+        adding ? static_cast<void>(scene->add(texture)) : static_cast<void>(scene->modify(handle, texture));
+        break;
+      }
+      case Scene::kRecordTypeMesh: {
+        Scene::Mesh mesh = adding ? Scene::Mesh() : scene->meshes()[index];
+        mesh.name = name.str();
+        adding ? static_cast<void>(scene->add(mesh)) : static_cast<void>(scene->modify(handle, mesh));
+        break;
+      }
+      case Scene::kRecordTypeMaterial: {
+        Scene::Material material = adding ? Scene::Material() : scene->materials()[index];
+        material.diffuseTex = randomReference(scene->textureCount());
+        material.normalTex  = randomReference(scene->textureCount());
+        adding ? static_cast<void>(scene->add(material)) : static_cast<void>(scene->modify(handle, material));
+        break;
+      }
+      case Scene::kRecordTypeObject: {
+        Scene::Object object = adding ? Scene::Object() : scene->objects()[index];
+        object.name     = name.str();
+        object.mesh     = randomReference(scene->meshCount());
+        object.material = randomReference(scene->materialCount());
+        object.parent   = randomReference(scene->objectCount());
+        object.position.x = static_cast<float>(rand() % 100);
+        adding ? static_cast<void>(scene->add(object)) : static_cast<void>(scene->modify(handle, object));
+        break;
+      }
+      default: {
+        Scene::Light light = adding ? Scene::Light() : scene->lights()[index];
+        light.range = static_cast<float>(1 + rand() % 10);
+        adding ? static_cast<void>(scene->add(light)) : static_cast<void>(scene->modify(handle, light));
+        break;
+      }
+    }
+  }
+
+  // Every record's handle finds it again.
+  bool handlesMatch( const Scene& scene ) {
+    for( unsigned int type = Scene::kRecordTypeTexture; type <= Scene::kRecordTypeLight; ++type ) {
+      const Scene::RecordType recordType = static_cast<Scene::RecordType>(type);
+      for( unsigned int i = 0; i < countOf(scene, recordType); ++i ) {
+        if( scene.indexOf(recordType, scene.handle(recordType, i)) != static_cast<int>(i) ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void testRollback( const std::string& text ) {
+    Scene scene;
+    check(scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())), "rollback: the scene didn't load");
+    const std::string original = saved(scene);
+    check(indexesMatch(scene), "rollback: the indexes don't match after loading");
+
+    // Objects that are never removed keep their handles through the rollback.
+    std::vector<Scene::Handle> handles;
+    for( unsigned int i = 0; i < scene.objectCount(); ++i ) {
+      handles.push_back(scene.handle(Scene::kRecordTypeObject, i));
+    }
+
+    bool indexesHeld = true;
+    for( unsigned int round = 0; round < 50; ++round ) {
+      check(scene.beginEdit(), "rollback: couldn't begin an edit");
+      for( unsigned int i = 0; i < 40; ++i ) {
+        randomEdit(&scene);
+        indexesHeld = indexesHeld && indexesMatch(scene) && handlesMatch(scene);
+      }
+      check(scene.rollbackEdit(), "rollback: couldn't roll back");
+      check(saved(scene) == original, "rollback: the scene isn't as it was after rolling back");
+      indexesHeld = indexesHeld && indexesMatch(scene) && handlesMatch(scene);
+    }
+    check(indexesHeld, "rollback: the indexes or handles didn't match the records");
+
+    // Only objects that were removed at some point have stale handles.
+    bool kept = true;
+    for( unsigned int i = 0; i < handles.size(); ++i ) {
+      const int index = scene.indexOf(Scene::kRecordTypeObject, handles[i]);
+      kept = kept && (index == -1 || index == static_cast<int>(i));
+    }
+    check(kept, "rollback: a handle found a different object after rolling back");
+  }
+
+  void testJournal( const std::string& text ) {
+    for( unsigned int round = 0; round < 30; ++round ) {
+      Scene scene;
+      check(scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())), "journal: the scene didn't load");
+      const std::string before = saved(scene);
+
+      Scene::Journal journal;
+      check(scene.beginEdit(), "journal: couldn't begin an edit");
+      for( unsigned int i = 0; i < 60; ++i ) {
+        randomEdit(&scene);
+      }
+      check(scene.commitEdit(&journal), "journal: couldn't commit");
+      const std::string after = saved(scene);
+
+      for( unsigned int repeat = 0; repeat < 3; ++repeat ) {
+        check(scene.revert(journal), "journal: couldn't revert");
+        check(saved(scene) == before && indexesMatch(scene) && handlesMatch(scene), "journal: reverting didn't restore the scene");
+        check(scene.apply(journal), "journal: couldn't apply");
+        check(saved(scene) == after && indexesMatch(scene) && handlesMatch(scene), "journal: applying didn't redo the edits");
+      }
+
+      // A Journal read back from a file replays onto a fresh copy of the scene.  Applying it again doesn't fit the
+      // scene any more, and a Journal that doesn't fit changes nothing.
+      check(Scene::saveJournal(kJournalFile, journal), "journal: couldn't save the journal");
+      Scene::Journal loaded;
+      check(Scene::loadJournal(kJournalFile, &loaded), "journal: couldn't load the journal");
+      Scene copy;
+      check(copy.loadFromMemory(text.c_str(), static_cast<long>(text.size())), "journal: the copy didn't load");
+      check(copy.apply(loaded) && saved(copy) == after && indexesMatch(copy), "journal: the loaded journal didn't replay");
+      check(copy.apply(loaded) || saved(copy) == after, "journal: a journal that failed to apply changed the scene");
+    }
+    remove(kJournalFile);
+  }
+
+  void testStaleHandles( const std::string& text ) {
+    Scene scene;
+    check(scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())), "handles: the scene didn't load");
+    Scene::Object object;
+    object.name = "temporary";
+
+    check(scene.beginEdit(), "handles: couldn't begin an edit");
+    const Scene::Handle first = scene.add(object);
+    check(scene.indexOf(Scene::kRecordTypeObject, first) != -1, "handles: an added object's handle didn't find it");
+    check(scene.remove(Scene::kRecordTypeObject, first), "handles: couldn't remove the object");
+    check(scene.indexOf(Scene::kRecordTypeObject, first) == -1, "handles: a removed object's handle still found something");
+
+    // The next object takes the freed slot, but the old handle mustn't find it.
+    const Scene::Handle second = scene.add(object);
+    check(second.slot == first.slot && second.generation > first.generation, "handles: the freed slot wasn't reused with a newer generation");
+    check(scene.indexOf(Scene::kRecordTypeObject, first) == -1, "handles: a stale handle found the object that took its slot");
+    check(!scene.modify(first, object) && !scene.remove(Scene::kRecordTypeObject, first), "handles: a stale handle could still edit");
+    check(scene.remove(Scene::kRecordTypeObject, second), "handles: couldn't remove the second object");
+
+    Scene::Journal journal;
+    check(scene.commitEdit(&journal), "handles: couldn't commit");
+
+    // Reverting puts the objects back with newer generations still, so neither handle comes back to life.
+    check(scene.revert(journal), "handles: couldn't revert");
+    check(scene.indexOf(Scene::kRecordTypeObject, first) == -1 && scene.indexOf(Scene::kRecordTypeObject, second) == -1, "handles: a handle from before a remove found a record put back by revert()");
+    check(scene.apply(journal), "handles: couldn't apply");
+    check(scene.beginEdit(), "handles: couldn't begin another edit");
+    const Scene::Handle third = scene.add(object);
+    check(third.generation > second.generation, "handles: a slot's generation went backwards");
+    check(scene.rollbackEdit(), "handles: couldn't roll back");
+    check(scene.indexOf(Scene::kRecordTypeObject, third) == -1, "handles: a rolled back add's handle still found something");
+  }
+
+  // A transaction's Journal can't record a reordering, so sortSpatially() must refuse to run inside one, and must
+  // not leave remaps from an earlier sort behind for the caller to apply.
+  void testSortDuringEdit( const std::string& text ) {
+    Scene scene;
+    check(scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())), "sort: the scene didn't load");
+    std::vector<unsigned int> objectRemap;
+    std::vector<unsigned int> lightRemap;
+    check(scene.sortSpatially(&objectRemap, &lightRemap), "sort: couldn't sort outside a transaction");
+    check(objectRemap.size() == scene.objectCount() && lightRemap.size() == scene.lightCount(), "sort: the remaps don't cover every record");
+
+    const std::string before = saved(scene);
+    check(scene.beginEdit(), "sort: couldn't begin an edit");
+    check(!scene.sortSpatially(&objectRemap, &lightRemap), "sort: sorted during a transaction");
+    check(objectRemap.empty() && lightRemap.empty(), "sort: a failed sort left remaps behind");
+    check(scene.rollbackEdit() && saved(scene) == before, "sort: a failed sort changed the scene");
+  }
+}
+
+int main() {
+  srand(1);
+  const std::string text = makeScene();
+  testRollback(text);
+  testJournal(text);
+  testStaleHandles(text);
+  testSortDuringEdit(text);
+  printf("%s\n", gPassed ? "PASSED" : "FAILED");
+  return gPassed ? 0 : 1;
+}
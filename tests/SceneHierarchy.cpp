@@ -0,0 +1,221 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Checks object parents from loading through to world transforms.  Parents in a file resolve whether they come
+// before or after their children, in LazyScene as in Scene, and ones that would close a cycle are dropped.  Edits
+// that would make a cycle fail.  SceneHierarchy's world transforms match walking up each object's parents, both
+// after build() and after update() of a few changed locals.  Build and run with:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. SceneHierarchy.cpp ../SceneHierarchy.cpp ../LazyScene.cpp ../Scene.cpp -o SceneHierarchy && ./SceneHierarchy
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "LazyScene.hpp"
+#include "Scene.hpp"
+#include "SceneHierarchy.hpp"
+
+namespace {
+  const char* const kSceneFile = "SceneHierarchy.scn";
+
+  bool gPassed = true;
+
+  void check( bool condition, const char* what ) {
+    if( !condition ) {
+      printf("FAILED: %s\n", what);
+      gPassed = false;
+    }
+  }
+
+  bool hasCycle( const std::vector<Scene::Object>& objects ) {
+    for( unsigned int i = 0; i < objects.size(); ++i ) {
+      int parent = objects[i].parent;
+      for( unsigned int steps = 0; parent != -1 && steps <= objects.size(); ++steps ) {
+        if( parent == static_cast<int>(i) ) {
+          return true;
+        }
+        parent = objects[parent].parent;
+      }
+    }
+    return false;
+  }
+
+  // a is the parent of b, which is the parent of c, with c written first.  d and e name each other, as do f, g, and
+  // h in a ring, and i names itself.  The parent written later in each cycle is the one dropped.
+  void testLoad() {
+    {
+      std::ofstream out(kSceneFile);
+      out << "[scene]\n[objects]\n";
+      out << "[obj]\nname = c\nparent = b\n[/obj]\n";
+      out << "[obj]\nname = a\n[/obj]\n";
+      out << "[obj]\nname = b\nparent = a\n[/obj]\n";
+      out << "[obj]\nname = d\nparent = e\n[/obj]\n";
+      out << "[obj]\nname = e\nparent = d\n[/obj]\n";
+      out << "[obj]\nname = f\nparent = h\n[/obj]\n";
+      out << "[obj]\nname = g\nparent = f\n[/obj]\n";
+      out << "[obj]\nname = h\nparent = g\n[/obj]\n";
+      out << "[obj]\nname = i\nparent = i\n[/obj]\n";
+      out << "[/objects]\n[/scene]\n";
+    }
+    const int expected[] = { 2, -1, 1, -1, 3, -1, 5, 6, -1 };
+
+    Scene scene;
+    check(scene.load(kSceneFile) && scene.objectCount() == 9, "load: the scene didn't load");
+    LazyScene lazy;
+    check(lazy.open(kSceneFile) && lazy.objectCount() == 9, "load: the lazy scene didn't open");
+    for( unsigned int i = 0; i < scene.objectCount() && i < lazy.objectCount(); ++i ) {
+      check(scene.objects()[i].parent == expected[i], "load: a parent didn't resolve as expected");
+      check(lazy.object(i).parent == expected[i], "load: a lazy parent didn't resolve as expected");
+    }
+    remove(kSceneFile);
+  }
+
+  void testEdits() {
+    const char* const text = "[scene]\n[objects]\n[obj]\nname = a\n[/obj]\n[obj]\nname = b\nparent = a\n[/obj]\n[obj]\nname = c\nparent = b\n[/obj]\n[/objects]\n[/scene]\n";
+    Scene scene;
+    check(scene.loadFromMemory(text, static_cast<long>(strlen(text))), "edits: the scene didn't load");
+    check(scene.beginEdit(), "edits: couldn't begin an edit");
+
+    Scene::Object object = scene.objects()[0];
+    object.parent = 2;
+    check(!scene.modify(scene.handle(Scene::kRecordTypeObject, 0), object), "edits: a modify made a cycle of three");
+    object.parent = 0;
+    check(!scene.modify(scene.handle(Scene::kRecordTypeObject, 0), object), "edits: a modify made an object its own parent");
+    object = scene.objects()[1];
+    object.parent = 2;
+    check(!scene.modify(scene.handle(Scene::kRecordTypeObject, 1), object), "edits: a modify made a cycle of two");
+    object = scene.objects()[2];
+    object.parent = 0;
+    check(scene.modify(scene.handle(Scene::kRecordTypeObject, 2), object), "edits: a modify that made no cycle failed");
+
+    Scene::Object added;
+    added.parent = 3;
+    scene.add(added);
+    check(scene.objectCount() == 3, "edits: an add made an object its own parent");
+    added.parent = 2;
+    scene.add(added);
+    check(scene.objectCount() == 4, "edits: an add that made no cycle failed");
+
+    // Random reparenting and adding never leaves a cycle behind.
+    srand(1);
+    for( unsigned int i = 0; i < 2000; ++i ) {
+      const unsigned int index = rand() % scene.objectCount();
+      object        = scene.objects()[index];
+      object.parent = rand() % (scene.objectCount() + 1) - 1;
+      scene.modify(scene.handle(Scene::kRecordTypeObject, index), object);
+      if( i % 10 == 0 ) {
+        added.parent = rand() % (scene.objectCount() + 2) - 1;
+        scene.add(added);
+      }
+    }
+    check(!hasCycle(scene.objects()), "edits: random edits left a cycle");
+    check(scene.commitEdit(), "edits: couldn't commit the edit");
+  }
+
+  // Each object's world transform, found by walking up its parents.
+  SceneHierarchy::Transform walkUp( const std::vector<Scene::Object>& objects, const std::vector<SceneHierarchy::Transform>& locals, unsigned int object ) {
+    SceneHierarchy::Transform world = locals[object];
+    for( int parent = objects[object].parent; parent != -1; parent = objects[parent].parent ) {
+      world = SceneHierarchy::multiply(locals[parent], world);
+    }
+    return world;
+  }
+
+  bool worldsMatch( const SceneHierarchy& hierarchy, const std::vector<Scene::Object>& objects, const std::vector<SceneHierarchy::Transform>& locals ) {
+    for( unsigned int i = 0; i < objects.size(); ++i ) {
+      const SceneHierarchy::Transform expected = walkUp(objects, locals, i);
+      for( unsigned int j = 0; j < 12; ++j ) {
+        if( !(std::fabs(hierarchy.world(i).m[j] - expected.m[j]) <= 1e-3f * (1.0f + std::fabs(expected.m[j]))) ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // A few thousand objects in random trees, on one thread and on several.
+  void testHierarchy() {
+    std::string text = "[scene]\n[objects]\n";
+    srand(2);
+    const unsigned int count = 5000;
+    for( unsigned int i = 0; i < count; ++i ) {
+      text += "[obj]\nname = object" + std::to_string(i) + "\n";
+      text += "position = " + std::to_string(rand() % 20 - 10) + "," + std::to_string(rand() % 20 - 10) + "," + std::to_string(rand() % 20 - 10) + "\n";
+      text += "orientation = " + std::to_string(rand() % 360) + "," + std::to_string(rand() % 360) + "," + std::to_string(rand() % 360) + "\n";
+      text += "scale = 1,1,1\n";
+      if( i > 0 && rand() % 8 != 0 ) {
+        text += "parent = object" + std::to_string(rand() % count) + "\n";
+      }
+      text += "[/obj]\n";
+    }
+    text += "[/objects]\n[/scene]\n";
+    Scene scene;
+    check(scene.loadFromMemory(text.c_str(), static_cast<long>(text.size())) && scene.objectCount() == count, "hierarchy: the scene didn't load");
+    if( hasCycle(scene.objects()) ) {
+      check(false, "hierarchy: loading left a cycle");
+      return;
+    }
+
+    const std::vector<Scene::Object>& objects = scene.objects();
+    for( unsigned int threads = 1; threads <= 4; threads += 3 ) {
+      std::vector<SceneHierarchy::Transform> locals;
+      for( unsigned int i = 0; i < objects.size(); ++i ) {
+        locals.push_back(SceneHierarchy::fromObject(objects[i]));
+      }
+      SceneHierarchy hierarchy(threads);
+      hierarchy.build(objects);
+      check(hierarchy.objectCount() == count, "hierarchy: not every object is in the hierarchy");
+      check(worldsMatch(hierarchy, objects, locals), "hierarchy: a world transform after build() didn't match its parents");
+
+      // Every parent is in an earlier level than its children.
+      std::vector<unsigned int> levelOf(count, 0);
+      for( unsigned int level = 0; level < hierarchy.levelCount(); ++level ) {
+        for( unsigned int order = hierarchy.levelStart(level); order < hierarchy.levelStart(level + 1); ++order ) {
+          levelOf[hierarchy.objectAt(order)] = level;
+        }
+      }
+      bool ordered = true;
+      for( unsigned int i = 0; i < count; ++i ) {
+        ordered = ordered && (objects[i].parent == -1 || levelOf[objects[i].parent] < levelOf[i]);
+      }
+      check(ordered, "hierarchy: a parent isn't in an earlier level than its child");
+
+      for( unsigned int i = 0; i < 50; ++i ) {
+        Scene::Object moved = objects[rand() % count];
+        moved.position.x += 1.0f;
+        const unsigned int index = rand() % count;
+        locals[index] = SceneHierarchy::fromObject(moved);
+        hierarchy.setLocal(index, locals[index]);
+      }
+      hierarchy.update();
+      check(worldsMatch(hierarchy, objects, locals), "hierarchy: a world transform after update() didn't match its parents");
+    }
+  }
+}
+
+int main() {
+  testLoad();
+  testEdits();
+  testHierarchy();
+  printf("%s\n", gPassed ? "PASSED" : "FAILED");
+  return gPassed ? 0 : 1;
+}
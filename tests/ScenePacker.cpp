@@ -0,0 +1,257 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Checks the layout ScenePacker writes.  The std140 and std430 rules are applied to the GLSL structs in
+// ScenePacker.hpp, member by member, and every offset and the array stride must come out as the packer's (a Light
+// stride of 80 and a Material stride of 32 under both).  Packed lights and materials are then read back from those
+// offsets, and the grouping of lights by type, packedLightIndex(), the zeroed padding, and the dirty ranges of
+// repacks are checked.  Build and run with:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. ScenePacker.cpp ../ScenePacker.cpp ../Scene.cpp -o ScenePacker && ./ScenePacker
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "ScenePacker.hpp"
+
+namespace {
+  bool gPassed = true;
+
+  void check( bool condition, const char* what ) {
+    if( !condition ) {
+      printf("FAILED: %s\n", what);
+      gPassed = false;
+    }
+  }
+
+  enum GlslType {
+    kGlslFloat,
+    kGlslInt,
+    kGlslUint,
+    kGlslVec3
+  };
+
+  // Base alignment and size in bytes, which std140 and std430 agree on for scalars and vec3.
+  unsigned int alignmentOf( GlslType type ) {
+    return (type == kGlslVec3) ? 16 : 4;
+  }
+
+  unsigned int sizeOf( GlslType type ) {
+    return (type == kGlslVec3) ? 12 : 4;
+  }
+
+  unsigned int roundUp( unsigned int value, unsigned int multiple ) {
+    return (value + multiple - 1) / multiple * multiple;
+  }
+
+  // Lays out a struct's members one after another at their base alignment, and returns the stride of an array of
+  // the struct.  A struct is aligned to its largest member, and under std140 that is then rounded up to a vec4.
+  unsigned int layOut( const GlslType* types, unsigned int count, bool std140, std::vector<unsigned int>* offsets ) {
+    unsigned int offset    = 0;
+    unsigned int alignment = 0;
+    offsets->clear();
+    for( unsigned int i = 0; i < count; ++i ) {
+      offset = roundUp(offset, alignmentOf(types[i]));
+      offsets->push_back(offset);
+      offset += sizeOf(types[i]);
+      alignment = std::max(alignment, alignmentOf(types[i]));
+    }
+    if( std140 ) {
+      alignment = roundUp(alignment, 16);
+    }
+    return roundUp(offset, alignment);
+  }
+
+  void testLayout() {
+    const GlslType lightTypes[] = {
+      kGlslVec3, kGlslFloat, kGlslVec3, kGlslFloat, kGlslVec3, kGlslFloat,
+      kGlslVec3, kGlslFloat, kGlslFloat, kGlslFloat, kGlslUint, kGlslUint
+    };
+    const unsigned int lightOffsets[] = {
+      ScenePacker::kLightOffsetPosition,     ScenePacker::kLightOffsetRange,
+      ScenePacker::kLightOffsetDirection,    ScenePacker::kLightOffsetShadowBias,
+      ScenePacker::kLightOffsetDiffuseColor, ScenePacker::kLightOffsetDiffuseIntensity,
+      ScenePacker::kLightOffsetSpecularColor, ScenePacker::kLightOffsetSpecularIntensity,
+      ScenePacker::kLightOffsetCosConeInner, ScenePacker::kLightOffsetCosConeOuter,
+      ScenePacker::kLightOffsetType,         ScenePacker::kLightOffsetShadows
+    };
+    const GlslType     materialTypes[]   = { kGlslVec3, kGlslFloat, kGlslInt, kGlslInt };
+    const unsigned int materialOffsets[] = {
+      ScenePacker::kMaterialOffsetColor,      ScenePacker::kMaterialOffsetSpecSize,
+      ScenePacker::kMaterialOffsetDiffuseTex, ScenePacker::kMaterialOffsetNormalTex
+    };
+
+    check(ScenePacker::kLightStride == 80 && ScenePacker::kMaterialStride == 32, "layout: the strides aren't 80 and 32");
+    for( unsigned int rules = 0; rules < 2; ++rules ) {
+      const bool                std140 = rules == 0;
+      std::vector<unsigned int> offsets;
+      const unsigned int        lightStride = layOut(lightTypes, 12, std140, &offsets);
+      check(lightStride == ScenePacker::kLightStride, std140 ? "layout: std140 light stride" : "layout: std430 light stride");
+      for( unsigned int i = 0; i < offsets.size(); ++i ) {
+        check(offsets[i] == lightOffsets[i], std140 ? "layout: std140 light offset" : "layout: std430 light offset");
+      }
+      const unsigned int materialStride = layOut(materialTypes, 4, std140, &offsets);
+      check(materialStride == ScenePacker::kMaterialStride, std140 ? "layout: std140 material stride" : "layout: std430 material stride");
+      for( unsigned int i = 0; i < offsets.size(); ++i ) {
+        check(offsets[i] == materialOffsets[i], std140 ? "layout: std140 material offset" : "layout: std430 material offset");
+      }
+    }
+  }
+
+  float getFloat( const std::vector<unsigned char>& buffer, unsigned int offset ) {
+    float value = 0.0f;
+    memcpy(&value, &buffer[offset], sizeof(value));
+    return value;
+  }
+
+  unsigned int getUint( const std::vector<unsigned char>& buffer, unsigned int offset ) {
+    unsigned int value = 0;
+    memcpy(&value, &buffer[offset], sizeof(value));
+    return value;
+  }
+
+  int getInt( const std::vector<unsigned char>& buffer, unsigned int offset ) {
+    int value = 0;
+    memcpy(&value, &buffer[offset], sizeof(value));
+    return value;
+  }
+
+  bool near( float a, float b ) {
+    return fabsf(a - b) <= 1e-5f;
+  }
+
+  bool vectorAt( const std::vector<unsigned char>& buffer, unsigned int offset, const Scene::Vector& expected ) {
+    return near(getFloat(buffer, offset), expected.x) && near(getFloat(buffer, offset + 4), expected.y) && near(getFloat(buffer, offset + 8), expected.z);
+  }
+
+  // Spots, points, and directionals mixed together.
+  std::vector<Scene::Light> makeLights() {
+    const Scene::LightType    types[] = { Scene::kLightTypeSpot, Scene::kLightTypePoint, Scene::kLightTypeDirectional, Scene::kLightTypePoint, Scene::kLightTypeSpot, Scene::kLightTypePoint };
+    std::vector<Scene::Light> lights(6);
+    for( unsigned int i = 0; i < lights.size(); ++i ) {
+      Scene::Light& light = lights[i];
+      light.type              = types[i];
+      light.position          = Scene::Vector(i * 1.0f, i * 2.0f, i * 3.0f);
+      light.range             = 10.0f + i;
+      light.direction         = Scene::Vector(0.0f, -2.0f * (i + 1), 0.0f);
+      light.shadowBias        = 0.001f * i;
+      light.diffuseColor      = Scene::Vector(0.1f * i, 0.2f, 0.3f);
+      light.diffuseIntensity  = 1.5f + i;
+      light.specularColor     = Scene::Vector(0.4f, 0.5f * i, 0.6f);
+      light.specularIntensity = 0.25f * i;
+      light.coneInnerAngle    = 10.0f + i;
+      light.coneOuterAngle    = 20.0f + i;
+      light.shadows           = (i % 2) == 0;
+    }
+    return lights;
+  }
+
+  void testLights() {
+    const std::vector<Scene::Light> lights = makeLights();
+    ScenePacker                     packer;
+    packer.packLights(lights);
+    check(packer.lightCount() == 6 && packer.lightBuffer().size() == 6 * ScenePacker::kLightStride, "lights: wrong count or size");
+
+    // Points first, then spots, then directionals, each in Scene order.
+    const int expected[] = { 3, 0, 5, 1, 4, 2 };
+    for( unsigned int i = 0; i < lights.size(); ++i ) {
+      check(packer.packedLightIndex(i) == expected[i], "lights: a light isn't in its group's place");
+    }
+    check(packer.packedLightIndex(6) == -1 && packer.packedLightIndex(0xffffffffu) == -1, "lights: an index past the end has a packed index");
+    check(packer.lightRange(Scene::kLightTypePoint).first == 0 && packer.lightRange(Scene::kLightTypePoint).count == 3, "lights: point range");
+    check(packer.lightRange(Scene::kLightTypeSpot).first == 3 && packer.lightRange(Scene::kLightTypeSpot).count == 2, "lights: spot range");
+    check(packer.lightRange(Scene::kLightTypeDirectional).first == 5 && packer.lightRange(Scene::kLightTypeDirectional).count == 1, "lights: directional range");
+
+    const std::vector<unsigned char>& buffer = packer.lightBuffer();
+    for( unsigned int i = 0; i < lights.size(); ++i ) {
+      const Scene::Light& light = lights[i];
+      const unsigned int  base  = packer.packedLightIndex(i) * ScenePacker::kLightStride;
+      check(vectorAt(buffer, base + ScenePacker::kLightOffsetPosition, light.position), "lights: position");
+      check(near(getFloat(buffer, base + ScenePacker::kLightOffsetRange), light.range), "lights: range");
+      check(vectorAt(buffer, base + ScenePacker::kLightOffsetDirection, Scene::Vector(0.0f, -1.0f, 0.0f)), "lights: direction isn't normalized");
+      check(near(getFloat(buffer, base + ScenePacker::kLightOffsetShadowBias), light.shadowBias), "lights: shadow bias");
+      check(vectorAt(buffer, base + ScenePacker::kLightOffsetDiffuseColor, light.diffuseColor), "lights: diffuse color");
+      check(near(getFloat(buffer, base + ScenePacker::kLightOffsetDiffuseIntensity), light.diffuseIntensity), "lights: diffuse intensity");
+      check(vectorAt(buffer, base + ScenePacker::kLightOffsetSpecularColor, light.specularColor), "lights: specular color");
+      check(near(getFloat(buffer, base + ScenePacker::kLightOffsetSpecularIntensity), light.specularIntensity), "lights: specular intensity");
+      check(near(getFloat(buffer, base + ScenePacker::kLightOffsetCosConeInner), cosf(light.coneInnerAngle * 3.14159265358979f / 180.0f)), "lights: inner cone cosine");
+      check(near(getFloat(buffer, base + ScenePacker::kLightOffsetCosConeOuter), cosf(light.coneOuterAngle * 3.14159265358979f / 180.0f)), "lights: outer cone cosine");
+      check(getUint(buffer, base + ScenePacker::kLightOffsetType) == static_cast<unsigned int>(light.type), "lights: type");
+      check(getUint(buffer, base + ScenePacker::kLightOffsetShadows) == (light.shadows ? 1u : 0u), "lights: shadows");
+    }
+
+    // Repacking one light marks only its slot dirty; changing its type regroups everything.
+    std::vector<Scene::Light> changed = lights;
+    packer.clearDirty();
+    changed[4].range = 99.0f;
+    packer.repackLights(changed, 4, 1);
+    check(packer.lightDirty().begin == 4 * ScenePacker::kLightStride && packer.lightDirty().end == 5 * ScenePacker::kLightStride, "lights: repack dirty range");
+    check(near(getFloat(packer.lightBuffer(), 4 * ScenePacker::kLightStride + ScenePacker::kLightOffsetRange), 99.0f), "lights: repack didn't rewrite the light");
+    packer.clearDirty();
+    changed[2].type = Scene::kLightTypePoint;
+    packer.repackLights(changed, 2, 1);
+    check(packer.packedLightIndex(2) == 1 && packer.lightRange(Scene::kLightTypePoint).count == 4, "lights: a type change didn't regroup");
+    check(packer.lightDirty().begin == 0 && packer.lightDirty().end == packer.lightBuffer().size(), "lights: a regroup didn't dirty everything");
+
+    packer.packLights(std::vector<Scene::Light>());
+    check(packer.lightCount() == 0 && packer.packedLightIndex(0) == -1, "lights: an empty pack left lights behind");
+  }
+
+  void testMaterials() {
+    std::vector<Scene::Material> materials(5);
+    for( unsigned int i = 0; i < materials.size(); ++i ) {
+      materials[i].color      = Scene::Vector(0.1f * i, 0.5f, 1.0f - 0.1f * i);
+      materials[i].specSize   = 4.0f * i;
+      materials[i].diffuseTex = static_cast<int>(i) - 1;
+      materials[i].normalTex  = static_cast<int>(i * 2);
+    }
+    ScenePacker packer;
+    packer.packMaterials(materials);
+    check(packer.materialCount() == 5 && packer.materialBuffer().size() == 5 * ScenePacker::kMaterialStride, "materials: wrong count or size");
+
+    const std::vector<unsigned char>& buffer = packer.materialBuffer();
+    for( unsigned int i = 0; i < materials.size(); ++i ) {
+      const unsigned int base = i * ScenePacker::kMaterialStride;
+      check(vectorAt(buffer, base + ScenePacker::kMaterialOffsetColor, materials[i].color), "materials: color");
+      check(near(getFloat(buffer, base + ScenePacker::kMaterialOffsetSpecSize), materials[i].specSize), "materials: spec size");
+      check(getInt(buffer, base + ScenePacker::kMaterialOffsetDiffuseTex) == materials[i].diffuseTex, "materials: diffuse texture");
+      check(getInt(buffer, base + ScenePacker::kMaterialOffsetNormalTex) == materials[i].normalTex, "materials: normal texture");
+      for( unsigned int j = ScenePacker::kMaterialOffsetNormalTex + 4; j < ScenePacker::kMaterialStride; ++j ) {
+        check(buffer[base + j] == 0, "materials: padding isn't zero");
+      }
+    }
+
+    packer.clearDirty();
+    materials[1].specSize = 7.0f;
+    materials[2].specSize = 8.0f;
+    packer.repackMaterials(materials, 1, 2);
+    check(packer.materialDirty().begin == ScenePacker::kMaterialStride && packer.materialDirty().end == 3 * ScenePacker::kMaterialStride, "materials: repack dirty range");
+    check(near(getFloat(packer.materialBuffer(), 2 * ScenePacker::kMaterialStride + ScenePacker::kMaterialOffsetSpecSize), 8.0f), "materials: repack didn't rewrite the material");
+  }
+}
+
+int main() {
+  testLayout();
+  testLights();
+  testMaterials();
+
+  printf(gPassed ? "PASSED\n" : "FAILED\n");
+  return gPassed ? 0 : 1;
+}
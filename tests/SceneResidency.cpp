@@ -0,0 +1,327 @@
+/*
+  Scene is a custom 3d scene parser intended for use with graphical demos.
+  
+  Copyright (C) 2013, Daniel Green
+
+  Scene is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Scene is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Scene.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Checks SceneResidency against a fake loader that only records what it holds.  Loads either wait in a queue until
+// the test runs them, so that they can be caught in flight, or run straight away on their own threads.  Build and
+// run with:
+//
+//   g++ -std=c++11 -O2 -pthread -I.. SceneResidency.cpp ../SceneResidency.cpp ../SceneHierarchy.cpp ../Scene.cpp -o SceneResidency && ./SceneResidency
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Scene.hpp"
+#include "SceneResidency.hpp"
+
+namespace {
+  bool gPassed = true;
+
+  void check( bool condition, const char* what ) {
+    if( !condition ) {
+      printf("FAILED: %s\n", what);
+      gPassed = false;
+    }
+  }
+
+  // Every object has the mesh of the same index, at the given distance along an axis and the given scale.  With the
+  // view at the origin and a projection scale of 1, each object's screen size is its scale over its distance.
+  bool makeScene( const std::vector<float>& distances, const std::vector<float>& scales, Scene* outScene ) {
+    std::string text = "[scene]\n[resources]\n";
+    for( unsigned int i = 0; i < distances.size(); ++i ) {
+      text += "[mesh]\nfile = mesh" + std::to_string(i) + ".obj\nname = mesh" + std::to_string(i) + "\n[/mesh]\n";
+    }
+    text += "[/resources]\n[objects]\n";
+    for( unsigned int i = 0; i < distances.size(); ++i ) {
+      text += "[obj]\nname = object" + std::to_string(i) + "\nposition = " + std::to_string(distances[i]) + ",0,0\n";
+      text += "scale = " + std::to_string(scales[i]) + "," + std::to_string(scales[i]) + "," + std::to_string(scales[i]) + "\n";
+      text += "mesh = mesh" + std::to_string(i) + "\n[/obj]\n";
+    }
+    text += "[/objects]\n[/scene]\n";
+    return outScene->loadFromMemory(text.c_str(), static_cast<long>(text.size())) && outScene->meshCount() == distances.size();
+  }
+
+  // What the fake loader holds.  Loading something already held, or evicting something not held, is an error.
+  struct Store {
+    std::mutex                      mutex;
+    std::vector<unsigned long long> sizes;
+    std::vector<bool>               held;
+    unsigned int                    loads;
+    unsigned int                    evictions;
+    unsigned int                    errors;
+
+    explicit Store( const std::vector<unsigned long long>& meshSizes )
+      : sizes(meshSizes), held(meshSizes.size(), false), loads(0), evictions(0), errors(0) {
+    }
+
+    unsigned int heldCount() {
+      std::lock_guard<std::mutex> lock(mutex);
+      unsigned int count = 0;
+      for( unsigned int i = 0; i < held.size(); ++i ) {
+        count += held[i] ? 1 : 0;
+      }
+      return count;
+    }
+  };
+
+  struct SizeMesh {
+    Store* store;
+
+    unsigned long long operator()( SceneResidency::ResourceType type, unsigned int index, const std::string& ) const {
+      return (type == SceneResidency::kResourceTypeMesh) ? store->sizes[index] : 0;
+    }
+  };
+
+  struct LoadMesh {
+    Store* store;
+
+    bool operator()( SceneResidency::ResourceType, unsigned int index, const std::string& ) const {
+      std::lock_guard<std::mutex> lock(store->mutex);
+      store->errors    += store->held[index] ? 1 : 0;
+      store->held[index] = true;
+      store->loads     += 1;
+      return true;
+    }
+  };
+
+  struct EvictMesh {
+    Store* store;
+
+    void operator()( SceneResidency::ResourceType, unsigned int index ) const {
+      std::lock_guard<std::mutex> lock(store->mutex);
+      store->errors     += store->held[index] ? 0 : 1;
+      store->held[index] = false;
+      store->evictions  += 1;
+    }
+  };
+
+  SceneResidency::Loader makeLoader( Store* store ) {
+    SceneResidency::Loader loader;
+    SizeMesh  size;
+    LoadMesh  load;
+    EvictMesh evict;
+    size.store   = store;
+    load.store   = store;
+    evict.store  = store;
+    loader.size  = size;
+    loader.load  = load;
+    loader.evict = evict;
+    return loader;
+  }
+
+  // Holds loads until run() is called.
+  struct JobQueue {
+    std::vector<std::function<void()>> jobs;
+
+    void run() {
+      for( unsigned int i = 0; i < jobs.size(); ++i ) {
+        jobs[i]();
+      }
+      jobs.clear();
+    }
+  };
+
+  struct QueueJob {
+    JobQueue* queue;
+
+    void operator()( std::function<void()> job ) const {
+      queue->jobs.push_back(job);
+    }
+  };
+
+  SceneExecutor makeExecutor( JobQueue* queue ) {
+    QueueJob executor;
+    executor.queue = queue;
+    return executor;
+  }
+
+  std::vector<unsigned int> visible( int first, int second=-1 ) {
+    std::vector<unsigned int> objects(1, first);
+    if( second != -1 ) {
+      objects.push_back(second);
+    }
+    return objects;
+  }
+
+  // Two 100-byte meshes and room for one.  A load that stops being wanted keeps its bytes until poll() sees it
+  // finish, and the other mesh mustn't start loading on top of it.
+  void testBudgetInFlight() {
+    Scene scene;
+    check(makeScene(std::vector<float>(2, 10.0f), std::vector<float>(2, 1.0f), &scene), "budget: the scene didn't load");
+    Store    store(std::vector<unsigned long long>(2, 100));
+    JobQueue queue;
+    {
+      SceneResidency residency(makeLoader(&store), SceneResidency::Options(), makeExecutor(&queue));
+      residency.bind(scene);
+      const SceneResidency::View view;
+
+      residency.update(scene, visible(0), view, 100);
+      check(residency.pendingBytes() == 100 && residency.isPending(SceneResidency::kResourceTypeMesh, 0), "budget: the first mesh didn't start loading");
+      residency.update(scene, visible(1), view, 100);
+      check(residency.pendingBytes() == 100, "budget: a load started on top of one in flight");
+      check(!residency.isPending(SceneResidency::kResourceTypeMesh, 1), "budget: the second mesh started loading too early");
+
+      queue.run();
+      residency.poll();
+      check(residency.residentBytes() == 0 && residency.pendingBytes() == 0, "budget: the unwanted load wasn't evicted");
+      residency.update(scene, visible(1), view, 100);
+      check(residency.isPending(SceneResidency::kResourceTypeMesh, 1), "budget: the second mesh didn't start loading once there was room");
+      queue.run();
+      residency.poll();
+      check(residency.isResident(SceneResidency::kResourceTypeMesh, 1) && residency.residentBytes() == 100, "budget: the second mesh didn't become resident");
+    }
+    check(store.errors == 0, "budget: the loader was asked to load something it held or evict something it didn't");
+  }
+
+  // Random visibility, sizes, and budgets, with loads finishing at random.  Loads can't be called back, so a budget
+  // that shrinks under loads in flight is only checked once an update() has run with nothing in flight.
+  void testBudgetRandom() {
+    const unsigned int meshCount = 16;
+    Scene              scene;
+    std::vector<float> distances;
+    std::vector<float> scales;
+    std::vector<unsigned long long> sizes;
+    srand(1);
+    for( unsigned int i = 0; i < meshCount; ++i ) {
+      distances.push_back(static_cast<float>(1 + rand() % 100));
+      scales.push_back(static_cast<float>(1 + rand() % 4));
+      sizes.push_back(10 + rand() % 90);
+    }
+    check(makeScene(distances, scales, &scene), "random: the scene didn't load");
+    Store    store(sizes);
+    JobQueue queue;
+    {
+      SceneResidency residency(makeLoader(&store), SceneResidency::Options(), makeExecutor(&queue));
+      residency.bind(scene);
+      const SceneResidency::View view;
+      bool               withinBudget = true;
+      bool               settled      = false;
+      unsigned long long lastBudget   = 0;
+      for( unsigned int frame = 0; frame < 2000; ++frame ) {
+        std::vector<unsigned int> objects;
+        for( unsigned int i = 0; i < meshCount; ++i ) {
+          if( rand() % 3 == 0 ) {
+            objects.push_back(i);
+          }
+        }
+        const unsigned long long budget = 100 + (frame / 100) % 4 * 100;
+        settled    = (budget == lastBudget) ? settled || residency.pendingCount() == 0 : budget > lastBudget && settled;
+        lastBudget = budget;
+        residency.update(scene, objects, view, budget);
+        withinBudget = withinBudget && (!settled || residency.residentBytes() + residency.pendingBytes() <= budget);
+        if( rand() % 2 == 0 ) {
+          queue.run();
+        }
+        residency.poll();
+        withinBudget = withinBudget && (!settled || residency.residentBytes() + residency.pendingBytes() <= budget);
+        withinBudget = withinBudget && residency.residentCount() + residency.pendingCount() == store.heldCount() + queue.jobs.size();
+      }
+      check(withinBudget, "random: resident and pending bytes went over the budget");
+      queue.run();
+    }
+    check(store.errors == 0, "random: the loader was asked to load something it held or evict something it didn't");
+    check(store.loads == store.evictions && store.heldCount() == 0, "random: a load wasn't paired with an eviction");
+  }
+
+  // Object 0 (mesh 0) has a screen size of 0.1, object 1 (mesh 1) of 0.12, and object 2 (mesh 2) of 0.2, and only
+  // one mesh fits.  With the default keep ratio of 1.5, a resident mesh 0 holds off mesh 1 but not mesh 2.
+  void testKeepRatio() {
+    Scene scene;
+    std::vector<float> scales;
+    scales.push_back(1.0f);
+    scales.push_back(1.2f);
+    scales.push_back(2.0f);
+    check(makeScene(std::vector<float>(3, 10.0f), scales, &scene), "keep ratio: the scene didn't load");
+    Store    store(std::vector<unsigned long long>(3, 100));
+    JobQueue queue;
+    {
+      SceneResidency residency(makeLoader(&store), SceneResidency::Options(), makeExecutor(&queue));
+      residency.bind(scene);
+      const SceneResidency::View view;
+      residency.update(scene, visible(0), view, 100);
+      queue.run();
+      residency.poll();
+      check(residency.isResident(SceneResidency::kResourceTypeMesh, 0), "keep ratio: the first mesh didn't become resident");
+
+      for( unsigned int frame = 0; frame < 3; ++frame ) {
+        residency.update(scene, visible(0, 1), view, 100);
+        queue.run();
+        residency.poll();
+      }
+      check(residency.isResident(SceneResidency::kResourceTypeMesh, 0) && !residency.isResident(SceneResidency::kResourceTypeMesh, 1), "keep ratio: a slightly higher rank displaced a resident mesh");
+
+      residency.update(scene, visible(0, 2), view, 100);
+      check(!residency.isResident(SceneResidency::kResourceTypeMesh, 0) && residency.isPending(SceneResidency::kResourceTypeMesh, 2), "keep ratio: a much higher rank didn't displace a resident mesh");
+      queue.run();
+      residency.poll();
+    }
+    {
+      // Without hysteresis the slightly higher rank wins straight away.
+      SceneResidency::Options options;
+      options.keepRatio = 1.0f;
+      SceneResidency residency(makeLoader(&store), options, makeExecutor(&queue));
+      residency.bind(scene);
+      const SceneResidency::View view;
+      residency.update(scene, visible(0), view, 100);
+      queue.run();
+      residency.poll();
+      residency.update(scene, visible(0, 1), view, 100);
+      check(!residency.isResident(SceneResidency::kResourceTypeMesh, 0) && residency.isPending(SceneResidency::kResourceTypeMesh, 1), "keep ratio: a keep ratio of 1 still held off a higher rank");
+      queue.run();
+      residency.poll();
+    }
+    check(store.errors == 0 && store.loads == store.evictions, "keep ratio: a load wasn't paired with an eviction");
+  }
+
+  // Loads run on their own threads here, so that bind() and destruction have real loads in flight to wait for.
+  void testClean() {
+    const unsigned int meshCount = 8;
+    Scene              scene;
+    check(makeScene(std::vector<float>(meshCount, 10.0f), std::vector<float>(meshCount, 1.0f), &scene), "clean: the scene didn't load");
+    Store store(std::vector<unsigned long long>(meshCount, 10));
+    std::vector<unsigned int> all;
+    for( unsigned int i = 0; i < meshCount; ++i ) {
+      all.push_back(i);
+    }
+    {
+      SceneResidency residency(makeLoader(&store));
+      const SceneResidency::View view;
+      residency.bind(scene);
+      residency.update(scene, all, view, 1000);
+      residency.bind(scene);
+      check(store.heldCount() == 0 && residency.residentCount() == 0 && residency.pendingCount() == 0, "clean: bind() left something resident");
+
+      residency.update(scene, all, view, 1000);
+      residency.poll();
+      residency.update(scene, all, view, 1000);
+    }
+    check(store.heldCount() == 0, "clean: destruction left something resident");
+    check(store.errors == 0 && store.loads == store.evictions, "clean: a load wasn't paired with an eviction");
+  }
+}
+
+int main() {
+  testBudgetInFlight();
+  testBudgetRandom();
+  testKeepRatio();
+  testClean();
+  printf("%s\n", gPassed ? "PASSED" : "FAILED");
+  return gPassed ? 0 : 1;
+}